@@ -0,0 +1,403 @@
+/** \file
+ *  buffer_cache.c: Implementation for the buffer cache. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "buffer_cache.h"
+#include "sysgen.h"
+#include "dispatcher.h"
+
+static const char * policy_names[BCACHE_COUNT] = { "LRU", "2Q", "ARC" };
+
+const char *BCACHE_policy_name(int policy)
+{
+    return policy_names[policy];
+}
+
+/** Write-back daemon wakeup. */
+static void wb_due(TIMER * timer);
+
+BCACHE *BCACHE_new(SYSGEN * sys, int capacity, int block_size,
+                   int policy, double wb_interval)
+{
+    BCACHE * bc = calloc( 1, sizeof(BCACHE) );
+    bc->sys = sys;
+    bc->policy = policy;
+    bc->capacity = capacity;
+    bc->block_size = block_size;
+    bc->wb_interval = wb_interval;
+
+    /** Ghosts are kept for at most as many blocks again as the cache
+     *  holds, so twice the capacity bounds the number of entries. */
+    unsigned int n = 16;
+    while( n < 2 * (unsigned int)capacity )
+        n <<= 1;
+    bc->buckets = calloc( n, sizeof(BC_ENTRY*) );
+    bc->mask = n - 1;
+    TIMER_init(&bc->WB_TIMER, wb_due, bc);
+    return bc;
+}
+
+static unsigned int hash(BCACHE * bc, int disk, char * name,
+                         unsigned int block)
+{
+    unsigned long h = 5381;
+    for( ; *name; name++)
+        h = h * 33 + (unsigned char)*name;
+    h = h * 33 + disk;
+    h ^= block * 2654435761u;
+    return h & bc->mask;
+}
+
+static BC_ENTRY *lookup(BCACHE * bc, int disk, char * name,
+                        unsigned int block)
+{
+    BC_ENTRY * e = bc->buckets[hash(bc, disk, name, block)];
+    for( ; e; e = e->hnext)
+        if( e->block == block && e->disk == disk && !strcmp(e->name, name) )
+            return e;
+    return NULL;
+}
+
+static int resident(BC_ENTRY * e)
+{
+    return e->list == BC_RECENT || e->list == BC_FREQUENT;
+}
+
+static int resident_count(BCACHE * bc)
+{
+    return bc->lists[BC_RECENT].size + bc->lists[BC_FREQUENT].size;
+}
+
+/** Unlink e from its list. */
+static void unlink_entry(BCACHE * bc, BC_ENTRY * e)
+{
+    BC_LIST * l = &bc->lists[e->list];
+    if( e->prev )
+        e->prev->next = e->next;
+    else
+        l->head = e->next;
+    if( e->next )
+        e->next->prev = e->prev;
+    else
+        l->tail = e->prev;
+    l->size--;
+}
+
+/** Put e at the MRU end of list. */
+static void push_entry(BCACHE * bc, BC_ENTRY * e, int list)
+{
+    BC_LIST * l = &bc->lists[list];
+    e->list = list;
+    e->prev = NULL;
+    e->next = l->head;
+    if( l->head )
+        l->head->prev = e;
+    else
+        l->tail = e;
+    l->head = e;
+    l->size++;
+}
+
+static void move_entry(BCACHE * bc, BC_ENTRY * e, int list)
+{
+    unlink_entry(bc, e);
+    push_entry(bc, e, list);
+}
+
+/** Queue a kernel request writing e back to its disk. */
+static void writeback(BCACHE * bc, BC_ENTRY * e)
+{
+    SYSGEN * sys = bc->sys;
+    PARAMS obj = {  .CYLINDER = e->cyl,
+                    .FILE_NAME = strdup(e->name),
+                    .MEM_START = 0,
+                    .READ_WRITE = 'w',
+                    .FILE_LEN = bc->block_size,
+                    .FILE_OFF = e->block * bc->block_size };
+    DISKQ_enqueue(sys->DISKS[e->disk-1], D_NODE_new(NULL, obj));
+    DEVICE_submit(&sys->DISK_UNITS[e->disk-1]);
+    e->dirty = 0;
+    bc->dirty_n--;
+    bc->WRITEBACK_n++;
+}
+
+/** Forget e altogether. */
+static void forget(BCACHE * bc, BC_ENTRY * e)
+{
+    unlink_entry(bc, e);
+    BC_ENTRY ** link = &bc->buckets[hash(bc, e->disk, e->name, e->block)];
+    while( *link != e )
+        link = &(*link)->hnext;
+    *link = e->hnext;
+    free(e->name);
+    free(e);
+}
+
+/** Forget the LRU ghost on list. */
+static void drop_ghost(BCACHE * bc, int list)
+{
+    if( bc->lists[list].tail )
+        forget(bc, bc->lists[list].tail);
+}
+
+/** Take a resident block out of the cache, writing it back first if it is
+ *  dirty. It is remembered as a ghost on list ghost, or forgotten if ghost
+ *  is -1. */
+static void evict(BCACHE * bc, BC_ENTRY * e, int ghost)
+{
+    if( e->dirty )
+        writeback(bc, e);
+    bc->EVICT_n++;
+    if( ghost >= 0 )
+        move_entry(bc, e, ghost);
+    else
+        forget(bc, e);
+}
+
+static BC_ENTRY *create(BCACHE * bc, int disk, char * name,
+                        unsigned int block)
+{
+    BC_ENTRY * e = calloc( 1, sizeof(BC_ENTRY) );
+    e->name = strdup(name);
+    e->disk = disk;
+    e->block = block;
+    unsigned int h = hash(bc, disk, name, block);
+    e->hnext = bc->buckets[h];
+    bc->buckets[h] = e;
+    return e;
+}
+
+/** 2Q: make room for one more block. A1in gives up its oldest block to the
+ *  A1out ghosts while it is over its share, otherwise Am gives up its LRU
+ *  block. */
+static void twoq_reclaim(BCACHE * bc)
+{
+    if( resident_count(bc) < bc->capacity )
+        return;
+    int kin  = bc->capacity / 4 > 0 ? bc->capacity / 4 : 1;
+    int kout = bc->capacity / 2 > 0 ? bc->capacity / 2 : 1;
+    if(    bc->lists[BC_RECENT].size > kin
+        || bc->lists[BC_FREQUENT].size == 0 )
+    {
+        evict(bc, bc->lists[BC_RECENT].tail, BC_GHOST_RECENT);
+        if( bc->lists[BC_GHOST_RECENT].size > kout )
+            drop_ghost(bc, BC_GHOST_RECENT);
+    }
+    else
+        evict(bc, bc->lists[BC_FREQUENT].tail, -1);
+}
+
+/** ARC: evict from T1 or T2 depending on the target size of T1. in_b2 is
+ *  whether the block being brought in was a B2 ghost. */
+static void arc_replace(BCACHE * bc, int in_b2)
+{
+    if( resident_count(bc) < bc->capacity )
+        return;
+    int t1 = bc->lists[BC_RECENT].size;
+    if(    t1 > 0
+        && (   t1 > bc->arc_p
+            || (in_b2 && t1 == (int)bc->arc_p)
+            || bc->lists[BC_FREQUENT].size == 0 ) )
+        evict(bc, bc->lists[BC_RECENT].tail, BC_GHOST_RECENT);
+    else
+        evict(bc, bc->lists[BC_FREQUENT].tail, BC_GHOST_FREQUENT);
+}
+
+/** A resident block was accessed. */
+static void hit(BCACHE * bc, BC_ENTRY * e)
+{
+    if( bc->policy == BCACHE_LRU )
+        move_entry(bc, e, BC_RECENT);
+    else if( bc->policy == BCACHE_2Q ){
+        /** Blocks in A1in are not promoted by being hit again; a burst of
+         *  accesses to a new block counts once. */
+        if( e->list == BC_FREQUENT )
+            move_entry(bc, e, BC_FREQUENT);
+    }
+    else
+        move_entry(bc, e, BC_FREQUENT);
+}
+
+/** Bring a block that is not resident into the cache. e is its ghost, if
+ *  it has one. \return the resident entry. */
+static BC_ENTRY *miss(BCACHE * bc, BC_ENTRY * e, int disk, char * name,
+                      unsigned int block)
+{
+    int c = bc->capacity;
+    BC_LIST * l = bc->lists;
+
+    if( bc->policy == BCACHE_LRU ){
+        if( resident_count(bc) >= c )
+            evict(bc, l[BC_RECENT].tail, -1);
+        e = create(bc, disk, name, block);
+        push_entry(bc, e, BC_RECENT);
+    }
+    else if( bc->policy == BCACHE_2Q ){
+        /** A block missed again while remembered in A1out goes to Am.
+         *  Take the ghost off A1out first so reclaiming can't forget it. */
+        if( e ){
+            unlink_entry(bc, e);
+            twoq_reclaim(bc);
+            push_entry(bc, e, BC_FREQUENT);
+        }
+        else{
+            twoq_reclaim(bc);
+            e = create(bc, disk, name, block);
+            push_entry(bc, e, BC_RECENT);
+        }
+    }
+    else if( e ){
+        /** ARC ghost hit: grow the target of the side that would have
+         *  kept the block. */
+        int b1 = l[BC_GHOST_RECENT].size;
+        int b2 = l[BC_GHOST_FREQUENT].size;
+        int in_b2 = e->list == BC_GHOST_FREQUENT;
+        if( !in_b2 ){
+            bc->arc_p += b1 >= b2 ? 1 : (double)b2 / b1;
+            if( bc->arc_p > c )
+                bc->arc_p = c;
+        }
+        else{
+            bc->arc_p -= b2 >= b1 ? 1 : (double)b1 / b2;
+            if( bc->arc_p < 0 )
+                bc->arc_p = 0;
+        }
+        arc_replace(bc, in_b2);
+        move_entry(bc, e, BC_FREQUENT);
+    }
+    else{
+        int t1 = l[BC_RECENT].size;
+        int b1 = l[BC_GHOST_RECENT].size;
+        int total = t1 + l[BC_FREQUENT].size + b1 + l[BC_GHOST_FREQUENT].size;
+        if( t1 + b1 >= c ){
+            if( t1 < c ){
+                drop_ghost(bc, BC_GHOST_RECENT);
+                arc_replace(bc, 0);
+            }
+            else
+                evict(bc, l[BC_RECENT].tail, -1);
+        }
+        else if( total >= c ){
+            if( total >= 2 * c )
+                drop_ghost(bc, BC_GHOST_FREQUENT);
+            arc_replace(bc, 0);
+        }
+        e = create(bc, disk, name, block);
+        push_entry(bc, e, BC_RECENT);
+    }
+    return e;
+}
+
+/** Access one block, bringing it in if it is not resident. */
+static BC_ENTRY *access_block(BCACHE * bc, int disk, char * name,
+                              unsigned int block)
+{
+    BC_ENTRY * e = lookup(bc, disk, name, block);
+    if( e && resident(e) ){
+        hit(bc, e);
+        return e;
+    }
+    return miss(bc, e, disk, name, block);
+}
+
+/** First and last block a request touches. */
+static void block_range(BCACHE * bc, PARAMS * params,
+                        unsigned int * first, unsigned int * last)
+{
+    unsigned int len = params->FILE_LEN > 0 ? params->FILE_LEN : 1;
+    *first = params->FILE_OFF / bc->block_size;
+    *last  = (params->FILE_OFF + len - 1) / bc->block_size;
+}
+
+int BCACHE_absorb(BCACHE * bc, int disk, D_NODE * req)
+{
+    PARAMS * params = &req->PROCESS_PARAMS;
+    unsigned int first, last;
+    block_range(bc, params, &first, &last);
+
+    if( params->READ_WRITE == 'w' ){
+        for(unsigned int b = first; b <= last; b++){
+            BC_ENTRY * e = access_block(bc, disk, params->FILE_NAME, b);
+            e->cyl = params->CYLINDER;
+            if( !e->dirty ){
+                e->dirty = 1;
+                bc->dirty_n++;
+            }
+        }
+        bc->WRITE_n++;
+        if( bc->dirty_n > 0 && !TIMER_armed(&bc->WB_TIMER) )
+            TWHEEL_arm(bc->sys->TIMERS, &bc->WB_TIMER,
+                       ms_to_ticks(bc->sys->clock + bc->wb_interval));
+        return 1;
+    }
+
+    /** A read is served from the cache only if every block is there;
+     *  otherwise the whole request goes to the disk and its blocks are
+     *  cached when it completes. */
+    int all = 1;
+    for(unsigned int b = first; b <= last; b++){
+        BC_ENTRY * e = lookup(bc, disk, params->FILE_NAME, b);
+        if( e && resident(e) )
+            bc->HIT_n++;
+        else{
+            bc->MISS_n++;
+            all = 0;
+        }
+    }
+    bc->READ_n++;
+    if( !all )
+        return 0;
+
+    for(unsigned int b = first; b <= last; b++)
+        hit(bc, lookup(bc, disk, params->FILE_NAME, b));
+    bc->READ_HIT_n++;
+    return 1;
+}
+
+void BCACHE_fill(BCACHE * bc, int disk, D_NODE * req)
+{
+    PARAMS * params = &req->PROCESS_PARAMS;
+    if( params->READ_WRITE != 'r' )
+        return;
+    unsigned int first, last;
+    block_range(bc, params, &first, &last);
+    for(unsigned int b = first; b <= last; b++){
+        BC_ENTRY * e = access_block(bc, disk, params->FILE_NAME, b);
+        e->cyl = params->CYLINDER;
+    }
+}
+
+/** Write back every dirty block. */
+static void wb_due(TIMER * timer)
+{
+    BCACHE * bc = timer->arg;
+    int n = 0;
+    for(int l = BC_RECENT; l <= BC_FREQUENT; l++)
+        for(BC_ENTRY * e = bc->lists[l].head; e; e = e->next)
+            if( e->dirty ){
+                writeback(bc, e);
+                n++;
+            }
+    if( n > 0 ){
+        charge_system(bc->sys, bc->sys->io_entry_cost);
+        printf("Write-back daemon: %d block(s) flushed.\n", n);
+    }
+}
+
+void BCACHE_free(BCACHE * bc)
+{
+    TWHEEL_cancel(bc->sys->TIMERS, &bc->WB_TIMER);
+    for(unsigned int i = 0; i <= bc->mask; i++){
+        BC_ENTRY * e = bc->buckets[i];
+        while( e ){
+            BC_ENTRY * next = e->hnext;
+            free(e->name);
+            free(e);
+            e = next;
+        }
+    }
+    free(bc->buckets);
+    free(bc);
+}
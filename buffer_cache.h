@@ -0,0 +1,122 @@
+/** \file
+ *  buffer_cache.h: Interface for the buffer cache (BCACHE) in front of the
+ *                  disks.
+ *
+ *                  The cache holds disk blocks keyed by (disk, file name,
+ *                  block number). Block size is the page size, and the
+ *                  frames the cache lives in are taken out of main memory
+ *                  at sysgen, so whatever the cache gets is not available
+ *                  to processes.
+ *
+ *                  A disk read whose blocks are all cached completes
+ *                  without disk I/O; otherwise it goes to the disk and the
+ *                  blocks are cached when it completes. Disk writes are
+ *                  absorbed into the cache as dirty blocks and complete
+ *                  right away. A write-back daemon flushes dirty blocks
+ *                  every write-back interval, and a dirty block that is
+ *                  evicted is written back on the spot. Write-backs are
+ *                  kernel requests: D_NODE's with no PCB.
+ *
+ *                  Eviction policies:
+ *                  LRU     Least recently used.
+ *                  2Q      New blocks enter a FIFO (A1in, a quarter of the
+ *                          cache). Blocks pushed out of it are remembered
+ *                          in a ghost list (A1out), and only a block that
+ *                          is missed again while remembered is promoted
+ *                          to the main LRU (Am). One-off scans don't flush
+ *                          the working set.
+ *                  ARC     Adaptive replacement: recency (T1) and frequency
+ *                          (T2) lists with ghost lists (B1, B2) of their
+ *                          evictions. Ghost hits move the target size of T1
+ *                          towards whichever side would have hit. */
+
+#ifndef BUFFER_CACHE_H_
+#define BUFFER_CACHE_H_
+
+#include "device_node.h"
+#include "timer_wheel.h"
+
+/** Eviction policy numbers, as entered at sysgen. */
+#define BCACHE_LRU      0
+#define BCACHE_2Q       1
+#define BCACHE_ARC      2
+#define BCACHE_COUNT    3
+
+/** Lists. Resident blocks are on RECENT or FREQUENT, ghosts (keys of
+ *  evicted blocks, no data) on the GHOST lists. LRU only uses RECENT; 2Q
+ *  uses RECENT as A1in, FREQUENT as Am and GHOST_RECENT as A1out. */
+#define BC_RECENT           0
+#define BC_FREQUENT         1
+#define BC_GHOST_RECENT     2
+#define BC_GHOST_FREQUENT   3
+#define BC_LISTS            4
+
+struct SYSGEN;
+
+/** Cache entry. */
+typedef struct BC_ENTRY {
+    struct BC_ENTRY *   hnext;      // Hash chain.
+    struct BC_ENTRY *   prev;       // List links, MRU end is the head.
+    struct BC_ENTRY *   next;
+    char            *   name;       // File name.
+    int                 disk;       // Disk number.
+    unsigned int        block;      // Block number within the file.
+    int                 list;       // BC_* list the entry is on.
+    int                 dirty;      // 1 if it has to be written back.
+    int                 cyl;        // Cylinder to write it back to.
+} BC_ENTRY;
+
+typedef struct BC_LIST {
+    BC_ENTRY        *   head;
+    BC_ENTRY        *   tail;
+    int                 size;
+} BC_LIST;
+
+/** BCACHE struct. */
+typedef struct BCACHE {
+    struct SYSGEN   *   sys;
+    int                 policy;         // BCACHE_* policy number.
+    int                 capacity;       // Resident blocks.
+    int                 block_size;     // Bytes per block.
+    double              wb_interval;    // Write-back daemon period, ms.
+    BC_ENTRY        **  buckets;        // Hash table.
+    unsigned int        mask;           // Bucket count - 1.
+    BC_LIST             lists[BC_LISTS];
+    double              arc_p;          // ARC target size of RECENT.
+    int                 dirty_n;        // Dirty resident blocks.
+    TIMER               WB_TIMER;       // Write-back daemon wakeup.
+
+    /** Statistics */
+    long                HIT_n;          // Block lookups that hit.
+    long                MISS_n;         // Block lookups that missed.
+    long                READ_HIT_n;     // Reads served from the cache.
+    long                READ_n;         // Reads looked up.
+    long                WRITE_n;        // Writes absorbed.
+    long                WRITEBACK_n;    // Blocks written back.
+    long                EVICT_n;        // Resident blocks evicted.
+} BCACHE;
+
+/** Generate and return a BCACHE for sys.
+ *  \param  capacity is the number of resident blocks.
+ *  \param  block_size is the block size in bytes.
+ *  \param  policy is a BCACHE_* policy number.
+ *  \param  wb_interval is the write-back daemon period in ms. */
+BCACHE *BCACHE_new(struct SYSGEN * sys, int capacity, int block_size,
+                   int policy, double wb_interval);
+
+/** Offer a request on disk number disk to the cache.
+ *  \return 1 if the cache dealt with it (a read that hit every block, or a
+ *          write, which is absorbed); the request then needs no disk I/O.
+ *  \return 0 if it has to go to the disk. */
+int BCACHE_absorb(BCACHE * bc, int disk, D_NODE * req);
+
+/** A read on disk number disk completed; cache the blocks it read. */
+void BCACHE_fill(BCACHE * bc, int disk, D_NODE * req);
+
+/** \return the name of a BCACHE_* policy number. */
+const char *BCACHE_policy_name(int policy);
+
+/** Free the BCACHE. Dirty blocks are dropped. */
+void BCACHE_free(BCACHE * bc);
+
+#endif
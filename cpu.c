@@ -7,7 +7,12 @@
 PROCESSOR * PROCESSOR_new()
 {
     PROCESSOR *new_cpu = malloc (sizeof(PROCESSOR) ); 
-    *new_cpu = (PROCESSOR){ .RUNNING_PROCESS = NULL }; 
+    *new_cpu = (PROCESSOR){ .RUNNING_PROCESS = NULL,
+                            .MARK = 0,
+                            .LAST_PID = 0,
+                            .BUSY_t = 0,
+                            .SLICE_OVER = 0 }; 
+    TIMER_init(&new_cpu->SLICE_TIMER, NULL, NULL);
     return new_cpu; 
 }
 
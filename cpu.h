@@ -5,10 +5,20 @@
 #define CPU_
 
 #include "pcb.h"
+#include "timer_wheel.h"
 
 /** The CPU contains a pointer to a PCB. */ 
 typedef struct PROCESSOR {
     PCB *   RUNNING_PROCESS;
+    double  MARK;               // Clock time up to which RUNNING_PROCESS
+                                //   has been charged for CPU time. Set 
+                                //   ahead of the clock while a context 
+                                //   switch is still in progress.
+    int     LAST_PID;           // PID of the last process to run here.
+    double  BUSY_t;             // CPU time charged to processes.
+    int     SLICE_OVER;         // Set when the policy reports that the
+                                //   running process' slice has expired.
+    TIMER   SLICE_TIMER;        // Fires at the end of the time slice.
 } PROCESSOR;
 
 /** Return a pointer to a new PROCESSOR object. */
@@ -0,0 +1,282 @@
+/** \file
+ *  device.c:   Implementation for DEVICE objects. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "device.h"
+#include "sysgen.h"
+#include "dispatcher.h"
+#include "interrupts.h"
+
+/** Completion timer callback: the request in a slot is done. */
+static void service_done(TIMER * timer)
+{
+    IO_SLOT * slot = timer->arg;
+    DEVICE * dev = slot->dev;
+    if( slot->PID < 0 )
+        printf("Device interrupt: %c%d finished kernel request.\n",
+                dev->KIND, dev->NUM);
+    else
+        printf("Device interrupt: %c%d finished request of PID %d.\n",
+                dev->KIND, dev->NUM, slot->PID);
+    device_completion(dev->sys, dev->KIND, dev->NUM, slot - dev->SLOTS);
+}
+
+void DEVICE_init(DEVICE * dev, SYSGEN * sys, char kind, int num,
+                 int channels, int qd)
+{
+    *dev = (DEVICE){    .KIND = kind,
+                        .NUM = num,
+                        .sys = sys,
+                        .QD = qd,
+                        .ACTIVE = 0,
+                        .CHANNELS = channels,
+                        .HEAD_CYL = 1 };
+    dev->SLOTS = malloc( sizeof(IO_SLOT) * qd );
+    for(int i = 0; i < qd; i++){
+        dev->SLOTS[i] = (IO_SLOT){ .dev = dev, .REQ = NULL };
+        TIMER_init(&dev->SLOTS[i].COMPLETION, service_done, &dev->SLOTS[i]);
+    }
+    dev->CHAN_FREE = calloc( channels, sizeof(double) );
+    dev->CHAN_WRITES = calloc( channels, sizeof(long) );
+}
+
+void DEVICE_free(DEVICE * dev)
+{
+    free(dev->SLOTS);
+    free(dev->CHAN_FREE);
+    free(dev->CHAN_WRITES);
+}
+
+DEVICE *DEVICE_lookup(SYSGEN * sys, char kind, long num)
+{
+    if( kind == DEVICE_PRINTER )
+        return &sys->PRINTER_UNITS[num-1];
+    else if( kind == DEVICE_DISK )
+        return &sys->DISK_UNITS[num-1];
+    else
+        return &sys->FLASH_UNITS[num-1];
+}
+
+static D_NODE *queue_head(DEVICE * dev)
+{
+    SYSGEN * sys = dev->sys;
+    if( dev->KIND == DEVICE_PRINTER )
+        return sys->PRINTERS[dev->NUM-1]->head;
+    else if( dev->KIND == DEVICE_DISK )
+        return sys->DISKS[dev->NUM-1]->head;
+    else
+        return sys->FLASHDRIVES[dev->NUM-1]->head;
+}
+
+/** \return the first request in queue order that is not in service yet.
+ *  Requests are admitted in queue order, so this only steps over the ones
+ *  in service. The DISKQ is circular, hence the check for the head. */
+static D_NODE *first_waiting(DEVICE * dev)
+{
+    D_NODE * head = queue_head(dev);
+    D_NODE * ptr = head;
+    while( ptr ){
+        if( ptr->SLOT < 0 )
+            return ptr;
+        ptr = ptr->LINK;
+        if( ptr == head )
+            break;
+    }
+    return NULL;
+}
+
+/** Channel holding a file, for flash reads. */
+static int file_channel(DEVICE * dev, char * name)
+{
+    unsigned long hash = 5381;
+    for( ; name && *name; name++)
+        hash = hash * 33 + (unsigned char)*name;
+    return hash % dev->CHANNELS;
+}
+
+/** Channel that frees up first. */
+static int idle_channel(DEVICE * dev)
+{
+    int best = 0;
+    for(int c = 1; c < dev->CHANNELS; c++)
+        if( dev->CHAN_FREE[c] < dev->CHAN_FREE[best] )
+            best = c;
+    return best;
+}
+
+/** Fill in the channel, start and completion time of slot's request from
+ *  the device class' model. The channel is busy until then. */
+static void model_service(DEVICE * dev, IO_SLOT * slot)
+{
+    SYSGEN * sys = dev->sys;
+    PARAMS * params = &slot->REQ->PROCESS_PARAMS;
+    double len = params->FILE_LEN;
+    double service;
+
+    if( dev->KIND == DEVICE_PRINTER ){
+        slot->CHANNEL = 0;
+        service = 1000 * len / sys->prn_rate;
+    }
+    else if( dev->KIND == DEVICE_FLASH ){
+        if( params->READ_WRITE == 'w' ){
+            slot->CHANNEL = idle_channel(dev);
+            service = sys->flash_wr_lat + len / sys->flash_rate;
+            long writes = ++dev->CHAN_WRITES[slot->CHANNEL];
+            if( sys->flash_gc_every > 0 && writes % sys->flash_gc_every == 0 ){
+                service += sys->flash_gc_stall;
+                dev->GC_n++;
+            }
+        }
+        else{
+            slot->CHANNEL = file_channel(dev, params->FILE_NAME);
+            service = sys->flash_rd_lat + len / sys->flash_rate;
+        }
+    }
+    else{
+        slot->CHANNEL = 0;
+        int cyl = params->CYLINDER;
+        service = sys->disk_seek * abs(cyl - dev->HEAD_CYL) + sys->disk_rot
+                + len / sys->disk_rate;
+        dev->SEEK_n += abs(cyl - dev->HEAD_CYL);
+        dev->HEAD_CYL = cyl;
+    }
+
+    dev->BYTES += len;
+    double * chan_free = &dev->CHAN_FREE[slot->CHANNEL];
+    slot->START = *chan_free > sys->clock ? *chan_free : sys->clock;
+    slot->DONE  = slot->START + service;
+    *chan_free  = slot->DONE;
+}
+
+/** Admit waiting requests while there are free slots. */
+static void admit(DEVICE * dev)
+{
+    SYSGEN * sys = dev->sys;
+    while( dev->ACTIVE < dev->QD ){
+        D_NODE * req = first_waiting(dev);
+        if( req == NULL )
+            return;
+
+        int i = 0;
+        while( dev->SLOTS[i].REQ )
+            i++;
+        IO_SLOT * slot = &dev->SLOTS[i];
+        slot->REQ = req;
+        slot->PID = req->D_PCB ? req->D_PCB->PID : -1;
+        req->SLOT = i;
+        dev->ACTIVE++;
+        model_service(dev, slot);
+
+        if( sys->IO_AUTO ){
+            uint64_t expires = ms_to_ticks(slot->DONE);
+            if( expires <= ms_to_ticks(sys->clock) )
+                expires = ms_to_ticks(sys->clock) + 1;
+            TWHEEL_arm(sys->TIMERS, &slot->COMPLETION, expires);
+        }
+    }
+}
+
+/** Channel time slot's request has had so far. */
+static double busy_so_far(DEVICE * dev, IO_SLOT * slot)
+{
+    double now = dev->sys->clock;
+    double end = now < slot->DONE ? now : slot->DONE;
+    return end > slot->START ? end - slot->START : 0;
+}
+
+/** Take a request out of service. A channel whose request ends early is
+ *  free again from now on. */
+static void release(DEVICE * dev, IO_SLOT * slot)
+{
+    double now = dev->sys->clock;
+    dev->BUSY_t += busy_so_far(dev, slot);
+    if( dev->CHAN_FREE[slot->CHANNEL] == slot->DONE && slot->DONE > now )
+        dev->CHAN_FREE[slot->CHANNEL] = now;
+    TWHEEL_cancel(dev->sys->TIMERS, &slot->COMPLETION);
+    slot->REQ = NULL;
+    dev->ACTIVE--;
+}
+
+/** Fold the current depth into the depth integral up to now, and record
+ *  a request leaving. */
+static void account_depth(DEVICE * dev, int delta)
+{
+    double now = dev->sys->clock;
+    dev->DEPTH_AREA += dev->DEPTH * (now - dev->MARK);
+    dev->MARK = now;
+    dev->DEPTH += delta;
+    if( delta < 0 )
+        dev->LEFT_n++;
+}
+
+void DEVICE_submit(DEVICE * dev)
+{
+    account_depth(dev, 1);
+    admit(dev);
+}
+
+int DEVICE_next_done(DEVICE * dev)
+{
+    int best = -1;
+    for(int i = 0; i < dev->QD; i++)
+        if( dev->SLOTS[i].REQ
+            && (best < 0 || dev->SLOTS[i].DONE < dev->SLOTS[best].DONE) )
+            best = i;
+    return best;
+}
+
+PCB *DEVICE_complete(DEVICE * dev, int i)
+{
+    SYSGEN * sys = dev->sys;
+    IO_SLOT * slot = &dev->SLOTS[i];
+    D_NODE * req = slot->REQ;
+    release(dev, slot);
+
+    /** Disks serve one request at a time, always the head of the C-LOOK
+     *  queue. The other queues can unlink from anywhere. */
+    PCB * pcb;
+    if( dev->KIND == DEVICE_DISK )
+        DISKQ_dequeue(sys->DISKS[dev->NUM-1], &pcb);
+    else if( dev->KIND == DEVICE_PRINTER )
+        DEVICEQ_remove(sys->PRINTERS[dev->NUM-1], req, &pcb);
+    else
+        DEVICEQ_remove(sys->FLASHDRIVES[dev->NUM-1], req, &pcb);
+
+    account_depth(dev, -1);
+    dev->DONE_n++;
+    admit(dev);
+    return pcb;
+}
+
+void DEVICE_killed(DEVICE * dev, int slot)
+{
+    if( slot >= 0 )
+        release(dev, &dev->SLOTS[slot]);
+    account_depth(dev, -1);
+    admit(dev);
+}
+
+double DEVICE_utilization(DEVICE * dev)
+{
+    double now = dev->sys->clock;
+    double busy = dev->BUSY_t;
+    for(int i = 0; i < dev->QD; i++)
+        if( dev->SLOTS[i].REQ )
+            busy += busy_so_far(dev, &dev->SLOTS[i]);
+    return now > 0 ? busy / (now * dev->CHANNELS) : 0;
+}
+
+double DEVICE_avg_depth(DEVICE * dev)
+{
+    double now = dev->sys->clock;
+    double area = dev->DEPTH_AREA + dev->DEPTH * (now - dev->MARK);
+    return now > 0 ? area / now : 0;
+}
+
+double DEVICE_avg_response(DEVICE * dev)
+{
+    double now = dev->sys->clock;
+    double area = dev->DEPTH_AREA + dev->DEPTH * (now - dev->MARK);
+    return dev->LEFT_n > 0 ? area / dev->LEFT_n : 0;
+}
@@ -0,0 +1,131 @@
+/** \file
+ *  device.h:   Interface for DEVICE objects, the service side of an I/O
+ *              device. The queues (DEVICEQ, DISKQ) only order requests;
+ *              the DEVICE keeps track of which requests are in service, how
+ *              long they take, and how busy the device has been.
+ *
+ *              A device has a queue depth of QD service slots and CHANNELS
+ *              units that work in parallel. Requests are admitted to a free
+ *              slot in queue order; each admitted request is given a
+ *              channel, and a channel works on one request at a time.
+ *              Printers and disks have one slot and one channel, so the
+ *              request in service is simply the head of the queue. Flash
+ *              drives can have many of both, so several requests are in
+ *              service at once and they may complete out of order.
+ *
+ *              Service time comes from the device class' model:
+ *
+ *              printer     FILE_LEN / throughput.
+ *              flash       Read or write latency, plus FILE_LEN over the
+ *                          transfer rate. Reads go to the channel holding
+ *                          the file, writes to whichever channel frees up
+ *                          first. Every so many writes a channel stalls for
+ *                          garbage collection.
+ *              disk        Seek proportional to the distance the arm moves
+ *                          from the last cylinder served, plus rotational
+ *                          latency, plus FILE_LEN over the transfer rate.
+ *
+ *              With automatic completions turned on at sysgen, each slot
+ *              arms a timer for the modelled completion time and the
+ *              completion goes through the same path as a P#, F# or D#
+ *              interrupt. Manual interrupts keep working either way; they
+ *              complete the request due first. */
+
+#ifndef DEVICE_H_
+#define DEVICE_H_
+
+#include "device_node.h"
+#include "timer_wheel.h"
+
+/** Device classes, named after their command letters. */
+#define DEVICE_PRINTER  'p'
+#define DEVICE_DISK     'd'
+#define DEVICE_FLASH    'f'
+
+struct SYSGEN;
+struct DEVICE;
+
+/** Service slot, holding one request in service. */
+typedef struct IO_SLOT {
+    struct DEVICE * dev;            // Device the slot belongs to.
+    D_NODE      *   REQ;            // Request in service, NULL if free.
+    int             PID;            // PID of the requesting process, -1
+                                    //   for a kernel request.
+    int             CHANNEL;        // Channel working on REQ.
+    double          START;          // Clock when the channel starts on REQ.
+    double          DONE;           // Modelled completion time.
+    TIMER           COMPLETION;     // Fires at DONE.
+} IO_SLOT;
+
+/** DEVICE struct. */
+typedef struct DEVICE {
+    char            KIND;           // DEVICE_PRINTER, _DISK or _FLASH.
+    int             NUM;            // Device number, counting from 1.
+    struct SYSGEN * sys;            // System the device belongs to.
+
+    int             QD;             // Queue depth: number of service slots.
+    IO_SLOT     *   SLOTS;
+    int             ACTIVE;         // Slots in use.
+    int             CHANNELS;       // Parallel channels.
+    double      *   CHAN_FREE;      // Clock when each channel is free.
+    long        *   CHAN_WRITES;    // Writes on each channel, for GC.
+    int             HEAD_CYL;       // Disk arm position.
+
+    /** Statistics */
+    int             DEPTH;          // Queued requests, including the ones
+                                    //   in service.
+    double          MARK;           // Clock of the last change in DEPTH.
+    double          DEPTH_AREA;     // Integral of DEPTH over time.
+    double          BUSY_t;         // Channel time spent servicing.
+    long            DONE_n;         // Completed requests.
+    long            LEFT_n;         // Requests that left the queue,
+                                    //   completed or killed.
+    long            GC_n;           // Garbage collection stalls.
+    long            SEEK_n;         // Cylinders the disk arm has moved.
+    double          BYTES;          // Bytes transferred.
+} DEVICE;
+
+/** Initialize a DEVICE of class kind and number num belonging to sys.
+ *  \param  channels is the number of parallel channels.
+ *  \param  qd is the number of requests that can be in service at once. */
+void DEVICE_init(DEVICE * dev, struct SYSGEN * sys, char kind, int num,
+                 int channels, int qd);
+
+/** Release the slot and channel arrays of a DEVICE. */
+void DEVICE_free(DEVICE * dev);
+
+/** \return the DEVICE for a device class and number. */
+DEVICE *DEVICE_lookup(struct SYSGEN * sys, char kind, long num);
+
+/** A request was queued on the device. Admits it to service if a slot is
+ *  free. */
+void DEVICE_submit(DEVICE * dev);
+
+/** \return the slot whose request is due first, -1 if the device is
+ *  idle. */
+int DEVICE_next_done(DEVICE * dev);
+
+/** Complete the request in service in slot, unlinking it from the device
+ *  queue and admitting the next waiting request.
+ *  \return the PCB of the process that made the request, NULL for a 
+ *          kernel request. */
+PCB *DEVICE_complete(DEVICE * dev, int slot);
+
+/** A request was killed off the device queue. Frees the slot it was in 
+ *  service in, if any.
+ *  \param  slot is the slot the kill reported, -1 for a request that was
+ *          still waiting. */
+void DEVICE_killed(DEVICE * dev, int slot);
+
+/** \return fraction of the elapsed channel time the device has been
+ *  busy. */
+double DEVICE_utilization(DEVICE * dev);
+
+/** \return time averaged number of queued requests. */
+double DEVICE_avg_depth(DEVICE * dev);
+
+/** \return mean time a request spends on the device, queueing included,
+ *  by Little's law (average depth over departure rate). */
+double DEVICE_avg_response(DEVICE * dev);
+
+#endif
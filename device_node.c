@@ -11,7 +11,12 @@ D_NODE *D_NODE_new(PCB * insert, PARAMS pcb_params)
     D_NODE *new_D_NODE = malloc( sizeof(D_NODE) );
     *new_D_NODE = (D_NODE){ .D_PCB = insert, 
                             .PROCESS_PARAMS = pcb_params,
-                            .LINK = NULL};
+                            .LINK = NULL,
+                            .PREV = NULL,
+                            .SLOT = -1,
+                            .SWAP = 0,
+                            .VOL = 0,
+                            .RA_GEN = 0};
     return new_D_NODE;
 }
 
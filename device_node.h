@@ -3,7 +3,11 @@
  *                  queued up in the DEVICEQ's and DISKQ's. 
  *                  Contains a pointer to a PCB and a PARAMS struct which 
  *                  contains syscall params for the process, as well as a 
- *                  pointer field for the next possible D_NODE in a queue. */
+ *                  pointer field for the next possible D_NODE in a queue. 
+ *                  DEVICEQ's also keep a back link, so a request that 
+ *                  completes out of order can be unlinked in O(1). 
+ *                  Requests the kernel makes on its own behalf (buffer 
+ *                  cache write-backs) have no PCB. */
 
 #ifndef DEVICE_NODE_
 #define DEVICE_NODE_
@@ -17,6 +21,7 @@ typedef struct PARAMS {
     unsigned int        MEM_START;      // Starting location in memory.
     char                READ_WRITE;     // Read or Write character.
     unsigned int        FILE_LEN;       // File length.
+    unsigned int        FILE_OFF;       // Offset into the file.
 } PARAMS;
 
 /** Device node. */
@@ -24,6 +29,21 @@ typedef struct D_NODE {
     PCB             *   D_PCB;              // Pointer to PCB.
     PARAMS              PROCESS_PARAMS;     // Process system call parameters.
     struct D_NODE   *   LINK;               // Link to next D_NODE.
+    struct D_NODE   *   PREV;               // Link to previous D_NODE
+                                            //   (DEVICEQ only).
+    int                 SLOT;               // Device service slot, -1 while
+                                            //   waiting to be serviced.
+    int                 SWAP;               // 1 for paging to and from swap,
+                                            //   which bypasses the buffer
+                                            //   cache.
+    int                 VOL;                // 1 for a piece of a volume
+                                            //   request. Its file range is
+                                            //   in the volume's file system,
+                                            //   so it bypasses the buffer
+                                            //   cache and readahead too.
+    long                RA_GEN;             // Readahead stream generation
+                                            //   of a prefetch, see
+                                            //   readahead.h.
 } D_NODE;
 
 /** Generate and return a pointer to a new D_NODE. 
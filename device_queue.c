@@ -5,12 +5,16 @@ DEVICEQ *DEVICEQ_new()
 {
     DEVICEQ * dq = malloc( sizeof(DEVICEQ) );
     *dq = (DEVICEQ){  .head = NULL, 
-                      .tail = NULL};
+                      .tail = NULL,
+                      .count = 0,
+                      .BYTES = 0};
     return dq;
 }
 
 void DEVICEQ_enqueue(DEVICEQ * dq, D_NODE *insert)
 {
+    insert->LINK = NULL;
+    insert->PREV = dq->tail;
     if( DEVICEQ_empty(dq) )
         dq->head = insert;
     else
@@ -19,29 +23,14 @@ void DEVICEQ_enqueue(DEVICEQ * dq, D_NODE *insert)
 
     // Set the tail of the ready queue to point to the new D_NODE.
     dq->tail = insert;
+    dq->count++;
+    dq->BYTES += insert->PROCESS_PARAMS.FILE_LEN;
 }
 
 void DEVICEQ_dequeue(DEVICEQ * dq, PCB** dequeued )
 {
     if( !DEVICEQ_empty(dq) )
-    {
-        /* Return PCB into dequeued. */
-        *dequeued = dq->head->D_PCB;
-        /** Is there only one D_NODE in the queue? */
-        if( dq->head == dq->tail ){
-            D_NODE_free(dq->head);
-            dq->head = NULL;
-            dq->tail = NULL;
-        }
-        /** If not, save the head value, iterate it to point to the next 
-         *  node queued up, and release the original head. */
-        else{
-            D_NODE * free_node = dq->head;
-            dq->head = dq->head->LINK;
-            D_NODE_free(free_node);
-        }
-        (*dequeued)->LINK = NULL;
-    }
+        DEVICEQ_remove(dq, dq->head, dequeued);
     else
         /** If the DEVICEQ is empty (Although it is technically not possible
          *  to get to this point of code in such a case, I think), then 
@@ -49,50 +38,38 @@ void DEVICEQ_dequeue(DEVICEQ * dq, PCB** dequeued )
         *dequeued = NULL;
 }
 
-void DEVICEQ_kill(DEVICEQ * dq, PCB ** dequeued, int pid)
+void DEVICEQ_remove(DEVICEQ * dq, D_NODE * node, PCB ** removed)
 {
-    if( dq->head == NULL ){
-        *dequeued = NULL;
-        return;
-    }
-    else{
-        if( dq->head->D_PCB->PID == pid ){
-            *dequeued = dq->head->D_PCB;
-            if( dq->head == dq->tail ){
-                D_NODE_free(dq->head);
-                dq->head = dq->tail = NULL;
-            }
-            else{
-                dq->head = dq->head->LINK;
-                dq->tail->LINK = NULL;
-            }
-            (*dequeued)->LINK = NULL;
-        }
-        else{
-            D_NODE * curr_ptr = dq->head;
-            while( curr_ptr->LINK ){
-                if( curr_ptr->LINK->D_PCB->PID == pid ){
-                    *dequeued = curr_ptr->LINK->D_PCB;
-                    if( curr_ptr->LINK == dq->tail ){
-                        dq->tail = curr_ptr;
-                        curr_ptr->LINK = NULL;
-                    }
-                    else{
-                       curr_ptr->LINK = curr_ptr->LINK->LINK;
-                    }
-                    (*dequeued)->LINK = NULL;
-                    return;
-                }
-                else
-                    curr_ptr = curr_ptr->LINK;
-            }
-            if( curr_ptr->LINK == NULL )
-                *dequeued = NULL;
-        }
-    }
+    /** Return PCB into removed. */
+    *removed = node->D_PCB;
 
+    if( node->PREV )
+        node->PREV->LINK = node->LINK;
+    else
+        dq->head = node->LINK;
+    if( node->LINK )
+        node->LINK->PREV = node->PREV;
+    else
+        dq->tail = node->PREV;
 
+    dq->count--;
+    dq->BYTES -= node->PROCESS_PARAMS.FILE_LEN;
+    D_NODE_free(node);
+    if( *removed )
+        (*removed)->LINK = NULL;
+}
 
+int DEVICEQ_kill(DEVICEQ * dq, PCB ** dequeued, int pid)
+{
+    for( D_NODE * curr_ptr = dq->head; curr_ptr; curr_ptr = curr_ptr->LINK ){
+        if( curr_ptr->D_PCB && curr_ptr->D_PCB->PID == pid ){
+            int slot = curr_ptr->SLOT;
+            DEVICEQ_remove(dq, curr_ptr, dequeued);
+            return slot;
+        }
+    }
+    *dequeued = NULL;
+    return -1;
 }
 
 int DEVICEQ_empty(DEVICEQ * dq)
@@ -109,7 +86,7 @@ void DEVICEQ_free(DEVICEQ * dq)
     D_NODE * prev_ptr = dq->head;
     while( curr_ptr ){
         curr_ptr = curr_ptr->LINK;
-        PCB_free(prev_ptr->D_PCB);
+        PCB_io_release(prev_ptr->D_PCB);
         D_NODE_free(prev_ptr);
         prev_ptr = curr_ptr;
     }
@@ -1,6 +1,8 @@
 /** \file
  *  device_queue.h: Interface for DEVICEQ object. FIFO queue storing 
- *  D_NODES, defined in device_node.h. */
+ *  D_NODES, defined in device_node.h. The queue is doubly linked so that
+ *  devices serving several requests at once can retire any of them in 
+ *  O(1). */
 
 #ifndef DEVICE_QUEUE_H_
 #define DEVICE_QUEUE_H_
@@ -11,6 +13,8 @@
 typedef struct DEVICEQ {
     D_NODE * head;
     D_NODE * tail;
+    int      count;     // Queued requests,
+    long     BYTES;     //   and their file lengths summed.
 } DEVICEQ;
 
 /** \return pointer to DEVICEQ struct. */
@@ -28,7 +32,16 @@ void DEVICEQ_enqueue(DEVICEQ * dq, D_NODE* insert);
             deallocated. */
 void DEVICEQ_dequeue(DEVICEQ * dq, PCB** dequeued);
 
-void DEVICEQ_kill(DEVICEQ * dq, PCB ** dequeued, int pid);
+/** Unlink a D_NODE from anywhere in the queue in O(1).
+    \param  node is a D_NODE queued on dq. Its PCB is passed into removed
+            and the D_NODE is deallocated. */
+void DEVICEQ_remove(DEVICEQ * dq, D_NODE * node, PCB ** removed);
+
+/** Remove the request of process pid from the queue, if it has one. Its 
+    PCB is passed into dequeued, NULL if not found.
+    \return the service slot the request held, -1 if it wasn't in 
+            service. */
+int DEVICEQ_kill(DEVICEQ * dq, PCB ** dequeued, int pid);
 
 /** Test for DEVICEQ emptiness. 
     \param  dq is a pointer to a DEVICEQ object which was dynamically
@@ -42,7 +55,8 @@ int DEVICEQ_empty(DEVICEQ * dq);
     \param  dq is a pointer to a DEVICEQ object which was created with a call to
             DEVICEQ_new(). Since there is no mechanism/need to handle the case
             where we want to free a device queue but save the PCB's, this call
-            to free deallocates any PCB's stored on the device queue. */
+            to free deallocates any PCB's stored on the device queue, once
+            the last request of each is gone. */
 void DEVICEQ_free(DEVICEQ * dq);
 
 #endif
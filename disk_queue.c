@@ -11,7 +11,9 @@ DISKQ *DISKQ_new()
      *  D_NODES until a null marker is hit. */
     DISKQ * dq = malloc( sizeof(DISKQ) );
     *dq = (DISKQ){  .head = NULL,
-                    .tail = NULL}; 
+                    .tail = NULL,
+                    .count = 0,
+                    .BYTES = 0}; 
     return dq; 
 }
 
@@ -19,6 +21,8 @@ DISKQ *DISKQ_new()
 void DISKQ_enqueue(DISKQ * dq, D_NODE * insert)
 {
     int key = insert->PROCESS_PARAMS.CYLINDER; 
+    dq->count++;
+    dq->BYTES += insert->PROCESS_PARAMS.FILE_LEN;
     if( DISKQ_empty(dq) ){
         dq->head = insert; 
         dq->tail = insert; 
@@ -91,6 +95,8 @@ void DISKQ_dequeue(DISKQ * dq, PCB ** dequeued)
     {
         /** Place ptr to PCB into dequeued. */ 
         *dequeued = dq->head->D_PCB; 
+        dq->count--;
+        dq->BYTES -= dq->head->PROCESS_PARAMS.FILE_LEN;
 
         /** Was there only a single D_NODE? */
         if( dq->head == dq->tail ){
@@ -107,52 +113,45 @@ void DISKQ_dequeue(DISKQ * dq, PCB ** dequeued)
             D_NODE_free(free_node); 
             dq->tail->LINK = dq->head; 
         }
-        (*dequeued)->LINK = NULL;
+        if( *dequeued )
+            (*dequeued)->LINK = NULL;
     }
     else
         *dequeued = NULL; 
 }
-void DISKQ_kill(DISKQ * dq, PCB ** dequeued, int pid)
+int DISKQ_kill(DISKQ * dq, PCB ** dequeued, int pid)
 {
-     if( dq->head == NULL ){
-        *dequeued = NULL;
-        return;
-    }
-    else{
-        if( dq->head->D_PCB->PID == pid ){
-            *dequeued = dq->head->D_PCB;
-            if( dq->head == dq->tail ){
-                D_NODE_free(dq->head);
+    *dequeued = NULL;
+    if( dq->head == NULL )
+        return -1;
+
+    /** Walk the circle once, starting with the node after the tail so 
+     *  that prev_ptr is always the node linking to curr_ptr. */
+    D_NODE * prev_ptr = dq->tail;
+    D_NODE * curr_ptr = dq->head;
+    do{
+        if( curr_ptr->D_PCB && curr_ptr->D_PCB->PID == pid ){
+            *dequeued = curr_ptr->D_PCB;
+            int slot = curr_ptr->SLOT;
+            dq->count--;
+            dq->BYTES -= curr_ptr->PROCESS_PARAMS.FILE_LEN;
+            if( dq->head == dq->tail )
                 dq->head = dq->tail = NULL;
-            }
             else{
-                dq->head = dq->head->LINK;
-                dq->tail->LINK = dq->head; 
+                prev_ptr->LINK = curr_ptr->LINK;
+                if( curr_ptr == dq->head )
+                    dq->head = curr_ptr->LINK;
+                if( curr_ptr == dq->tail )
+                    dq->tail = prev_ptr;
             }
+            D_NODE_free(curr_ptr);
             (*dequeued)->LINK = NULL;
+            return slot;
         }
-        else{
-            D_NODE * curr_ptr = dq->head;
-            while( curr_ptr->LINK ){
-                if( curr_ptr->LINK->D_PCB->PID == pid ){
-                    *dequeued = curr_ptr->LINK->D_PCB;
-                    if( curr_ptr->LINK == dq->tail ){
-                        dq->tail = curr_ptr;
-                        curr_ptr->LINK = dq->head;
-                    }
-                    else{
-                       curr_ptr->LINK = curr_ptr->LINK->LINK;
-                    }
-                    (*dequeued)->LINK = NULL;
-                    return;
-                }
-                else
-                    curr_ptr = curr_ptr->LINK;
-            }
-            if( curr_ptr->LINK == NULL )
-                *dequeued = NULL;
-        }
-    }
+        prev_ptr = curr_ptr;
+        curr_ptr = curr_ptr->LINK;
+    } while( curr_ptr != dq->head );
+    return -1;
 }
 
 int DISKQ_empty(DISKQ * dq)
@@ -174,7 +173,7 @@ void DISKQ_free(DISKQ * recycle)
     D_NODE * prev_ptr = recycle->head; 
     while( curr_ptr ){
         curr_ptr = curr_ptr->LINK; 
-        PCB_free(prev_ptr->D_PCB);
+        PCB_io_release(prev_ptr->D_PCB);
         D_NODE_free(prev_ptr); 
         prev_ptr = curr_ptr;
     }
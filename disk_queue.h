@@ -41,6 +41,8 @@
 typedef struct DISKQ {
     D_NODE * head;
     D_NODE * tail;
+    int      count;     // Queued requests,
+    long     BYTES;     //   and their file lengths summed.
 } DISKQ;
 
 DISKQ * DISKQ_new();
@@ -49,7 +51,11 @@ void DISKQ_enqueue(DISKQ * dq, D_NODE * insert);
 
 void DISKQ_dequeue(DISKQ * dq, PCB ** dequeued);
 
-void DISKQ_kill(DISKQ * dq, PCB ** dequeued, int pid);
+/** Remove the request of process pid from the queue, if it has one. Its
+ *  PCB is passed into dequeued, NULL if not found.
+ *  \return the service slot the request held, -1 if it wasn't in 
+ *          service. */
+int DISKQ_kill(DISKQ * dq, PCB ** dequeued, int pid);
 
 int DISKQ_empty(DISKQ * dq);
 
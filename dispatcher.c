@@ -0,0 +1,235 @@
+/** \file
+ *  dispatcher.c:   CPU dispatching and the simulation clock. */
+
+#include <stdio.h>
+#include <math.h>
+#include "dispatcher.h"
+
+uint64_t ms_to_ticks(double ms)
+{
+    if( ms <= 0 )
+        return 0;
+    return (uint64_t)llround(ms * TW_TICKS_PER_MS);
+}
+
+/** Charge the running process for the CPU time between the CPU mark and
+ *  the current clock: burst time and total CPU time go up, remaining tau
+ *  goes down, and the scheduling policy and the process' group see the
+ *  same amount. Nothing is charged while the mark is still ahead of the
+ *  clock, since that time belongs to the context switch. */
+static void charge_running(SYSGEN * sys)
+{
+    PCB * running = sys->CPU->RUNNING_PROCESS;
+    double burst_t = sys->clock - sys->CPU->MARK;
+    if( burst_t <= 0 )
+        return;
+    sys->CPU->MARK = sys->clock;
+    if( running == NULL )
+        return;
+
+    sys->CPU->BUSY_t            += burst_t;
+    PCB_acct(running)->BURST_t  += burst_t;
+    running->TAU_r              -= burst_t;
+    PCB_acct(running)->CPU_t    += burst_t;
+    PCB_acct(running)->LAST_RAN  = sys->clock;
+    if( READYQ_tick(sys->READY_QUEUE, running, burst_t) )
+        sys->CPU->SLICE_OVER = 1;
+    if( RG_charge_cpu(PCB_acct(running)->GROUP, burst_t) )
+        sys->CPU->SLICE_OVER = 1;
+}
+
+/** Arm the slice timer for the end of the running process' slice, or of
+ *  its group's CPU time if that comes first. */
+static void arm_slice_timer(SYSGEN * sys)
+{
+    PCB * running = sys->CPU->RUNNING_PROCESS;
+    double left = READYQ_slice_left(sys->READY_QUEUE, running);
+    double group = RG_cpu_left(PCB_acct(running)->GROUP);
+    if( group >= 0 && (left <= 0 || group < left) )
+        left = group;
+    if( left <= 0 )
+        return;
+    /** The slice starts once any context switch in progress is done. */
+    uint64_t expires = ms_to_ticks(sys->CPU->MARK + left);
+    if( expires <= ms_to_ticks(sys->clock) )
+        expires = ms_to_ticks(sys->clock) + 1;
+    TWHEEL_arm(sys->TIMERS, &sys->CPU->SLICE_TIMER, expires);
+}
+
+/** Timer interrupt at the end of a time slice. Charge the running process
+ *  up to now; if the policy agrees the slice is over, or the process' group
+ *  has used up its CPU cap, put the process back on the ready queue and
+ *  let the policy pick who runs next. */
+static void slice_expired(TIMER * timer)
+{
+    SYSGEN * sys = timer->arg;
+    PCB * running = sys->CPU->RUNNING_PROCESS;
+    if( running == NULL )
+        return;
+
+    charge_running(sys);
+    if( sys->CPU->SLICE_OVER ){
+        PCB_ACCT * acct = PCB_acct(running);
+        if( acct->GROUP && acct->GROUP->THROTTLED )
+            printf("Timer interrupt: group %d used up its CPU cap, PID %d"
+                   " held until the next period.\n", acct->GROUP->NUM,
+                   running->PID);
+        if( acct->RT.PERIOD > 0 && acct->RT.LEFT < RT_MIN_LEFT )
+            RT_overrun(sys, running);
+        else if( !acct->GROUP || !acct->GROUP->THROTTLED )
+            printf("Timer interrupt: PID %d time slice expired.\n",
+                   running->PID);
+        READYQ_enqueue(sys->READY_QUEUE, running);
+        dispatch_next(sys);
+    }
+    else
+        arm_slice_timer(sys);
+}
+
+/** TWHEEL_advance() callback: bring the clock up to the tick about to
+ *  fire, charging the running process on the way. */
+static void set_clock(uint64_t tick, void * arg)
+{
+    SYSGEN * sys = arg;
+    sys->clock = (double)tick / TW_TICKS_PER_MS;
+    charge_running(sys);
+}
+
+void dispatcher_init(SYSGEN * sys)
+{
+    TIMER_init(&sys->CPU->SLICE_TIMER, slice_expired, sys);
+}
+
+/** Cost in ms of switching the CPU to pcb: the fixed dispatcher latency,
+ *  plus a refill penalty for the TLB and caches. The penalty is the full
+ *  cold penalty for a process that never ran, and otherwise grows with the
+ *  time since the process last held the CPU as its footprint is evicted:
+ *  penalty * (1 - e^(-gap/decay)). */
+static double switch_cost(SYSGEN * sys, PCB * pcb)
+{
+    double cost = sys->cs_latency;
+    if( sys->cs_cold_penalty > 0 ){
+        double last = PCB_acct(pcb)->LAST_RAN;
+        if( last < 0 )
+            cost += sys->cs_cold_penalty;
+        else
+            cost += sys->cs_cold_penalty
+                  * (1 - exp( -(sys->clock - last) / sys->cs_decay ));
+    }
+    return cost;
+}
+
+void dispatch(SYSGEN * sys, PCB * pcb)
+{
+    TWHEEL_cancel(sys->TIMERS, &sys->CPU->SLICE_TIMER);
+
+    /** A process whose group is throttled waits for the next period. */
+    if( pcb && !READYQ_can_run(sys->READY_QUEUE, pcb) ){
+        READYQ_enqueue(sys->READY_QUEUE, pcb);
+        READYQ_dequeue(sys->READY_QUEUE, &pcb);
+    }
+    sys->CPU->RUNNING_PROCESS = pcb;
+    if( sys->CPU->MARK < sys->clock )
+        sys->CPU->MARK = sys->clock;
+    sys->CPU->SLICE_OVER = 0;
+    if( pcb == NULL )
+        return;
+
+    /** Handing the CPU back to the process that last had it is free. 
+     *  Otherwise the switch is charged to system time, and the process 
+     *  only starts being charged once the switch is over. */
+    if( pcb->PID != sys->CPU->LAST_PID ){
+        double cost = switch_cost(sys, pcb);
+        sys->SYS_t += cost;
+        sys->SWITCH_t += cost;
+        sys->SWITCH_n++;
+        sys->CPU->MARK += cost;
+        sys->CPU->LAST_PID = pcb->PID;
+    }
+    arm_slice_timer(sys);
+}
+
+void charge_system(SYSGEN * sys, double ms)
+{
+    if( ms <= 0 )
+        return;
+    sys->SYS_t += ms;
+    if( sys->CPU->MARK < sys->clock )
+        sys->CPU->MARK = sys->clock;
+    sys->CPU->MARK += ms;
+    if( sys->CPU->RUNNING_PROCESS ){
+        TWHEEL_cancel(sys->TIMERS, &sys->CPU->SLICE_TIMER);
+        arm_slice_timer(sys);
+    }
+}
+
+void dispatch_next(SYSGEN * sys)
+{
+    PCB * next;
+    READYQ_dequeue(sys->READY_QUEUE, &next);
+    dispatch(sys, next);
+}
+
+double end_burst(SYSGEN * sys, PCB * pcb)
+{
+    PCB_ACCT * acct = PCB_acct(pcb);
+    double burst = acct->BURST_t;
+    double err = fabs(acct->TAU_n_plus1 - burst);
+    WELFORD_add(&acct->BURST, burst);
+    WELFORD_add(&acct->PRED_ERR, err);
+    WELFORD_add(&sys->BURST, burst);
+    WELFORD_add(&sys->PRED_ERR, err);
+    WELFORD_add(&sys->FIXED_ERR, fabs(acct->TAU_FIXED - burst));
+    sys->RECENT[sys->RECENT_n++ % BURST_WINDOW] = (BURST_SAMPLE){
+            .TAU = acct->TAU_n_plus1,
+            .TAU_FIXED = acct->TAU_FIXED,
+            .BURST = burst };
+    QSKETCH_add(&sys->BURST_P50, burst);
+    QSKETCH_add(&sys->BURST_P90, burst);
+    QSKETCH_add(&sys->BURST_P99, burst);
+    RT_job_done(sys, pcb);
+    acct->BURST_t = 0;
+    return burst;
+}
+
+/** Weight of the latest error in a candidate's recent error. */
+#define ERR_WEIGHT      0.3
+
+void predict_burst(SYSGEN * sys, PCB * pcb, double burst)
+{
+    PCB_ACCT * acct = PCB_acct(pcb);
+    double a = sys->a;
+    acct->TAU_FIXED = a * acct->TAU_FIXED + (1 - a) * burst;
+    if( !sys->ADAPT ){
+        acct->TAU_n_plus1 = acct->TAU_FIXED;
+        return;
+    }
+
+    /** Ties go to the candidate nearest the system's a, so a process
+     *  starts out with about that. */
+    PCB_TUNE * tune = PCB_tune(pcb);
+    int best = (int)lround(a * (ALPHA_GRID - 1));
+    for(int k = 0; k < ALPHA_GRID; k++){
+        double g = (double)k / (ALPHA_GRID - 1);
+        tune->ERR_GRID[k] =        ERR_WEIGHT  * fabs(tune->TAU_GRID[k] - burst)
+                            + (1 - ERR_WEIGHT) * tune->ERR_GRID[k];
+        tune->TAU_GRID[k] = g * tune->TAU_GRID[k] + (1 - g) * burst;
+        if( tune->ERR_GRID[k] < tune->ERR_GRID[best] )
+            best = k;
+    }
+    acct->ALPHA = (double)best / (ALPHA_GRID - 1);
+    acct->TAU_n_plus1 = tune->TAU_GRID[best];
+}
+
+void end_process(SYSGEN * sys, PCB * pcb)
+{
+    WELFORD_add(&sys->CPU_TOTAL, PCB_acct(pcb)->CPU_t);
+}
+
+void advance_clock(SYSGEN * sys, double ms)
+{
+    uint64_t target = ms_to_ticks(sys->clock + (ms > 0 ? ms : 0));
+    TWHEEL_advance(sys->TIMERS, target, set_clock, sys);
+    sys->clock = (double)target / TW_TICKS_PER_MS;
+    charge_running(sys);
+}
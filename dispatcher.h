@@ -0,0 +1,72 @@
+/** \file
+ *  dispatcher.h:   Interface for CPU dispatching and the simulation clock.
+ *
+ *                  The clock (SYSGEN.clock, in ms) moves forward whenever a
+ *                  time query is answered or a timer interrupt is issued.
+ *                  While it moves, the running process is charged for the
+ *                  elapsed CPU time and every timer armed on SYSGEN.TIMERS
+ *                  fires at its exact expiry time. The time slice timer is
+ *                  one of them: it is armed on every dispatch for whatever
+ *                  the scheduling policy says is left of the slice, and when
+ *                  it fires the running process goes back onto the ready
+ *                  queue.
+ *
+ *                  Handing the CPU to a different process costs a context
+ *                  switch, see SYSGEN's cost model. The switch time is
+ *                  added to SYSGEN.SYS_t, and the CPU mark is pushed past
+ *                  the clock by that amount so the incoming process is
+ *                  not charged for it. Other kernel work, such as I/O 
+ *                  submissions and completion interrupts, is charged the 
+ *                  same way through charge_system(). */
+
+#ifndef DISPATCHER_
+#define DISPATCHER_
+
+#include <stdint.h>
+#include "sysgen.h"
+
+/** Hook the CPU's slice timer up to the dispatcher. */
+void dispatcher_init(SYSGEN * sys);
+
+/** Give the CPU to pcb and start its time slice. The previous running 
+ *  process, if any, must already have been dealt with by the caller. A 
+ *  pcb whose group is throttled goes back to the ready queue, which hands
+ *  out the next process that can run instead, so the CPU may be left 
+ *  idle; callers read RUNNING_PROCESS afterwards.
+ *  \param  pcb may be NULL to leave the CPU idle. */
+void dispatch(SYSGEN * sys, PCB * pcb);
+
+/** Dispatch the process picked by the ready queue, idling the CPU if the
+ *  ready queue is empty or holds only processes that can't run yet. */
+void dispatch_next(SYSGEN * sys);
+
+/** Charge ms of kernel work to system time. The CPU is busy with it, so
+ *  the running process is not charged and its time slice is pushed back
+ *  by the same amount. */
+void charge_system(SYSGEN * sys, double ms);
+
+/** Move the clock forward, charging the running process and firing any
+ *  timers that come due on the way.
+ *  \param  ms is the amount of simulated time that passed. */
+void advance_clock(SYSGEN * sys, double ms);
+
+/** pcb's CPU burst is over. Its length goes into the burst statistics of
+ *  pcb and of the system, along with how far TAU_n_plus1 was off. A
+ *  real-time process' job is done.
+ *  \return the burst length; the burst time starts over at 0. */
+double end_burst(SYSGEN * sys, PCB * pcb);
+
+/** Predict pcb's next CPU burst from the one that just ended, burst ms
+ *  long: TAU_n_plus1 = a * TAU_n_plus1 + (1 - a) * burst. In adaptive
+ *  mode each process keeps this prediction for every candidate a of a
+ *  grid and follows the one whose recent error is the smallest. The
+ *  prediction with the system's a is kept either way, to compare. */
+void predict_burst(SYSGEN * sys, PCB * pcb, double burst);
+
+/** pcb is done. Its total CPU time goes into the system's statistics. */
+void end_process(SYSGEN * sys, PCB * pcb);
+
+/** \return the wheel tick for a clock value in ms. */
+uint64_t ms_to_ticks(double ms);
+
+#endif
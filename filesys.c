@@ -0,0 +1,208 @@
+/** \file
+ *  filesys.c:  Implementation for the simulated file system. */
+
+#include <stdlib.h>
+#include <string.h>
+#include "filesys.h"
+
+FSYS *FSYS_new(int cylinders, int blocks_per_cyl, int block_size,
+               unsigned int extent_limit)
+{
+    FSYS * fs = calloc( 1, sizeof(FSYS) );
+    fs->cylinders = cylinders;
+    fs->blocks_per_cyl = blocks_per_cyl;
+    fs->block_size = block_size;
+    fs->extent_limit = extent_limit;
+    fs->total = (unsigned int)cylinders * blocks_per_cyl;
+    fs->used = calloc( fs->total, 1 );
+    fs->skip = malloc( sizeof(unsigned int) * (fs->total ? fs->total : 1) );
+    for(unsigned int b = 0; b < fs->total; b++)
+        fs->skip[b] = b + 1;
+    return fs;
+}
+
+static unsigned int hash(char * name)
+{
+    unsigned long h = 5381;
+    for( ; *name; name++)
+        h = h * 33 + (unsigned char)*name;
+    return h % FS_BUCKETS;
+}
+
+/** \return the inode of file name, made if the file has none. */
+static INODE *get_inode(FSYS * fs, char * name)
+{
+    unsigned int h = hash(name);
+    for(INODE * ino = fs->inodes[h]; ino; ino = ino->next)
+        if( !strcmp(ino->name, name) )
+            return ino;
+
+    INODE * ino = calloc( 1, sizeof(INODE) );
+    ino->name = strdup(name);
+    ino->next = fs->inodes[h];
+    fs->inodes[h] = ino;
+    fs->FILE_n++;
+    return ino;
+}
+
+/** \return index of the last extent starting at or before lblk, -1 if
+ *  there is none. */
+static int find_extent(INODE * ino, unsigned int lblk)
+{
+    int lo = 0;
+    int hi = ino->EXTENT_n - 1;
+    int found = -1;
+    while( lo <= hi ){
+        int mid = (lo + hi) / 2;
+        if( ino->extents[mid].LBLK <= lblk ){
+            found = mid;
+            lo = mid + 1;
+        }
+        else
+            hi = mid - 1;
+    }
+    return found;
+}
+
+static int room(FSYS * fs, EXTENT * e)
+{
+    return fs->extent_limit == 0 || e->LEN < fs->extent_limit;
+}
+
+/** \return the first free block from p on, total if there is none. The
+ *  used blocks passed on the way are pointed at it. */
+static unsigned int free_from(FSYS * fs, unsigned int p)
+{
+    unsigned int q = p;
+    while( q < fs->total && fs->used[q] )
+        q = fs->skip[q];
+    while( p < q ){
+        unsigned int n = fs->skip[p];
+        fs->skip[p] = q;
+        p = n;
+    }
+    return q;
+}
+
+/** Next fit: first free block from the rotor on, wrapping around.
+ *  \return the block, -1 if the disk is full. */
+static long next_free(FSYS * fs)
+{
+    if( fs->USED_n >= fs->total )
+        return -1;
+    unsigned int p = free_from(fs, fs->rotor);
+    if( p == fs->total )
+        p = free_from(fs, 0);
+    return p < fs->total ? (long)p : -1;
+}
+
+/** Allocate a block for logical block lblk, which comes right after
+ *  extent i (or first, if i is -1) in the block map.
+ *  \return the physical block, -1 if the disk is full. */
+static long allocate(FSYS * fs, INODE * ino, int i, unsigned int lblk)
+{
+    EXTENT * prev = i >= 0 ? &ino->extents[i] : NULL;
+
+    /** Grow the preceding extent in place if the block after it is
+     *  free. */
+    if(    prev && prev->LBLK + prev->LEN == lblk && room(fs, prev)
+        && prev->PBLK + prev->LEN < fs->total
+        && !fs->used[prev->PBLK + prev->LEN] )
+    {
+        unsigned int p = prev->PBLK + prev->LEN;
+        fs->used[p] = 1;
+        fs->USED_n++;
+        fs->rotor = p + 1;
+        prev->LEN++;
+        return p;
+    }
+
+    long p = next_free(fs);
+    if( p < 0 )
+        return -1;
+    fs->used[p] = 1;
+    fs->USED_n++;
+    fs->rotor = p + 1;
+
+    if( ino->EXTENT_n == ino->cap ){
+        ino->cap = ino->cap ? 2 * ino->cap : 4;
+        ino->extents = realloc( ino->extents, sizeof(EXTENT) * ino->cap );
+    }
+    memmove(&ino->extents[i+2], &ino->extents[i+1],
+            sizeof(EXTENT) * (ino->EXTENT_n - (i+1)));
+    ino->extents[i+1] = (EXTENT){ .LBLK = lblk, .PBLK = p, .LEN = 1 };
+    ino->EXTENT_n++;
+    fs->EXTENT_n++;
+    return p;
+}
+
+/** \return the physical block of logical block lblk, allocating it if it
+ *  has none, or -1 if the disk is full. */
+static long phys_block(FSYS * fs, INODE * ino, unsigned int lblk)
+{
+    int i = find_extent(ino, lblk);
+    if( i >= 0 && lblk < ino->extents[i].LBLK + ino->extents[i].LEN )
+        return ino->extents[i].PBLK + (lblk - ino->extents[i].LBLK);
+    return allocate(fs, ino, i, lblk);
+}
+
+int FSYS_map(FSYS * fs, char * name, unsigned int off, unsigned int len,
+             FS_SEG * segs, int max)
+{
+    INODE * ino = get_inode(fs, name);
+    unsigned int end = off + len;
+    unsigned int first = off / fs->block_size;
+    unsigned int last = (len > 0 ? end - 1 : off) / fs->block_size;
+    if( end > ino->SIZE )
+        ino->SIZE = end;
+
+    int n = 0;
+    long prev = -1;
+    for(unsigned int b = first; b <= last; b++){
+        long p = phys_block(fs, ino, b);
+        if( p < 0 )
+            return -1;
+        int cyl = p / fs->blocks_per_cyl + 1;
+
+        /** A new segment where the blocks stop being contiguous or move
+         *  to another cylinder, unless there are max already. */
+        if(    n == 0
+            || (   (p != prev + 1 || cyl != segs[n-1].CYLINDER)
+                && n < max ) )
+        {
+            segs[n].CYLINDER = cyl;
+            segs[n].PBLK = p;
+            segs[n].OFF = b == first ? off : b * fs->block_size;
+            n++;
+        }
+        unsigned int seg_end = (b + 1) * fs->block_size;
+        if( seg_end > end )
+            seg_end = end;
+        segs[n-1].LEN = seg_end > segs[n-1].OFF ? seg_end - segs[n-1].OFF : 0;
+        prev = p;
+    }
+    return n;
+}
+
+int FSYS_cylinder(FSYS * fs, char * name, unsigned int off, unsigned int len)
+{
+    FS_SEG seg;
+    return FSYS_map(fs, name, off, len, &seg, 1) < 0 ? -1 : seg.CYLINDER;
+}
+
+void FSYS_free(FSYS * fs)
+{
+    for(int i = 0; i < FS_BUCKETS; i++){
+        INODE * ino = fs->inodes[i];
+        while( ino ){
+            INODE * next = ino->next;
+            free(ino->extents);
+            free(ino->name);
+            free(ino);
+            ino = next;
+        }
+    }
+    free(fs->used);
+    free(fs->skip);
+    free(fs);
+}
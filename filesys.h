@@ -0,0 +1,99 @@
+/** \file
+ *  filesys.h:  Interface for the simulated file system (FSYS) on each disk.
+ *
+ *              A disk has CYLINDER_COUNTS[i] cylinders of a fixed number
+ *              of blocks each, numbered consecutively, cylinder 1 holding
+ *              the first ones. Blocks are page sized. Each file has an
+ *              inode whose block map is a sorted list of extents: runs of
+ *              logical blocks stored in consecutive physical blocks.
+ *
+ *              Files have no explicit creation or size; the first request
+ *              to touch a range of a file lays it out. Blocks are allocated
+ *              right after the file's preceding block if that one is free,
+ *              so a file written in order stays contiguous. Otherwise they
+ *              come from the next free block after where the last
+ *              allocation on the disk ended (next fit). Files that grow at
+ *              the same time therefore interleave. A maximum extent length
+ *              makes fragmentation deliberate.
+ *
+ *              A request is mapped to segments, runs of blocks that are
+ *              contiguous on the disk and on one cylinder. Each segment
+ *              becomes its own disk request, carrying its cylinder. */
+
+#ifndef FILESYS_H_
+#define FILESYS_H_
+
+/** Largest number of segments a request is split into. */
+#define FS_MAX_SEGS     16
+
+/** Run of logical blocks stored in consecutive physical blocks. */
+typedef struct EXTENT {
+    unsigned int        LBLK;       // First logical block.
+    unsigned int        PBLK;       // First physical block.
+    unsigned int        LEN;        // Number of blocks.
+} EXTENT;
+
+/** Inode. */
+typedef struct INODE {
+    struct INODE    *   next;       // Hash chain.
+    char            *   name;       // File name.
+    unsigned int        SIZE;       // Highest byte touched plus one.
+    EXTENT          *   extents;    // Block map, sorted by LBLK.
+    int                 EXTENT_n;
+    int                 cap;
+} INODE;
+
+/** Part of a request on one cylinder. */
+typedef struct FS_SEG {
+    int                 CYLINDER;
+    unsigned int        PBLK;       // Physical block holding OFF.
+    unsigned int        OFF;        // File range.
+    unsigned int        LEN;
+} FS_SEG;
+
+#define FS_BUCKETS      64
+
+/** FSYS struct. */
+typedef struct FSYS {
+    int                 cylinders;
+    int                 blocks_per_cyl;
+    int                 block_size;     // Bytes per block.
+    unsigned int        extent_limit;   // Longest extent, 0 for no limit.
+    unsigned int        total;          // Blocks on the disk.
+    unsigned char   *   used;           // One flag per physical block.
+    unsigned int    *   skip;           // Per block, where to look on for
+                                        //   a free one: blocks are never
+                                        //   freed, so every block from
+                                        //   here up to that is used.
+    unsigned int        rotor;          // Where next fit searches from.
+    INODE           *   inodes[FS_BUCKETS];
+
+    /** Statistics */
+    unsigned int        USED_n;         // Blocks allocated.
+    int                 FILE_n;         // Inodes.
+    long                EXTENT_n;       // Extents over all files.
+} FSYS;
+
+/** Generate and return an empty FSYS.
+ *  \param  extent_limit is the longest extent in blocks, 0 for no
+ *          limit. */
+FSYS *FSYS_new(int cylinders, int blocks_per_cyl, int block_size,
+               unsigned int extent_limit);
+
+/** Map len bytes of file name from offset off to disk segments, laying out
+ *  blocks that have none yet.
+ *  \param  segs receives the segments in file order.
+ *  \param  max is the most segments wanted, at least 1; the last one
+ *          covers whatever is left.
+ *  \return the number of segments, -1 if the disk is full. */
+int FSYS_map(FSYS * fs, char * name, unsigned int off, unsigned int len,
+             FS_SEG * segs, int max);
+
+/** Lay out len bytes of file name from offset off, like FSYS_map.
+ *  \return the cylinder holding byte off, -1 if the disk is full. */
+int FSYS_cylinder(FSYS * fs, char * name, unsigned int off, unsigned int len);
+
+/** Free the FSYS and all inodes. */
+void FSYS_free(FSYS * fs);
+
+#endif
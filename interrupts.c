@@ -2,18 +2,30 @@
 #include <stdio.h>
 #include "interrupts.h"
 #include "user_input_utilities.h"
+#include "dispatcher.h"
 
-/**  Local interrupt routine. 
+/** Query timer for amount of time the running process was in CPU, and 
+ *  advance the clock by this time. The running process is charged for it
+ *  (burst time and total CPU time go up, TAU_r goes down), and if its time
+ *  slice ran out on the way the slice timer has already switched in the 
+ *  next process. */
+static void query_cpu(SYSGEN * sys)
+{
+    double burst_t; 
+    get_double("CPU process interrupted. Time query (ms):", &burst_t); 
+    advance_clock(sys, burst_t);
+}
+
+/**  Hand a process that became ready to the CPU or the ready queue. The
+ *   clock is already at the time of the interrupt.
  *   
  *   If the CPU contains a process, then:
- *   1)  Query timer for amount of time the running process was in CPU.
- *   2)  Add this time to total burst time for currently running process
- *       and subtract it from the TAU_remainder. Update total CPU time. 
- *   3)  If interrupting process has a lower TAU_remaining, queue
- *       the CPU process into RQ then place interrupter proc into CPU.
+ *   1)  If the scheduling policy says the interrupting process preempts 
+ *       the CPU process, queue the CPU process into RQ then place 
+ *       interrupter proc into CPU.
  *       
  *       Invariant: It's not possible for there to be a process on the 
- *                  rq with a lower TAU_r than the process in the CPU at this 
+ *                  rq which should preempt the process in the CPU at this 
  *                  point, since any such process would have had to issue 
  *                  an interrupt, at which point it would have performed 
  *                  a query and comparison with the CPU process.   
@@ -21,23 +33,22 @@
  *                  the interrupting process and CPU process, and not check 
  *                  processes on the RQ.   
  *  
- *   4)  Otherwise just queue interrupting process into the RQ. */
-static void interrupt_routine(SYSGEN * sys, PCB * ptr)
+ *   2)  Otherwise just queue interrupting process into the RQ. */
+void wake_process(SYSGEN * sys, PCB * ptr)
 {
-    /** If CPU is empty, start running process. */
+    /** If CPU is empty, start running process, unless it is a real-time
+     *  one that has to wait for its next release. */
     if( sys->CPU->RUNNING_PROCESS == NULL){
-        sys->CPU->RUNNING_PROCESS = ptr;
+        if( READYQ_can_run(sys->READY_QUEUE, ptr) )
+            dispatch(sys, ptr);
+        else
+            READYQ_enqueue(sys->READY_QUEUE, ptr);
     }
     else{
-        double burst_t; 
-        get_double("CPU process interrupted. Time query (ms):", &burst_t); 
-        sys->CPU->RUNNING_PROCESS->BURST_t  += burst_t; 
-        sys->CPU->RUNNING_PROCESS->TAU_r    -= burst_t; 
-        sys->CPU->RUNNING_PROCESS->CPU_t    += burst_t;
-
-        if( ptr->TAU_r < sys->CPU->RUNNING_PROCESS->TAU_r){
-            READYQ_enqueue(sys->READY_QUEUE, sys->CPU->RUNNING_PROCESS);
-            sys->CPU->RUNNING_PROCESS = ptr; 
+        PCB * running = sys->CPU->RUNNING_PROCESS;
+        if( READYQ_should_preempt(sys->READY_QUEUE, running, ptr) ){
+            READYQ_enqueue(sys->READY_QUEUE, running);
+            dispatch(sys, ptr);
         }
         else{
             READYQ_enqueue(sys->READY_QUEUE, ptr);
@@ -45,28 +56,42 @@ static void interrupt_routine(SYSGEN * sys, PCB * ptr)
     }
 }
 
-/** Compute and update a processes' burst average. 
- *  \param  old_avg is the processes' old average.
- *  \param  new_val is the length of the most recently completed burst. 
- *  \param  n is the number of CPU bursts (Should be updated to include 
- *          the most recent CPU burst completed. 
- *  \param  loc is a pointer to where the new burst avg should be stored. */
-static void compute_average(double old_avg, double new_val,
-                            int n, double * loc)
+/** Hand a batch of processes that became ready at the same time to the 
+ *  CPU and the ready queue with a single preemption decision. The best of
+ *  the batch, by the policy's own preemption test, is the only one that 
+ *  is compared with the CPU process; the rest go straight onto the ready
+ *  queue. If the best doesn't preempt the CPU process, none of them 
+ *  would. */
+static void wake_batch(SYSGEN * sys, PCB ** woken, int n)
 {
-    double new_avg = (n-1)*old_avg;
-    new_avg += new_val; 
-    new_avg = new_avg / n;
-    *loc = new_avg;
+    if( n == 0 )
+        return;
+    int best = 0;
+    for(int i = 1; i < n; i++)
+        if( READYQ_should_preempt(sys->READY_QUEUE, woken[best], woken[i]) )
+            best = i;
+    for(int i = 0; i < n; i++)
+        if( i != best )
+            READYQ_enqueue(sys->READY_QUEUE, woken[i]);
+    wake_process(sys, woken[best]);
 }
 
+/** Local interrupt routine: an interrupt that finds a process on the CPU
+ *  first queries how long it ran, then the interrupting process is woken 
+ *  up. */
+static void interrupt_routine(SYSGEN * sys, PCB * ptr)
+{
+    if( sys->CPU->RUNNING_PROCESS != NULL )
+        query_cpu(sys);
+    wake_process(sys, ptr);
+}
 
 void snapshot(SYSGEN * sys)
 {
     int c;
     int invalid_cmd = 1;
 
-    printf("Input [r|p|d|f|m|j|c]: ");
+    printf("Input [r|p|d|f|m|M|j|c|s|x]: ");
     while(invalid_cmd){
         c = getchar();
         if( c == 'r'){
@@ -83,6 +108,9 @@ void snapshot(SYSGEN * sys)
             print_header();
             print_printer_queues(sys);
             printf("\n");
+            print_device_stats(sys, DEVICE_PRINTER);
+            print_io_rings(sys);
+            printf("\n");
             invalid_cmd = 0;
         }
         else if( c == 'f'){
@@ -90,6 +118,10 @@ void snapshot(SYSGEN * sys)
             print_header();
             print_flashdrive_queues(sys);
             printf("\n");
+            print_device_stats(sys, DEVICE_FLASH);
+            print_readahead(sys, DEVICE_FLASH);
+            print_io_rings(sys);
+            printf("\n");
             print_system_CPU_time(sys);
             printf("\n");
             invalid_cmd = 0;
@@ -99,6 +131,13 @@ void snapshot(SYSGEN * sys)
             print_disk_header();
             print_disk_queues(sys);
             printf("\n");
+            print_device_stats(sys, DEVICE_DISK);
+            print_readahead(sys, DEVICE_DISK);
+            print_buffer_cache(sys);
+            print_filesystems(sys);
+            print_volume(sys);
+            print_io_rings(sys);
+            printf("\n");
             print_system_CPU_time(sys);
             printf("\n");
             invalid_cmd = 0;
@@ -110,12 +149,44 @@ void snapshot(SYSGEN * sys)
             printf("\n");
             print_system_CPU_time(sys);
             printf("\n");
+            if( sys->GROUPS ){
+                print_groups(sys);
+                printf("\n");
+            }
             invalid_cmd = 0;
         }
         else if( c == 'm'){
             printf("\n");
             print_frame_table(sys);
             printf("\n");
+            if( sys->GROUPS ){
+                print_groups(sys);
+                printf("\n");
+            }
+            invalid_cmd = 0;
+        }
+        else if( c == 'M'){
+            int first, last;
+
+            /** The range comes on lines of its own. */
+            while( (c = getchar()) != '\n' && c != EOF);
+            get_int("Enter first frame:", &first);
+            get_int("Enter last frame:", &last);
+            printf("\n");
+            print_frames(sys, first, last);
+            printf("\n");
+            invalid_cmd = 0;
+        }
+        else if( c == 's'){
+            printf("\n");
+            print_summary(sys);
+            printf("\n");
+            invalid_cmd = 0;
+        }
+        else if( c == 'x'){
+            printf("\n");
+            print_changes(sys);
+            printf("\n");
             invalid_cmd = 0;
         }
         else if( c == 'j'){
@@ -128,18 +199,40 @@ void snapshot(SYSGEN * sys)
             printf("\033[2K\033[1GInput r,p,d,f: \033[m");
     }
 printf("-------------------------------------------------------------------\n");
+    if( c != '\n' && c != EOF )
         while ( (c = getchar()) != '\n' && c != EOF);
 }
 
-void create_process(SYSGEN * sys)
+/** Prompt for a resource group, if there are any.
+ *  \return the group, NULL if there are none. */
+static RGROUP *get_group(SYSGEN * sys)
+{
+    if( sys->GROUPS == NULL )
+        return NULL;
+    char prompt[32];
+    int num;
+    snprintf(prompt, sizeof(prompt), "Enter group (1-%d):",
+             sys->GROUPS->count);
+    get_int(prompt, &num);
+    while( num < 1 || num > sys->GROUPS->count ){
+        printf("No such group.\n");
+        get_int(prompt, &num);
+    }
+    return &sys->GROUPS->g[num-1];
+}
+
+/** Prompt for a process size and group.
+ *  \return the new process, NULL if the size is too large. */
+static PCB *new_process(SYSGEN * sys)
 {
     int p_size;
     get_int("Enter process size:", &p_size);
     
     if( p_size > sys->max_proc_size ){
         printf("Requested process size exceeds maximum process size.\n");
-        return;
+        return NULL;
     }
+    RGROUP * group = get_group(sys);
    
     /** Number of pages is the ceiling of the process size divided by 
      *  frame size. Cast to double during operation. */ 
@@ -147,31 +240,51 @@ void create_process(SYSGEN * sys)
     
     /** Create a new PCB with system's tau initial value. */
     PCB * new_proc = PCB_new(sys->t, p_size, sys->frame_size, num_pages);
-    new_proc->page_table = malloc( sizeof(int) * num_pages ); 
-    
-    /** Routine if there are enough free-frames available. */
-    if( num_pages <= sys->num_free_frames ){
+    PCB_mem(new_proc)->page_table = PT_new(sys->PT, num_pages);
+
+    /** A process its group could never load is turned away. */
+    if( group && group->quota > 0
+        && MEM_load_pages(sys, new_proc) > group->quota ){
+        printf("Process needs more frames than group %d's quota.\n",
+               group->NUM);
+        PCB_free(new_proc);
+        return NULL;
+    }
+    RG_join(group, new_proc);
+    return new_proc;
+}
+
+/** Load new_proc and get it running, or queue it in the job pool if it
+ *  doesn't fit. */
+static void start_process(SYSGEN * sys, PCB * new_proc)
+{
+    /** Routine if there are enough free-frames available, and room for
+     *  them in the process' group. */
+    int need = MEM_load_pages(sys, new_proc);
+    RGROUP * group = PCB_acct(new_proc)->GROUP;
+    if( need <= MEM_room(sys) && need <= RG_frame_room(group) ){
         
         /** Allocate free frames to processes' page table. */
-        for(int i = 0; i < num_pages; i++){
-            int num = new_proc->page_table[i] 
-                    = sys->frame_bag.frames[sys->frame_bag.counter]; 
-            sys->frame_bag.counter--; 
-            sys->frame_table[num].PID = new_proc->PID; 
-            sys->frame_table[num].PAGE_NUM = i; 
-            sys->num_free_frames--;
-        }
+        MEM_map(sys, new_proc);
     }
     /** Otherwise, queue the process into the job pool and return from the 
      *  create process routine. */
     else{
+        if( need > RG_frame_room(group) )
+            group->QUOTA_n++;
         JOBQ_enqueue(sys->JOB_QUEUE, new_proc);
+
+        /** Room may be made by swapping out blocked processes. */
+        MEM_balance(sys);
+        if(    sys->CPU->RUNNING_PROCESS == NULL
+            && !READYQ_empty(sys->READY_QUEUE) )
+            dispatch_next(sys);
         return;
     }
 
     /** If RQ and CPU empty, process goes into CPU. */
     if( READYQ_empty(sys->READY_QUEUE) && (sys->CPU->RUNNING_PROCESS == NULL)){
-        sys->CPU->RUNNING_PROCESS = new_proc;
+        dispatch(sys, new_proc);
     }
     /** Call the interrupt routine. */
     else{
@@ -179,19 +292,49 @@ void create_process(SYSGEN * sys)
     }
 }
 
+void create_process(SYSGEN * sys)
+{
+    PCB * new_proc = new_process(sys);
+    if( new_proc )
+        start_process(sys, new_proc);
+}
+
+void create_rt_process(SYSGEN * sys)
+{
+    if( sys->RT == NULL ){
+        printf("There is no real-time class.\n");
+        return;
+    }
+    double period, budget, deadline;
+    get_double("Enter period (ms):", &period);
+    get_double("Enter budget per period (ms):", &budget);
+    get_double("Enter relative deadline (ms, 0 for the period):", &deadline);
+    if( deadline == 0 )
+        deadline = period;
+    if( !(budget > 0 && budget <= deadline && deadline <= period) ){
+        printf("Need 0 < budget <= deadline <= period.\n");
+        return;
+    }
+    if( !RT_admit(sys, budget, deadline) )
+        return;
+    PCB * new_proc = new_process(sys);
+    if( new_proc == NULL )
+        return;
+    RT_start(sys, new_proc, period, budget, deadline);
+    start_process(sys, new_proc);
+}
+
 void kill_process(SYSGEN * sys, int pid)
 {
     /** Interrupt CPU process. */
     if( sys->CPU->RUNNING_PROCESS != NULL ){
-        double burst_t; 
-        get_double("CPU process interrupted. Time query (ms):", &burst_t);
-        sys->CPU->RUNNING_PROCESS->BURST_t  += burst_t;
-        sys->CPU->RUNNING_PROCESS->TAU_r    -= burst_t;
-        sys->CPU->RUNNING_PROCESS->CPU_t    += burst_t;
+        query_cpu(sys);
     
-        /** Queue CPU proc into RQ. */ 
-        READYQ_enqueue(sys->READY_QUEUE, sys->CPU->RUNNING_PROCESS); 
-        sys->CPU->RUNNING_PROCESS = NULL; 
+        /** Queue CPU proc into RQ, unless it was held off the CPU on the 
+         *  way. */ 
+        if( sys->CPU->RUNNING_PROCESS != NULL )
+            READYQ_enqueue(sys->READY_QUEUE, sys->CPU->RUNNING_PROCESS); 
+        dispatch(sys, NULL);
     }
     
     PCB * kill_proc = NULL; 
@@ -199,151 +342,103 @@ void kill_process(SYSGEN * sys, int pid)
    
     int jq = 0; 
 
-    if( !kill_proc ){
-        for(int i = 0; i < sys->DISK_COUNT; i++){
-            DISKQ_kill(sys->DISKS[i], &kill_proc, pid);      
-            if(kill_proc) break;
+    /** A process blocked on I/O may have requests on several devices, 
+     *  and completions waiting to be reaped; all of them go. */
+    PCB * found; 
+    int slot;
+    for(int i = 0; i < sys->DISK_COUNT; i++){
+        for(slot = DISKQ_kill(sys->DISKS[i], &found, pid); found;
+            slot = DISKQ_kill(sys->DISKS[i], &found, pid) ){
+            DEVICE_killed(&sys->DISK_UNITS[i], slot);
+            kill_proc = found;
         }
     }
         
-    if( !kill_proc){
-        for(int i = 0; i < sys->PRINTER_COUNT; i++){
-            DEVICEQ_kill(sys->PRINTERS[i], &kill_proc, pid);      
-            if(kill_proc) break; 
+    for(int i = 0; i < sys->PRINTER_COUNT; i++){
+        for(slot = DEVICEQ_kill(sys->PRINTERS[i], &found, pid); found;
+            slot = DEVICEQ_kill(sys->PRINTERS[i], &found, pid) ){
+            DEVICE_killed(&sys->PRINTER_UNITS[i], slot);
+            kill_proc = found;
         }
     }
         
-    if( !kill_proc){
-        for(int i = 0; i < sys->FLASHDRIVE_COUNT; i++){
-            DEVICEQ_kill(sys->FLASHDRIVES[i], &kill_proc, pid);      
-            if(kill_proc) break; 
+    for(int i = 0; i < sys->FLASHDRIVE_COUNT; i++){
+        for(slot = DEVICEQ_kill(sys->FLASHDRIVES[i], &found, pid); found;
+            slot = DEVICEQ_kill(sys->FLASHDRIVES[i], &found, pid) ){
+            DEVICE_killed(&sys->FLASH_UNITS[i], slot);
+            kill_proc = found;
         }
     }
 
+    found = IO_RING_cancel(sys->IO, pid);
+    if( found )
+        kill_proc = found;
+
     if( !kill_proc ){
         READYQ_kill(sys->READY_QUEUE, &kill_proc, pid); 
     }
 
+    if( !kill_proc )
+        kill_proc = MEM_swapq_kill(sys, pid);
+
     if( !kill_proc ){ 
         JOBQ_kill(sys->JOB_QUEUE, &kill_proc, pid);
         jq = 1; 
     }
 
+    /** A killed job is neither met nor missed. */
+    if( kill_proc ){
+        RT_exit(sys, kill_proc);
+        RG_exit(kill_proc);
+    }
+
     if( kill_proc && jq == 1){
         printf( "Proc with PID: %d from job pool killed.\n", 
                 kill_proc->PID);
         PCB_free(kill_proc);
-        if( sys->READY_QUEUE->head ){
+        if( !READYQ_empty(sys->READY_QUEUE) ){
             PCB* new_proc;
             READYQ_dequeue(sys->READY_QUEUE, &new_proc);
-            sys->CPU->RUNNING_PROCESS = new_proc;
+            dispatch(sys, new_proc);
         }
     }
     else if( kill_proc ){
         /** If the process was in the middle of a CPU burst then we 
          *  update processes' and system's CPU accounting info. */
-        if( kill_proc->BURST_t > 0){ 
-            kill_proc->BURST_n++;
-            compute_average(kill_proc->BURST_avg,
-                            kill_proc->BURST_t,
-                            kill_proc->BURST_n,
-                            &kill_proc->BURST_avg);
-            sys->CPU_n++;
-            compute_average(sys->CPU_avg,
-                            kill_proc->CPU_t,
-                            sys->CPU_n,
-                            &sys->CPU_avg);
+        if( PCB_acct(kill_proc)->BURST_t > 0){ 
+            end_burst(sys, kill_proc);
+            end_process(sys, kill_proc);
             printf( "Proc with PID: %d, CPU time: %.3lfms, burst avg: %.3lfms,"
                     " killed.\n",
                     kill_proc->PID,
-                    kill_proc->CPU_t,
-                    kill_proc->BURST_avg);
+                    PCB_acct(kill_proc)->CPU_t,
+                    PCB_acct(kill_proc)->BURST.mean);
             /** Free up frame tables used by the process. */ 
-            for( int i = 0; i < kill_proc->num_pages; i++){
-                sys->frame_bag.counter++;
-                int frame_num = kill_proc->page_table[i];
-                sys->frame_bag.frames[sys->frame_bag.counter] = frame_num;
-                sys->frame_table[frame_num].PID = -1;
-                sys->frame_table[frame_num].PAGE_NUM = -1;
-                sys->num_free_frames++;
-            }
+            MEM_unmap(sys, kill_proc);
             PCB_free(kill_proc); 
-            
-            PCB * does_it_blend;
-            int free_mem = sys->num_free_frames * sys->frame_size;
-            JOBQ_dequeue(sys->JOB_QUEUE, &does_it_blend, free_mem);
-            while( does_it_blend ){
-                /** Allocate free frames to processes' page table. */
-                for(int i = 0; i < does_it_blend->num_pages; i++){
-                    int num = does_it_blend->page_table[i]
-                            = sys->frame_bag.frames[sys->frame_bag.counter];
-                    sys->frame_bag.counter--;
-                    sys->frame_table[num].PID = does_it_blend->PID;
-                    sys->frame_table[num].PAGE_NUM = i; 
-                    sys->num_free_frames--;
-                }
-                /** queue process from job bool onto RQ. */
-                READYQ_enqueue(sys->READY_QUEUE, does_it_blend);
-
-                /** Update amount of free memory available and search the
-                *  job pool again. */
-                free_mem = sys->num_free_frames * sys->frame_size;
-                JOBQ_dequeue(sys->JOB_QUEUE, &does_it_blend, free_mem);
-            }
-            if( sys->READY_QUEUE->head ){
+            MEM_balance(sys);
+            if( !READYQ_empty(sys->READY_QUEUE) ){
                 PCB* new_proc;
                 READYQ_dequeue(sys->READY_QUEUE, &new_proc); 
-                sys->CPU->RUNNING_PROCESS = new_proc;   
+                dispatch(sys, new_proc);   
             }
         }
         else{
-            if( kill_proc->CPU_t > 0 ){ 
-                sys->CPU_n++;
-                compute_average(sys->CPU_avg,
-                                kill_proc->CPU_t,
-                                sys->CPU_n,
-                                &sys->CPU_avg);
-            }
+            if( PCB_acct(kill_proc)->CPU_t > 0 )
+                end_process(sys, kill_proc);
             printf( "Proc with PID: %d, CPU time: %.3lfms, burst avg: %.3lfms,"
                     " killed.\n",
                     kill_proc->PID,
-                    kill_proc->CPU_t,
-                    kill_proc->BURST_avg);
+                    PCB_acct(kill_proc)->CPU_t,
+                    PCB_acct(kill_proc)->BURST.mean);
             /** Free up frame tables used by the process. */ 
-            for( int i = 0; i < kill_proc->num_pages; i++){
-                sys->frame_bag.counter++;
-                int frame_num = kill_proc->page_table[i];
-                sys->frame_bag.frames[sys->frame_bag.counter] = frame_num;
-                sys->frame_table[frame_num].PID = -1;
-                sys->frame_table[frame_num].PAGE_NUM = -1;
-                sys->num_free_frames++;
-            }
+            MEM_unmap(sys, kill_proc);
             PCB_free(kill_proc); 
-            
-            PCB * does_it_blend;
-            int free_mem = sys->num_free_frames * sys->frame_size;
-            JOBQ_dequeue(sys->JOB_QUEUE, &does_it_blend, free_mem);
-            while( does_it_blend ){
-                /** Allocate free frames to processes' page table. */
-                for(int i = 0; i < does_it_blend->num_pages; i++){
-                    int num = does_it_blend->page_table[i]
-                            = sys->frame_bag.frames[sys->frame_bag.counter];
-                    sys->frame_bag.counter--;
-                    sys->frame_table[num].PID = does_it_blend->PID;
-                    sys->num_free_frames--;
-                }
-                /** queue process from job bool onto RQ. */
-                READYQ_enqueue(sys->READY_QUEUE, does_it_blend);
-
-                /** Update amount of free memory available and search the
-                *  job pool again. */
-                free_mem = sys->num_free_frames * sys->frame_size;
-                JOBQ_dequeue(sys->JOB_QUEUE, &does_it_blend, free_mem);
-            }
-            if( sys->READY_QUEUE->head ){
+            MEM_balance(sys);
+            if( !READYQ_empty(sys->READY_QUEUE) ){
                 PCB* new_proc;
                 READYQ_dequeue(sys->READY_QUEUE, &new_proc); 
-                sys->CPU->RUNNING_PROCESS = new_proc;   
+                dispatch(sys, new_proc);   
             }
         } // End kill_proc else branch 
     } // End kill_proc else if branch 
@@ -353,59 +448,105 @@ void kill_process(SYSGEN * sys, int pid)
         printf("Process with PID #%d not found.\n", pid); 
         PCB * enq; 
         READYQ_dequeue(sys->READY_QUEUE, &enq); 
-        sys->CPU->RUNNING_PROCESS = enq;
+        dispatch(sys, enq);
     }
 }
 
-void printer_interrupt(SYSGEN * sys, long int num)
+void timer_interrupt(SYSGEN * sys)
 {
-    /** Is the printer queue empty? */
-    if( sys->PRINTERS[num-1]->head == NULL){
-        printf("Device queue p%li is empty.\n", num);
-        return;
-    }
-
-    /** Dequeue the PCB. */
-    PCB * ptr;
-    DEVICEQ_dequeue(sys->PRINTERS[num-1], &ptr);
-    
-    /** Call interrupt routine. */
-    interrupt_routine(sys, ptr);
-
+    /** Let time pass. The running process is charged and any time slice
+     *  that runs out on the way is dealt with by the slice timer. */
+    double elapsed;
+    get_double("Timer interrupt. Time query (ms):", &elapsed);
+    advance_clock(sys, elapsed);
+    printf("Clock: %.3lfms.\n", sys->clock);
 printf("------------------------------------------------------------------\n");
 }
 
-void flashdrive_interrupt(SYSGEN * sys, long int num)
+/** Complete a request in service on a device and post it to the 
+ *  completion ring. 
+ *  \param  slot is the device slot that completed, or -1 for an 
+ *          interrupt entered by hand. That first asks how long the CPU 
+ *          process ran, then completes whichever request is due first and
+ *          reaps the completion ring right away. Automatic completions are
+ *          left for the completion interrupt. */
+static void device_done(SYSGEN * sys, char kind, long num, int slot)
 {
-    // Do a check to see if the printer queue is empty.
-    if( sys->FLASHDRIVES[num-1]->head == NULL){
-        printf("Device queue f%li is empty.\n", num);
+    DEVICE * dev = DEVICE_lookup(sys, kind, num);
+    if( dev->ACTIVE == 0 ){
+        printf("Device queue %c%li is empty.\n", kind, num);
         return;
     }
 
-    // Dequeue the PCB/de-allocate the queues device node.
-    PCB * ptr;
-    DEVICEQ_dequeue(sys->FLASHDRIVES[num-1], &ptr);
+    /** Let the clock catch up first; requests in service may finish by
+     *  themselves on the way. */
+    if( slot < 0 ){
+        if( sys->CPU->RUNNING_PROCESS != NULL )
+            query_cpu(sys);
+        if( dev->ACTIVE == 0 ){
+            printf("Device queue %c%li is empty.\n", kind, num);
+            return;
+        }
+    }
+
+    /** Dequeue the PCB/de-allocate the queues device node. */
+    int manual = slot < 0;
+    if( manual )
+        slot = DEVICE_next_done(dev);
+
+    /** Blocks a disk read brought in go into the buffer cache, and
+     *  arrived prefetches are handed to readahead. */
+    D_NODE * req = dev->SLOTS[slot].REQ;
+    if( kind == DEVICE_DISK && sys->CACHE && !req->SWAP && !req->VOL )
+        BCACHE_fill(sys->CACHE, num, req);
+    if(    sys->RA && req->D_PCB == NULL
+        && req->PROCESS_PARAMS.READ_WRITE == 'r' )
+        READAHEAD_complete(sys->RA, kind, num, req);
+
+    /** Kernel requests have nobody to wake up. */
+    PCB * ptr = DEVICE_complete(dev, slot);
+    if( ptr )
+        IO_RING_complete(sys->IO, ptr, kind, num);
 
-    /** Call interrupt routine. */
-    interrupt_routine(sys, ptr);
+    if( manual )
+        completion_interrupt(sys);
+}
+
+void completion_interrupt(SYSGEN * sys)
+{
+    PCB * woken[IO_RING_ENTRIES];
+    int n = IO_RING_reap(sys->IO, woken);
+    printf("I/O completion interrupt: %d process(es) ready.\n", n);
+
+    /** Processes with pages on swap wait to be swapped back in. */
+    int ready = 0;
+    for(int i = 0; i < n; i++)
+        if( MEM_wake(sys, woken[i]) )
+            woken[ready++] = woken[i];
+    MEM_balance(sys);
+    wake_batch(sys, woken, ready);
+    if( sys->CPU->RUNNING_PROCESS == NULL && !READYQ_empty(sys->READY_QUEUE) )
+        dispatch_next(sys);
 
 printf("------------------------------------------------------------------\n");
 }
 
-void disk_interrupt(SYSGEN * sys, long int num)
+void device_completion(SYSGEN * sys, char kind, long num, int slot)
 {
-    // Do a check to see if the printer queue is empty.
-    if( sys->DISKS[num-1]->head == NULL){
-        printf("Device queue d%li is empty.\n", num);
-        return;
-    }
+    device_done(sys, kind, num, slot);
+}
 
-    // Dequeue the PCB/de-allocate the queues device node.
-    PCB * ptr;
-    DISKQ_dequeue(sys->DISKS[num-1], &ptr);
+void printer_interrupt(SYSGEN * sys, long int num)
+{
+    device_done(sys, DEVICE_PRINTER, num, -1);
+}
 
-    interrupt_routine(sys, ptr);
+void flashdrive_interrupt(SYSGEN * sys, long int num)
+{
+    device_done(sys, DEVICE_FLASH, num, -1);
+}
 
-printf("------------------------------------------------------------------\n");
+void disk_interrupt(SYSGEN * sys, long int num)
+{
+    device_done(sys, DEVICE_DISK, num, -1);
 }
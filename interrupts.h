@@ -27,14 +27,38 @@ void snapshot(SYSGEN * sys);
  *  \param  sys is a pointer to a SYSGEN object. */
 void create_process(SYSGEN * sys);
 
+/** Create a real-time process, if it passes admission control. */
+void create_rt_process(SYSGEN * sys);
+
+/** Hand a process that became ready to the CPU or the ready queue,
+ *  preempting the CPU process if the policy says so. The clock is already
+ *  at the time it became ready. */
+void wake_process(SYSGEN * sys, PCB * ptr);
+
 void kill_process(SYSGEN * sys, int pid);
 
+/** Timer interrupt. Query how much time passed and advance the clock;
+ *  processes whose time slice runs out are preempted at the exact expiry
+ *  time. */
+void timer_interrupt(SYSGEN * sys);
+
 /** Device interrupt routines 
  *  See implementation file for details. */
 void printer_interrupt(SYSGEN * sys, long int num);
 void flashdrive_interrupt(SYSGEN * sys, long int num);
 void disk_interrupt(SYSGEN * sys, long int num);
 
+/** Automatic completion of a request in service on a device, raised by
+ *  its completion timer. Same as the device's interrupt, without the CPU
+ *  time query.
+ *  \param  kind is DEVICE_PRINTER, DEVICE_DISK or DEVICE_FLASH.
+ *  \param  slot is the device service slot holding the request. */
+void device_completion(SYSGEN * sys, char kind, long num, int slot);
+
+/** Completion interrupt: reap the completion ring and wake, as one batch,
+ *  every process that has no I/O outstanding any more. */
+void completion_interrupt(SYSGEN * sys);
+
 
 
 
@@ -0,0 +1,158 @@
+/** \file
+ *  io_ring.c:  Implementation for the I/O submission and completion
+ *              rings. */
+
+#include <stdlib.h>
+#include "io_ring.h"
+#include "sysgen.h"
+#include "dispatcher.h"
+#include "interrupts.h"
+
+/** Reap timer callback: the coalescing window is over. */
+static void reap_due(TIMER * timer)
+{
+    IO_RING * ring = timer->arg;
+    completion_interrupt(ring->sys);
+}
+
+IO_RING *IO_RING_new(SYSGEN * sys)
+{
+    IO_RING * ring = calloc( 1, sizeof(IO_RING) );
+    ring->sys = sys;
+    TIMER_init(&ring->REAP_TIMER, reap_due, ring);
+    return ring;
+}
+
+int IO_RING_sq_space(IO_RING * ring)
+{
+    return IO_RING_ENTRIES - (ring->SQ_TAIL - ring->SQ_HEAD);
+}
+
+void IO_RING_prep(IO_RING * ring, char kind, int num, D_NODE * req)
+{
+    ring->SQ[ring->SQ_TAIL++ & IO_RING_MASK] = (IO_SQE){ .KIND = kind,
+                                                         .NUM = num,
+                                                         .REQ = req };
+}
+
+/** Charge one kernel entry. */
+static void kernel_entry(IO_RING * ring)
+{
+    SYSGEN * sys = ring->sys;
+    ring->OVERHEAD_t += sys->io_entry_cost;
+    charge_system(sys, sys->io_entry_cost);
+}
+
+int IO_RING_enter(IO_RING * ring)
+{
+    SYSGEN * sys = ring->sys;
+    int n = 0;
+    if( ring->SQ_HEAD == ring->SQ_TAIL )
+        return 0;
+
+    /** Count the whole batch first: a completion reaped part way through
+     *  must not find its process done while more of its requests are 
+     *  still to be queued. */
+    for(unsigned i = ring->SQ_HEAD; i != ring->SQ_TAIL; i++)
+        PCB_acct(ring->SQ[i & IO_RING_MASK].REQ->D_PCB)->IO_PENDING++;
+
+    kernel_entry(ring);
+    ring->ENTER_n++;
+    while( ring->SQ_HEAD != ring->SQ_TAIL ){
+        IO_SQE * sqe = &ring->SQ[ring->SQ_HEAD++ & IO_RING_MASK];
+        D_NODE * req = sqe->REQ;
+        PCB * pcb = req->D_PCB;
+        n++;
+
+        /** Disk and flash reads go past readahead first. Reads its 
+         *  prefetches cover, and disk requests the buffer cache deals 
+         *  with, complete right away without device I/O. Pieces of a 
+         *  volume request skip both. */
+        int ra =    sys->RA && sqe->KIND != DEVICE_PRINTER && !req->VOL
+                 && req->PROCESS_PARAMS.READ_WRITE == 'r';
+        int served = ra && READAHEAD_read(sys->RA, sqe->KIND, sqe->NUM, req);
+        if(    !served && sqe->KIND == DEVICE_DISK && sys->CACHE 
+            && !req->VOL )
+            served = BCACHE_absorb(sys->CACHE, sqe->NUM, req);
+
+        if( served )
+            IO_RING_complete(ring, pcb, sqe->KIND, sqe->NUM);
+        else{
+            if( sqe->KIND == DEVICE_PRINTER )
+                DEVICEQ_enqueue(sys->PRINTERS[sqe->NUM-1], req);
+            else if( sqe->KIND == DEVICE_DISK )
+                DISKQ_enqueue(sys->DISKS[sqe->NUM-1], req);
+            else
+                DEVICEQ_enqueue(sys->FLASHDRIVES[sqe->NUM-1], req);
+            DEVICE_submit(DEVICE_lookup(sys, sqe->KIND, sqe->NUM));
+        }
+
+        /** Prefetches queue up behind the read that triggered them. */
+        if( ra )
+            READAHEAD_prefetch(sys->RA, sqe->KIND, sqe->NUM, req);
+        if( served )
+            D_NODE_free(req);
+    }
+    ring->SQE_n += n;
+    return n;
+}
+
+void IO_RING_complete(IO_RING * ring, PCB * pcb, char kind, int num)
+{
+    SYSGEN * sys = ring->sys;
+    if( ring->CQ_TAIL - ring->CQ_HEAD == IO_RING_ENTRIES )
+        completion_interrupt(sys);
+
+    ring->CQ[ring->CQ_TAIL++ & IO_RING_MASK] = (IO_CQE){ .pcb = pcb,
+                                                         .KIND = kind,
+                                                         .NUM = num };
+    if( !TIMER_armed(&ring->REAP_TIMER) ){
+        uint64_t expires = ms_to_ticks(sys->clock + sys->io_coalesce);
+        if( expires <= ms_to_ticks(sys->clock) )
+            expires = ms_to_ticks(sys->clock) + 1;
+        TWHEEL_arm(sys->TIMERS, &ring->REAP_TIMER, expires);
+    }
+}
+
+int IO_RING_reap(IO_RING * ring, PCB ** woken)
+{
+    int n = 0;
+    TWHEEL_cancel(ring->sys->TIMERS, &ring->REAP_TIMER);
+    if( ring->CQ_HEAD == ring->CQ_TAIL )
+        return 0;
+
+    kernel_entry(ring);
+    ring->REAP_n++;
+    while( ring->CQ_HEAD != ring->CQ_TAIL ){
+        IO_CQE * cqe = &ring->CQ[ring->CQ_HEAD++ & IO_RING_MASK];
+        if( cqe->pcb == NULL )
+            continue;
+        ring->CQE_n++;
+        if( --PCB_acct(cqe->pcb)->IO_PENDING == 0 )
+            woken[n++] = cqe->pcb;
+    }
+    return n;
+}
+
+PCB *IO_RING_cancel(IO_RING * ring, int pid)
+{
+    PCB * found = NULL;
+    for(unsigned i = ring->CQ_HEAD; i != ring->CQ_TAIL; i++){
+        IO_CQE * cqe = &ring->CQ[i & IO_RING_MASK];
+        if( cqe->pcb && cqe->pcb->PID == pid ){
+            found = cqe->pcb;
+            cqe->pcb = NULL;
+        }
+    }
+    return found;
+}
+
+void IO_RING_free(IO_RING * ring)
+{
+    for(unsigned i = ring->CQ_HEAD; i != ring->CQ_TAIL; i++){
+        IO_CQE * cqe = &ring->CQ[i & IO_RING_MASK];
+        if( cqe->pcb )
+            PCB_io_release(cqe->pcb);
+    }
+    free(ring);
+}
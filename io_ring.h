@@ -0,0 +1,111 @@
+/** \file
+ *  io_ring.h:  Interface for the I/O submission and completion rings.
+ *
+ *              Device I/O goes through a pair of rings, in the style of
+ *              io_uring. A system call fills in one submission queue entry
+ *              (SQE) per request and then enters the kernel once to hand
+ *              them all to their devices. The process stays blocked until
+ *              every one of its requests has completed.
+ *
+ *              Devices post a completion queue entry (CQE) for each
+ *              request they finish. Completions are reaped in batches by a
+ *              single completion interrupt. With a coalescing window, the
+ *              interrupt is held back that long after the first unreaped
+ *              completion, so completions close together share one
+ *              interrupt. Each kernel entry (a submission or a completion
+ *              interrupt) costs a fixed overhead of system time. The
+ *              counters show how much of that overhead batching saves per
+ *              I/O.
+ *
+ *              Disk and flash reads go past readahead, and disk requests
+ *              past the buffer cache, on the way in; the ones they serve 
+ *              are posted to the completion ring at once.
+ *
+ *              Both rings hold IO_RING_ENTRIES entries. A batch never
+ *              outgrows the submission ring. A full completion ring is
+ *              reaped right away. */
+
+#ifndef IO_RING_H_
+#define IO_RING_H_
+
+#include "device_node.h"
+#include "timer_wheel.h"
+
+#define IO_RING_ENTRIES     64
+#define IO_RING_MASK        (IO_RING_ENTRIES - 1)
+
+struct SYSGEN;
+
+/** Submission queue entry. */
+typedef struct IO_SQE {
+    char            KIND;           // Device class, see device.h.
+    int             NUM;            // Device number.
+    D_NODE      *   REQ;            // Request to queue on the device.
+} IO_SQE;
+
+/** Completion queue entry. */
+typedef struct IO_CQE {
+    PCB         *   pcb;            // Process whose request completed,
+                                    //   NULL once cancelled.
+    char            KIND;
+    int             NUM;
+} IO_CQE;
+
+/** IO_RING struct. Head and tail indices run freely and are masked on
+ *  access. */
+typedef struct IO_RING {
+    struct SYSGEN * sys;
+    IO_SQE          SQ[IO_RING_ENTRIES];
+    unsigned        SQ_HEAD;
+    unsigned        SQ_TAIL;
+    IO_CQE          CQ[IO_RING_ENTRIES];
+    unsigned        CQ_HEAD;
+    unsigned        CQ_TAIL;
+    TIMER           REAP_TIMER;     // Completion interrupt, armed while
+                                    //   completions are waiting.
+
+    /** Statistics */
+    long            SQE_n;          // Requests submitted.
+    long            ENTER_n;        // Submission kernel entries.
+    long            CQE_n;          // Completions reaped.
+    long            REAP_n;         // Completion interrupts.
+    double          OVERHEAD_t;     // System time spent on kernel entries.
+} IO_RING;
+
+/** Generate and return an empty IO_RING for sys. */
+IO_RING *IO_RING_new(struct SYSGEN * sys);
+
+/** \return number of free submission entries. */
+int IO_RING_sq_space(IO_RING * ring);
+
+/** Fill in a submission entry. Nothing reaches the device until
+ *  IO_RING_enter(). */
+void IO_RING_prep(IO_RING * ring, char kind, int num, D_NODE * req);
+
+/** Enter the kernel once and queue every prepared request on its device.
+ *  The requesting processes are counted as blocked on each request before
+ *  any of them is queued. Requests served without device I/O complete
+ *  right away, and a full completion ring is reaped then and there, so
+ *  the caller has to take the submitting process off the CPU first.
+ *  \return the number of requests submitted. */
+int IO_RING_enter(IO_RING * ring);
+
+/** Post a completion. Requests the completion interrupt at the end of the
+ *  coalescing window, unless one is already on the way. */
+void IO_RING_complete(IO_RING * ring, PCB * pcb, char kind, int num);
+
+/** Reap every posted completion, charging one kernel entry.
+ *  \param  woken receives the processes that have no I/O outstanding any
+ *          more, in completion order; it needs room for IO_RING_ENTRIES.
+ *  \return the number of processes placed in woken. */
+int IO_RING_reap(IO_RING * ring, PCB ** woken);
+
+/** Drop the unreaped completions of process pid.
+ *  \return its PCB if it had any, NULL otherwise. */
+PCB *IO_RING_cancel(IO_RING * ring, int pid);
+
+/** Free the IO_RING. Processes still waiting on posted completions have
+ *  those requests dropped, see PCB_io_release(). */
+void IO_RING_free(IO_RING * ring);
+
+#endif
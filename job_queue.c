@@ -1,143 +1,223 @@
 #include <stdlib.h>
 #include "job_queue.h" 
 
-JOBQ * JOBQ_new()
+#define JQ(p) PCB_mem(p)
+
+JOBQ * JOBQ_new(double aging, const double * clock)
 {
     JOBQ *jq = malloc( sizeof(JOBQ) ); 
-    *jq = (JOBQ){ .head = NULL, .tail = NULL}; 
+    *jq = (JOBQ){ .root = NULL,
+                  .count = 0,
+                  .WORDS = 0,
+                  .aging = aging,
+                  .clock = clock,
+                  .next_seq = 0,
+                  .WAIT_MAX = 0}; 
     return jq;
 }
 
-void JOBQ_enqueue(JOBQ * jq, PCB * insert)
+/** \return the treap priority of p, a hash of its arrival number, so the
+ *          tree is balanced whatever order the keys come in and still the
+ *          same from run to run. */
+static unsigned long long heap_pri(PCB * p)
+{
+    unsigned long long x = JQ(p)->jq_seq + 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/** \return 1 if a comes before b: higher priority, then first come. */
+static int before(PCB * a, PCB * b)
 {
-    int ins_key = insert->proc_size; 
-    PCB * save_ptr;
+    return  (JQ(a)->jq_key > JQ(b)->jq_key)
+        ||  (JQ(a)->jq_key == JQ(b)->jq_key && JQ(a)->jq_seq < JQ(b)->jq_seq);
+}
+
+/** Recompute the smallest process size under t. */
+static void update(PCB * t)
+{
+    PCB_MEM * m = JQ(t);
+    m->jq_min = m->proc_size;
+    if( m->jq_left && JQ(m->jq_left)->jq_min < m->jq_min )
+        m->jq_min = JQ(m->jq_left)->jq_min;
+    if( m->jq_right && JQ(m->jq_right)->jq_min < m->jq_min )
+        m->jq_min = JQ(m->jq_right)->jq_min;
+}
 
-    if( jq->head == NULL ){
-        jq->head = insert;
-        jq->tail = insert;
+static PCB *rotate_right(PCB * t)
+{
+    PCB * l = JQ(t)->jq_left;
+    JQ(t)->jq_left = JQ(l)->jq_right;
+    JQ(l)->jq_right = t;
+    update(t);
+    update(l);
+    return l;
+}
+
+static PCB *rotate_left(PCB * t)
+{
+    PCB * r = JQ(t)->jq_right;
+    JQ(t)->jq_right = JQ(r)->jq_left;
+    JQ(r)->jq_left = t;
+    update(t);
+    update(r);
+    return r;
+}
+
+static PCB *insert(PCB * t, PCB * p)
+{
+    if( t == NULL )
+        return p;
+    if( before(p, t) ){
+        JQ(t)->jq_left = insert(JQ(t)->jq_left, p);
+        if( heap_pri(JQ(t)->jq_left) > heap_pri(t) )
+            return rotate_right(t);
     }
     else{
-        /** This is the same code I used in the READYQ file, just with the 
-        *  priority comparison operators inclusively swapped, since we are 
-        *  checking for a lower value in the queue. */ 
-        if( jq->head->proc_size < ins_key ){
-            save_ptr = jq->head;
-            jq->head = insert;
-            jq->head->LINK = save_ptr; 
-        }
-        else{
-            PCB * curr_ptr = jq->head;
-            while( curr_ptr->LINK ){
-                if( curr_ptr->LINK->proc_size < ins_key ){
-                    save_ptr = curr_ptr->LINK;
-                    curr_ptr->LINK = insert;
-                    insert->LINK = save_ptr;
-                    break;
-                }
-                else{
-                    curr_ptr = curr_ptr->LINK;
-                }
-            }
-            /** Reached the end of the list, insert at the end. */
-            if( curr_ptr->LINK == NULL){
-                jq->tail->LINK = insert;
-                jq->tail = insert;
-            }
-        }
+        JQ(t)->jq_right = insert(JQ(t)->jq_right, p);
+        if( heap_pri(JQ(t)->jq_right) > heap_pri(t) )
+            return rotate_left(t);
+    }
+    update(t);
+    return t;
+}
+
+/** \return the treap of a's jobs and b's, all of a's coming first. */
+static PCB *merge(PCB * a, PCB * b)
+{
+    if( a == NULL )
+        return b;
+    if( b == NULL )
+        return a;
+    if( heap_pri(a) > heap_pri(b) ){
+        JQ(a)->jq_right = merge(JQ(a)->jq_right, b);
+        update(a);
+        return a;
     }
-    while( jq->tail->LINK )
-        jq->tail->LINK = jq->tail->LINK->LINK;
+    JQ(b)->jq_left = merge(a, JQ(b)->jq_left);
+    update(b);
+    return b;
+}
+
+static PCB *erase(PCB * t, PCB * p)
+{
+    if( t == p ){
+        PCB * rest = merge(JQ(p)->jq_left, JQ(p)->jq_right);
+        JQ(p)->jq_left = JQ(p)->jq_right = NULL;
+        return rest;
+    }
+    if( before(p, t) )
+        JQ(t)->jq_left = erase(JQ(t)->jq_left, p);
+    else
+        JQ(t)->jq_right = erase(JQ(t)->jq_right, p);
+    update(t);
+    return t;
+}
+
+void JOBQ_enqueue(JOBQ * jq, PCB * insert_pcb)
+{
+    PCB_MEM * m = JQ(insert_pcb);
+    m->jq_at = *jq->clock;
+    m->jq_key = m->proc_size - jq->aging * m->jq_at;
+    m->jq_seq = jq->next_seq++;
+    JOBQ_putback(jq, insert_pcb);
+}
+
+void JOBQ_putback(JOBQ * jq, PCB * job)
+{
+    PCB_MEM * m = JQ(job);
+    jq->count++;
+    jq->WORDS += m->proc_size;
+    m->jq_left = m->jq_right = NULL;
+    m->jq_min = m->proc_size;
+    job->LINK = NULL;
+    jq->root = insert(jq->root, job);
+}
+
+/** Take p out of the pool. */
+static void unlink_job(JOBQ * jq, PCB * p)
+{
+    jq->root = erase(jq->root, p);
+    jq->count--;
+    jq->WORDS -= JQ(p)->proc_size;
 }
 
 void JOBQ_dequeue(JOBQ * jq, PCB ** dequeued, int p_size)
 {
-    if( jq->head == NULL ){
-        *dequeued = NULL; 
-        return;  
-    } 
-    else{
-        if( jq->head->proc_size <= p_size ){
-            *dequeued = jq->head; 
-            if( jq->head == jq->tail ){
-                jq->head = jq->tail = NULL;
-            }
-            else{
-                jq->head = jq->head->LINK; 
-            }
-            (*dequeued)->LINK = NULL; 
-        }
-        else{
-            PCB * curr_ptr = jq->head;
-            while( curr_ptr->LINK ){
-                if( curr_ptr->LINK->proc_size <= p_size ){
-                    *dequeued = curr_ptr->LINK; 
-                    if( curr_ptr->LINK == jq->tail ){
-                        jq->tail = curr_ptr; 
-                    }
-                    else{
-                       curr_ptr->LINK = (*dequeued)->LINK; 
-                    }
-                    (*dequeued)->LINK = NULL; 
-                }
-                else
-                    curr_ptr = curr_ptr->LINK;
-            }
-            if( curr_ptr->LINK == NULL )
-                *dequeued = NULL;
+    /** Only go down a side that holds a job which fits, leftmost first. */
+    PCB * t = jq->root;
+    *dequeued = NULL;
+    while( t && JQ(t)->jq_min <= p_size ){
+        PCB * l = JQ(t)->jq_left;
+        if( l && JQ(l)->jq_min <= p_size )
+            t = l;
+        else if( JQ(t)->proc_size <= p_size ){
+            *dequeued = t;
+            break;
         }
+        else
+            t = JQ(t)->jq_right;
+    }
+    if( *dequeued ){
+        unlink_job(jq, *dequeued);
+        double wait = *jq->clock - JQ(*dequeued)->jq_at;
+        if( wait > jq->WAIT_MAX )
+            jq->WAIT_MAX = wait;
     }
 }
 
+PCB *JOBQ_peek(JOBQ * jq)
+{
+    PCB * t = jq->root;
+    while( t && JQ(t)->jq_left )
+        t = JQ(t)->jq_left;
+    return t;
+}
+
+/** \return 1 if p is in the pool: searching for its key and arrival
+ *          number leads to it. */
+static int in_pool(JOBQ * jq, PCB * p)
+{
+    PCB * t = jq->root;
+    while( t && t != p )
+        t = before(p, t) ? JQ(t)->jq_left : JQ(t)->jq_right;
+    return t != NULL;
+}
+
 void JOBQ_kill(JOBQ * jq, PCB ** dequeued, int pid)
 {
-    if( jq->head == NULL ){
-        *dequeued = NULL;
+    PCB * p = PCB_find(pid);
+    *dequeued = p && in_pool(jq, p) ? p : NULL;
+    if( *dequeued )
+        unlink_job(jq, *dequeued);
+}
+
+static void walk(PCB * t, JOBQ_VISIT visit, void * arg)
+{
+    if( t == NULL )
         return;
-    }
-    else{
-        if( jq->head->PID == pid ){
-            *dequeued = jq->head;
-            if( jq->head == jq->tail ){
-                jq->head = jq->tail = NULL;
-            }
-            else{
-                jq->head = jq->head->LINK;
-            }
-            (*dequeued)->LINK = NULL;
-        }
-        else{
-            PCB * curr_ptr = jq->head;
-            while( curr_ptr->LINK ){
-                if( curr_ptr->LINK->PID == pid ){
-                    *dequeued = curr_ptr->LINK;
-                    if( curr_ptr->LINK == jq->tail ){
-                        jq->tail = curr_ptr;
-                        curr_ptr->LINK = (*dequeued)->LINK;
-                    }
-                    else{
-                       curr_ptr->LINK = (*dequeued)->LINK;
-                    }
-                    (*dequeued)->LINK = NULL;
-                    return;
-                }
-                else
-                    curr_ptr = curr_ptr->LINK;
-            }
-            if( curr_ptr->LINK == NULL )
-                *dequeued = NULL;
-        }
-    }
+    walk(JQ(t)->jq_left, visit, arg);
+    visit(t, arg);
+    walk(JQ(t)->jq_right, visit, arg);
+}
+
+void JOBQ_walk(JOBQ * jq, JOBQ_VISIT visit, void * arg)
+{
+    walk(jq->root, visit, arg);
+}
+
+static void free_tree(PCB * t)
+{
+    if( t == NULL )
+        return;
+    free_tree(JQ(t)->jq_left);
+    free_tree(JQ(t)->jq_right);
+    PCB_free(t);
 }
 
 void JOBQ_free(JOBQ * jq)
 {
-    PCB * curr_ptr = jq->head;
-    PCB * prev_ptr = jq->head;
-    while( curr_ptr ){
-        curr_ptr = curr_ptr->LINK;
-        PCB_free(prev_ptr);
-        prev_ptr = curr_ptr;
-    }
+    free_tree(jq->root);
     free(jq);
 }
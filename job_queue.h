@@ -1,35 +1,72 @@
 /** \file   job_queue.h
  *          Interface for JOBQ object. 
  *          Priority queue with higher priority being a larger requested 
- *          process size. */
+ *          process size.
+ *
+ *          With aging, a job gains aging words of priority for every ms
+ *          it waits, so small jobs can't be passed over forever by a
+ *          stream of large ones that fit. A job that has waited
+ *          max_proc_size / aging ms is ahead of anything that arrives
+ *          after it.
+ *
+ *          The pool is a treap ordered by priority, each node also keeping
+ *          the smallest process size below it, so the first job in order
+ *          that fits is found in O(log n). Priority is proc_size plus
+ *          aging times the wait, which is proc_size - aging * (time queued)
+ *          plus the same aging * now for everybody: the key is fixed at
+ *          enqueue and the tree never has to be rebuilt. */
 
 #ifndef JOBQ_
 #define JOBQ_
 
 #include "pcb.h"
 
+/** Callback for walking the job pool. */
+typedef void (*JOBQ_VISIT)(PCB * pcb, void * arg);
+
 /** Struct JOBQ */
 typedef struct JOBQ {
-    PCB *   head;
-    PCB *   tail; 
+    PCB *           root;
+    int             count;      // Queued processes,
+    long            WORDS;      //   and their sizes summed.
+    double          aging;      // Words of priority gained per ms waited.
+    const double *  clock;      // Simulation clock.
+    long            next_seq;   // Arrival number of the next job.
+
+    /** Statistics */
+    double          WAIT_MAX;   // Longest wait in the pool, ms.
 } JOBQ;
 
-JOBQ *JOBQ_new(); 
+/** \param  aging is the aging rate, 0 for none.
+ *  \param  clock points at the simulation clock waits are timed by. */
+JOBQ *JOBQ_new(double aging, const double * clock); 
 
 void JOBQ_enqueue(JOBQ * jq, PCB * insert); 
 
 /** This is a dequeueing operation intended for after memory space clears 
  *  up and it is possible that a process which hasn't fit before can perhaps
- *  now fit into memory. As such there is a search key, p_size, which 
- *  goes through the queue starting from the largest process and checks 
- *  to see if there is any item less than or equal to p_size, which is 
- *  the amount of memory available in the system. 
+ *  now fit into memory. As such there is a search key, p_size, and the
+ *  process of highest priority whose size is less than or equal to
+ *  p_size, the amount of memory available in the system, is taken.
  *
  *  NULL is returned in dequeued if no such process is found. */
 void JOBQ_dequeue(JOBQ * jq, PCB **  dequeued, int p_size);
 
+/** Put back a job taken out by JOBQ_dequeue(), in the place it had and
+ *  with the wait it had. */
+void JOBQ_putback(JOBQ * jq, PCB * job);
+
+/** \return the job of highest priority, NULL if the pool is empty. */
+PCB *JOBQ_peek(JOBQ * jq);
+
+/** Take the job with PID pid out of the pool, NULL in dequeued if it isn't
+ *  there. The PCB comes from the process table, and its key leads to it
+ *  in the tree, so this takes O(log n). */
 void JOBQ_kill(JOBQ * jq, PCB ** dequeued, int pid);
 
+/** Visit each job, highest priority first. */
+void JOBQ_walk(JOBQ * jq, JOBQ_VISIT visit, void * arg);
+
 void JOBQ_free(JOBQ * jq);
 
 #endif
@@ -0,0 +1,1255 @@
+/** \file
+ *  memory.c:   Implementation for frame allocation, copy-on-write, shared
+ *              memory segments, swapping and working set control. */
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "memory.h"
+#include "sysgen.h"
+#include "dispatcher.h"
+
+/** Cut frames a to a+n out of free run k. */
+static void carve(frame_list * fl, int k, int a, int n)
+{
+    FRAME_RUN * r = &fl->runs[k];
+    if( r->len == fl->largest )
+        fl->largest = -1;
+    int left = a - r->start;
+    int right = r->start + r->len - (a + n);
+    if( left > 0 && right > 0 ){
+        if( fl->count == fl->cap ){
+            fl->cap *= 2;
+            fl->runs = realloc( fl->runs, sizeof(FRAME_RUN) * fl->cap );
+            r = &fl->runs[k];
+        }
+        memmove(r + 2, r + 1, sizeof(FRAME_RUN) * (fl->count - k - 1));
+        fl->count++;
+        r[1] = (FRAME_RUN){ .start = a + n, .len = right };
+        r->len = left;
+    }
+    else if( left > 0 )
+        r->len = left;
+    else if( right > 0 )
+        *r = (FRAME_RUN){ .start = a + n, .len = right };
+    else{
+        memmove(r, r + 1, sizeof(FRAME_RUN) * (fl->count - k - 1));
+        fl->count--;
+    }
+}
+
+/** \return a run of up to n frames taken off the free list: the start of
+ *          the smallest free run that holds all n, or else the whole
+ *          highest run. The caller has checked a frame is free. */
+static FRAME_RUN take_frames(SYSGEN * sys, int n)
+{
+    frame_list * fl = &sys->frame_bag;
+    int best = -1;
+    for(int k = 0; k < fl->count; k++)
+        if(    fl->runs[k].len >= n
+            && (best < 0 || fl->runs[k].len < fl->runs[best].len) )
+            best = k;
+    if( best < 0 )
+        best = fl->count - 1;
+    FRAME_RUN run = fl->runs[best];
+    if( run.len > n )
+        run.len = n;
+    carve(fl, best, run.start, run.len);
+    sys->num_free_frames -= run.len;
+    return run;
+}
+
+/** Put frames start to start+len back on the free list, merging them
+ *  with the runs next to them. */
+static void put_frames(SYSGEN * sys, int start, int len)
+{
+    frame_list * fl = &sys->frame_bag;
+    int lo = 0;
+    int hi = fl->count;
+    while( lo < hi ){
+        int mid = (lo + hi) / 2;
+        if( fl->runs[mid].start < start )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    sys->num_free_frames += len;
+    FRAME_RUN * prev = lo > 0 ? &fl->runs[lo-1] : NULL;
+    FRAME_RUN * next = lo < fl->count ? &fl->runs[lo] : NULL;
+    int join_prev = prev && prev->start + prev->len == start;
+    int join_next = next && start + len == next->start;
+    FRAME_RUN * run;
+    if( join_prev && join_next ){
+        prev->len += len + next->len;
+        memmove(next, next + 1, sizeof(FRAME_RUN) * (fl->count - lo - 1));
+        fl->count--;
+        run = prev;
+    }
+    else if( join_prev ){
+        prev->len += len;
+        run = prev;
+    }
+    else if( join_next ){
+        next->start = start;
+        next->len += len;
+        run = next;
+    }
+    else{
+        if( fl->count == fl->cap ){
+            fl->cap *= 2;
+            fl->runs = realloc( fl->runs, sizeof(FRAME_RUN) * fl->cap );
+        }
+        memmove(&fl->runs[lo+1], &fl->runs[lo],
+                sizeof(FRAME_RUN) * (fl->count - lo));
+        fl->runs[lo] = (FRAME_RUN){ .start = start, .len = len };
+        fl->count++;
+        run = &fl->runs[lo];
+    }
+    if( fl->largest >= 0 && run->len > fl->largest )
+        fl->largest = run->len;
+}
+
+int MEM_largest_free(SYSGEN * sys)
+{
+    frame_list * fl = &sys->frame_bag;
+    if( fl->largest < 0 ){
+        fl->largest = 0;
+        for(int k = 0; k < fl->count; k++)
+            if( fl->runs[k].len > fl->largest )
+                fl->largest = fl->runs[k].len;
+    }
+    return fl->largest;
+}
+
+/** \return 1 if a goes before b on the swap-out heap: more private pages,
+ *          or as many and an earlier slot in the process table. */
+static int victim_before(PCB * a, PCB * b)
+{
+    int pa = PCB_mem(a)->private;
+    int pb = PCB_mem(b)->private;
+    return pa > pb || (pa == pb && a->slot < b->slot);
+}
+
+static void heap_set(SWAP * sw, int i, PCB * pcb)
+{
+    sw->heap[i] = pcb;
+    PCB_mem(pcb)->swap_idx = i;
+}
+
+static void sift_up(SWAP * sw, int i)
+{
+    PCB * p = sw->heap[i];
+    while( i > 0 ){
+        int parent = (i - 1) / 2;
+        if( !victim_before(p, sw->heap[parent]) )
+            break;
+        heap_set(sw, i, sw->heap[parent]);
+        i = parent;
+    }
+    heap_set(sw, i, p);
+}
+
+static void sift_down(SWAP * sw, int i)
+{
+    PCB * p = sw->heap[i];
+    for(;;){
+        int child = 2*i + 1;
+        if( child >= sw->heap_n )
+            break;
+        if(    child + 1 < sw->heap_n
+            && victim_before(sw->heap[child+1], sw->heap[child]) )
+            child++;
+        if( !victim_before(sw->heap[child], p) )
+            break;
+        heap_set(sw, i, sw->heap[child]);
+        i = child;
+    }
+    heap_set(sw, i, p);
+}
+
+static void heap_push(SWAP * sw, PCB * pcb)
+{
+    if( sw->heap_n == sw->heap_cap ){
+        sw->heap_cap = sw->heap_cap ? 2 * sw->heap_cap : 64;
+        sw->heap = realloc(sw->heap, sizeof(PCB*) * sw->heap_cap);
+        sw->pick = realloc(sw->pick, sizeof(PCB*) * sw->heap_cap);
+    }
+    sw->heap[sw->heap_n] = pcb;
+    sift_up(sw, sw->heap_n++);
+}
+
+/** Take pcb off the swap-out heap, if it is there. */
+static void heap_remove(SWAP * sw, PCB * pcb)
+{
+    int i = PCB_mem(pcb)->swap_idx;
+    if( i < 0 )
+        return;
+    sw->heap_n--;
+    if( i != sw->heap_n ){
+        PCB * moved = sw->heap[sw->heap_n];
+        heap_set(sw, i, moved);
+        sift_up(sw, i);
+        sift_down(sw, PCB_mem(moved)->swap_idx);
+    }
+    PCB_mem(pcb)->swap_idx = -1;
+}
+
+/** Add d to the private pages of pcb, keeping its place on the swap-out
+ *  heap. */
+static void add_private(SYSGEN * sys, PCB * pcb, int d)
+{
+    PCB_MEM * mem = PCB_mem(pcb);
+    mem->private += d;
+    if( mem->swap_idx >= 0 ){
+        sift_up(sys->SWAP, mem->swap_idx);
+        sift_down(sys->SWAP, mem->swap_idx);
+    }
+}
+
+/** Give pages from page on of pcb the frames of run, fresh off the free
+ *  list, as their only mapping. */
+static void own_run(SYSGEN * sys, PCB * pcb, int page, FRAME_RUN run)
+{
+    frame * f = &sys->frame_table[run.start];
+    for(int i = 0; i < run.len; i++){
+        f[i].PID = pcb->PID;
+        f[i].PAGE_NUM = page + i;
+        f[i].REF = 1;
+        f[i].owner = pcb;
+    }
+    PCB_mem(pcb)->resident += run.len;
+    add_private(sys, pcb, run.len);
+    RG_frames(PCB_acct(pcb)->GROUP, run.len);
+}
+
+/** Take back run, frames only pcb maps, and put them on the free list;
+ *  own_run() undone. */
+static void disown_run(SYSGEN * sys, PCB * pcb, FRAME_RUN run)
+{
+    frame * f = &sys->frame_table[run.start];
+    for(int i = 0; i < run.len; i++){
+        f[i].PID = -1;
+        f[i].PAGE_NUM = -1;
+        f[i].REF = 0;
+        f[i].owner = NULL;
+    }
+    PCB_mem(pcb)->resident -= run.len;
+    add_private(sys, pcb, -run.len);
+    RG_frames(PCB_acct(pcb)->GROUP, -run.len);
+    put_frames(sys, run.start, run.len);
+}
+
+/** Count frame f, which one process maps, in (sign 1) or out (sign -1) of
+ *  that process' private pages. */
+static void count_private(SYSGEN * sys, frame * f, int sign)
+{
+    if( !f->SHM )
+        add_private(sys, f->owner, sign);
+}
+
+/** Record that page of pcb maps frame num. The first mapping is kept in
+ *  the frame itself, and the frame is charged to its group; only sharers
+ *  get a reverse map entry. */
+static void rmap_add(SYSGEN * sys, int num, PCB * pcb, int page)
+{
+    frame * f = &sys->frame_table[num];
+    PCB_mem(pcb)->resident++;
+    if( f->REF++ == 0 ){
+        f->PID = pcb->PID;
+        f->PAGE_NUM = page;
+        f->owner = pcb;
+        count_private(sys, f, 1);
+        RG_frames(PCB_acct(pcb)->GROUP, 1);
+        return;
+    }
+    if( f->REF == 2 )
+        count_private(sys, f, -1);
+    RMAP * r = malloc( sizeof(RMAP) );
+    *r = (RMAP){ .next = f->rmap, .pcb = pcb, .page = page };
+    f->rmap = r;
+    sys->FRAMES_SHARED++;
+}
+
+/** \return a frame off the free list, mapped by page of pcb. */
+static int take_frame(SYSGEN * sys, PCB * pcb, int page)
+{
+    FRAME_RUN run = take_frames(sys, 1);
+    own_run(sys, pcb, page, run);
+    return run.start;
+}
+
+/** Drop pcb's mapping of frame num. If pcb was the first mapping, PID,
+ *  PAGE_NUM and the group charge move on to the next one.
+ *  \return 1 if that was the last mapping and the frame is free now; it
+ *          is up to the caller to put it back on the free list. */
+static int drop_frame(SYSGEN * sys, int num, PCB * pcb)
+{
+    frame * f = &sys->frame_table[num];
+    PCB_mem(pcb)->resident--;
+    if( --f->REF == 0 ){
+        count_private(sys, f, -1);
+        f->PID = -1;
+        f->PAGE_NUM = -1;
+        f->owner = NULL;
+        f->SHM = 0;
+        RG_frames(PCB_acct(pcb)->GROUP, -1);
+        return 1;
+    }
+    sys->FRAMES_SHARED--;
+
+    RMAP ** link = &f->rmap;
+    if( f->owner == pcb ){
+        f->owner = f->rmap->pcb;
+        f->PID = f->rmap->pcb->PID;
+        f->PAGE_NUM = f->rmap->page;
+        RG_frames(PCB_acct(pcb)->GROUP, -1);
+        RG_frames(PCB_acct(f->owner)->GROUP, 1);
+    }
+    else
+        while( (*link)->pcb != pcb )
+            link = &(*link)->next;
+    RMAP * r = *link;
+    *link = r->next;
+    free(r);
+    if( f->REF == 1 )
+        count_private(sys, f, 1);
+    return 0;
+}
+
+/** Drop pcb's mapping of frame num, freeing the frame with the last one. */
+static void put_frame(SYSGEN * sys, int num, PCB * pcb)
+{
+    if( drop_frame(sys, num, pcb) )
+        put_frames(sys, num, 1);
+}
+
+/** \return the frames processes can have: all but the buffer cache's. */
+static int user_frames(SYSGEN * sys)
+{
+    return sys->num_frames - (sys->CACHE ? sys->CACHE->capacity : 0);
+}
+
+/** \return the frames left before the working sets fill memory, all of
+ *          them without working set control. */
+static int ws_room(SYSGEN * sys)
+{
+    if( sys->WS == NULL )
+        return sys->num_frames;
+    int room = user_frames(sys) - sys->WS->SUM;
+    return room > 0 ? room : 0;
+}
+
+/** Count pcb's working set in (sign 1) or out (sign -1) of the sum. */
+static void ws_count(SYSGEN * sys, PCB * pcb, int sign)
+{
+    if( sys->WS )
+        sys->WS->SUM += sign * PCB_mem(pcb)->wss;
+}
+
+int MEM_room(SYSGEN * sys)
+{
+    int room = ws_room(sys);
+    return room < sys->num_free_frames ? room : sys->num_free_frames;
+}
+
+/** \return the frames pcb's group may still take. */
+static int group_room(PCB * pcb)
+{
+    return RG_frame_room(PCB_acct(pcb)->GROUP);
+}
+
+int MEM_load_pages(SYSGEN * sys, PCB * pcb)
+{
+    return sys->PT->levels > 1 ? 1 : PCB_mem(pcb)->num_pages;
+}
+
+void MEM_map(SYSGEN * sys, PCB * pcb)
+{
+    PCB_MEM * mem = PCB_mem(pcb);
+    int n = MEM_load_pages(sys, pcb);
+
+    /** Loading the process references the pages it is loaded with. They
+     *  are given frames a free run at a time. */
+    for(int page = 0; page < n; ){
+        FRAME_RUN run = take_frames(sys, n - page);
+        own_run(sys, pcb, page, run);
+        PT_fill(mem->page_table, page, run.start | PTE_REF, run.len);
+        page += run.len;
+    }
+    mem->frames = mem->num_pages;
+    mem->wss = n;
+    ws_count(sys, pcb, 1);
+}
+
+/** Drop segments whose frames nobody maps any more. */
+static void shm_reap(SYSGEN * sys)
+{
+    SHM_SEG ** link = &sys->SEGMENTS;
+    while( *link ){
+        SHM_SEG * seg = *link;
+        if( sys->frame_table[seg->frames[0]].REF > 0 ){
+            link = &seg->next;
+            continue;
+        }
+        *link = seg->next;
+        free(seg->frames);
+        free(seg->name);
+        free(seg);
+    }
+}
+
+/** Give a swap slot back. */
+static void put_slot(SWAP * sw, int slot)
+{
+    sw->map[slot] = 0;
+    sw->free++;
+}
+
+void MEM_unmap(SYSGEN * sys, PCB * pcb)
+{
+    PCB_MEM * mem = PCB_mem(pcb);
+    PTABLE * pt = mem->page_table;
+    int shm = 0;
+    if( mem->suspended <= 0 )
+        ws_count(sys, pcb, -1);
+    if( sys->SWAP )
+        heap_remove(sys->SWAP, pcb);
+
+    /** Frames only pcb maps are gathered into runs of consecutive frames
+     *  and given back a run at a time. Copy-on-write and shared frames 
+     *  are dropped one by one, as others may still map them. */
+    FRAME_RUN run = { .len = 0 };
+    for(int i = PT_next(pt, 0); i >= 0; i = PT_next(pt, i + 1)){
+        int pte = PT_get(pt, i);
+        int num = PTE_FRAME(pte);
+        shm |= pte & PTE_SHM;
+        if( pte & PTE_SWAP ){
+            put_slot(sys->SWAP, num);
+            continue;
+        }
+        if( (pte & (PTE_COW | PTE_SHM)) || sys->frame_table[num].REF > 1 ){
+            put_frame(sys, num, pcb);
+            continue;
+        }
+        if( run.len > 0 && num == run.start + run.len ){
+            run.len++;
+            continue;
+        }
+        if( run.len > 0 )
+            disown_run(sys, pcb, run);
+        run = (FRAME_RUN){ .start = num, .len = 1 };
+    }
+    if( run.len > 0 )
+        disown_run(sys, pcb, run);
+    PT_reset(pt);
+    mem->swapped = 0;
+    mem->suspended = 0;
+    mem->wss = 0;
+    if( shm )
+        shm_reap(sys);
+}
+
+/** \return the largest process the job pool may admit: one that fits in
+ *          the free frames, or any while a frame is free if processes are
+ *          loaded on demand. */
+static int admit_size(SYSGEN * sys)
+{
+    int room = MEM_room(sys);
+    if( sys->PT->levels > 1 )
+        return room > 0 ? INT_MAX : 0;
+    return room * sys->frame_size;
+}
+
+void MEM_admit_jobs(SYSGEN * sys)
+{
+    PCB * does_it_blend;
+    PCB * over = NULL;
+    int free_mem = admit_size(sys);
+    JOBQ_dequeue(sys->JOB_QUEUE, &does_it_blend, free_mem);
+    while( does_it_blend ){
+
+        /** A job whose group is at its frame quota is set aside and put
+         *  back in its place afterwards. */
+        if( MEM_load_pages(sys, does_it_blend) > group_room(does_it_blend) ){
+            does_it_blend->LINK = over;
+            over = does_it_blend;
+        }
+        else{
+            MEM_map(sys, does_it_blend);
+            READYQ_enqueue(sys->READY_QUEUE, does_it_blend);
+
+            /** Update amount of free memory available. */
+            free_mem = admit_size(sys);
+        }
+
+        /** Search the job pool again. */
+        JOBQ_dequeue(sys->JOB_QUEUE, &does_it_blend, free_mem);
+    }
+    while( over ){
+        PCB * job = over;
+        over = job->LINK;
+        JOBQ_putback(sys->JOB_QUEUE, job);
+    }
+}
+
+SWAP *MEM_swap_new(SYSGEN * sys, int disk, int slots)
+{
+    FSYS * fs = sys->FILESYS[disk-1];
+    SWAP * sw = calloc( 1, sizeof(SWAP) );
+    sw->disk = disk;
+    sw->slots = slots;
+    sw->base = fs->total - slots;
+    sw->map = calloc( slots, sizeof(unsigned char) );
+    sw->free = slots;
+
+    /** The file system keeps off the swap area. */
+    for(unsigned int b = sw->base; b < fs->total; b++)
+        fs->used[b] = 1;
+    fs->USED_n += slots;
+    if( sys->VOL )
+        VOLUME_reserve(sys->VOL, disk, sw->base, slots);
+    return sw;
+}
+
+/** \return a free swap slot, next fit. The caller has checked there is
+ *          one. */
+static int take_slot(SWAP * sw)
+{
+    while( sw->map[sw->rotor] )
+        sw->rotor = (sw->rotor + 1) % sw->slots;
+    int slot = sw->rotor;
+    sw->map[slot] = 1;
+    sw->free--;
+    sw->rotor = (sw->rotor + 1) % sw->slots;
+    return slot;
+}
+
+/** \return the cylinder holding a swap slot. */
+static int slot_cylinder(SYSGEN * sys, int slot)
+{
+    SWAP * sw = sys->SWAP;
+    return (sw->base + slot) / sys->FILESYS[sw->disk-1]->blocks_per_cyl + 1;
+}
+
+/** Queue a transfer of len slots from first at the swap disk. Page-ins
+ *  block pcb; page-outs are the kernel's own. */
+static void swap_io(SYSGEN * sys, PCB * pcb, char rw, int first, int len)
+{
+    SWAP * sw = sys->SWAP;
+    PARAMS obj = {  .CYLINDER = slot_cylinder(sys, first),
+                    .FILE_NAME = strdup("swap"),
+                    .MEM_START = 0,
+                    .READ_WRITE = rw,
+                    .FILE_LEN = len * sys->frame_size,
+                    .FILE_OFF = first * sys->frame_size };
+    D_NODE * req = D_NODE_new(pcb, obj);
+    req->SWAP = 1;
+    if( pcb )
+        PCB_acct(pcb)->IO_PENDING++;
+    DISKQ_enqueue(sys->DISKS[sw->disk-1], req);
+    DEVICE_submit(DEVICE_lookup(sys, DEVICE_DISK, sw->disk));
+}
+
+/** Slots are transferred in runs that are consecutive on one cylinder. */
+typedef struct SWAP_RUN {
+    int                 first;
+    int                 len;
+} SWAP_RUN;
+
+static void run_add(SYSGEN * sys, PCB * pcb, char rw, SWAP_RUN * run,
+                    int slot)
+{
+    if(    run->len > 0 && slot == run->first + run->len
+        && slot_cylinder(sys, slot) == slot_cylinder(sys, run->first) ){
+        run->len++;
+        return;
+    }
+    if( run->len > 0 )
+        swap_io(sys, pcb, rw, run->first, run->len);
+    *run = (SWAP_RUN){ .first = slot, .len = 1 };
+}
+
+static void run_end(SYSGEN * sys, PCB * pcb, char rw, SWAP_RUN * run)
+{
+    if( run->len > 0 )
+        swap_io(sys, pcb, rw, run->first, run->len);
+}
+
+/** \return 1 if a page table entry maps a frame nobody else maps. */
+static int private_page(SYSGEN * sys, int pte)
+{
+    return    !(pte & (PTE_SHM | PTE_SWAP))
+           && sys->frame_table[PTE_FRAME(pte)].REF == 1;
+}
+
+/** Write private page i of pcb out to a free swap slot, splitting the
+ *  large page it is in.
+ *  \param  run collects the writes. */
+static void page_out(SYSGEN * sys, PCB * pcb, int i, SWAP_RUN * run)
+{
+    PCB_MEM * mem = PCB_mem(pcb);
+    int slot = take_slot(sys->SWAP);
+    int * pte = PT_entry(mem->page_table, i);
+    put_frame(sys, PTE_FRAME(*pte), pcb);
+    *pte = slot | PTE_SWAP | (*pte & PTE_REF);
+    mem->swapped++;
+    run_add(sys, NULL, 'w', run, slot);
+}
+
+/** Suspend pcb: write its private pages to swap and free their frames. */
+static void swap_out(SYSGEN * sys, PCB * pcb)
+{
+    SWAP * sw = sys->SWAP;
+    PCB_MEM * mem = PCB_mem(pcb);
+    PTABLE * pt = mem->page_table;
+    SWAP_RUN run = { .len = 0 };
+    int n = 0;
+    heap_remove(sw, pcb);
+    for(int i = PT_next(pt, 0); i >= 0; i = PT_next(pt, i + 1))
+        if( private_page(sys, PT_get(pt, i)) ){
+            page_out(sys, pcb, i, &run);
+            n++;
+        }
+    run_end(sys, NULL, 'w', &run);
+    mem->suspended = 1;
+    ws_count(sys, pcb, -1);
+    sw->SWAP_OUT_n++;
+    sw->PAGES_OUT_n += n;
+    printf("PID %d swapped out: %d page(s).\n", pcb->PID, n);
+}
+
+/** \return the number of pages swapping pcb in reads: those on swap, up
+ *          to its allocation and its group's quota. Shared segment pages
+ *          stayed resident and don't count against the allocation, which
+ *          PFF may have shrunk below them. */
+static int swapin_pages(PCB * pcb)
+{
+    PCB_MEM * mem = PCB_mem(pcb);
+    int room = mem->frames - (mem->resident - mem->shm_pages);
+    if( group_room(pcb) < room )
+        room = group_room(pcb);
+    if( room < 0 )
+        room = 0;
+    return mem->swapped < room ? mem->swapped : room;
+}
+
+/** Read the pages of pcb back into frames of their own, its working set
+ *  first, up to its allocation. pcb stays blocked until the reads
+ *  complete; with nothing to read it is ready at once, and the pages left
+ *  on swap fault back in as it runs. */
+static void swap_in(SYSGEN * sys, PCB * pcb)
+{
+    SWAP * sw = sys->SWAP;
+    PCB_MEM * mem = PCB_mem(pcb);
+    PTABLE * pt = mem->page_table;
+    unsigned char mask = sys->WS ? (1 << sys->WS->window) - 1 : 0;
+    int n = swapin_pages(pcb);
+    int left = n;
+    SWAP_RUN run = { .len = 0 };
+    for(int pass = 0; pass < 2; pass++)
+        for(int i = PT_next(pt, 0); i >= 0 && left > 0;
+                i = PT_next(pt, i + 1)){
+            int pte = PT_get(pt, i);
+            if(    !(pte & PTE_SWAP)
+                || (pass == 0 && !(*PT_hist(pt, i) & mask)) )
+                continue;
+            int slot = PTE_FRAME(pte);
+            *PT_entry(pt, i) = take_frame(sys, pcb, i) | (pte & PTE_REF);
+            put_slot(sw, slot);
+            mem->swapped--;
+            left--;
+            run_add(sys, pcb, 'r', &run, slot);
+        }
+    run_end(sys, pcb, 'r', &run);
+    ws_count(sys, pcb, 1);
+    sw->SWAP_IN_n++;
+    sw->PAGES_IN_n += n;
+    if( n == 0 ){
+        mem->suspended = 0;
+        printf("PID %d swapped in: no room to read its pages.\n", pcb->PID);
+        READYQ_enqueue(sys->READY_QUEUE, pcb);
+        return;
+    }
+    mem->suspended = -1;
+    printf("PID %d swapping in: %d page(s).\n", pcb->PID, n);
+}
+
+/** Swap out blocked processes, most private pages first, until need
+ *  frames are free. Candidates come off the swap-out heap largest first;
+ *  one whose pages don't fit in the slots the ones before it leave is
+ *  skipped. The same picks are swapped out, and only if they make room
+ *  enough; the rest go back on the heap.
+ *  \return 1 if need frames are free. */
+static int make_room(SYSGEN * sys, int need)
+{
+    SWAP * sw = sys->SWAP;
+    if( need <= sys->num_free_frames )
+        return 1;
+
+    int room = sys->num_free_frames;
+    int slots = sw->free;
+    int n = 0;
+    while(    room < need && sw->heap_n > 0
+           && PCB_mem(sw->heap[0])->private > 0 ){
+        PCB * p = sw->heap[0];
+        heap_remove(sw, p);
+        sw->pick[n++] = p;
+        int k = PCB_mem(p)->private;
+        if( k <= slots ){
+            room += k;
+            slots -= k;
+        }
+    }
+
+    int ok = room >= need;
+    slots = sw->free;
+    for(int i = 0; i < n; i++){
+        PCB * p = sw->pick[i];
+        int k = PCB_mem(p)->private;
+        if( ok && k <= slots ){
+            slots -= k;
+            swap_out(sys, p);
+        }
+        else
+            heap_push(sw, p);
+    }
+    return ok;
+}
+
+void MEM_balance(SYSGEN * sys)
+{
+    SWAP * sw = sys->SWAP;
+    while( sw && sw->head ){
+        PCB * pcb = sw->head;
+        if(    PCB_mem(pcb)->wss > ws_room(sys)
+            || group_room(pcb) == 0
+            || !make_room(sys, swapin_pages(pcb)) )
+            break;
+        sw->head = pcb->LINK;
+        if( sw->head == NULL )
+            sw->tail = NULL;
+        pcb->LINK = NULL;
+        sw->WAIT_n--;
+        swap_in(sys, pcb);
+    }
+
+    /** Jobs wait for the swap queue to drain. */
+    MEM_admit_jobs(sys);
+    while( sw && sw->head == NULL && JOBQ_peek(sys->JOB_QUEUE) ){
+        PCB * job = JOBQ_peek(sys->JOB_QUEUE);
+        int need = MEM_load_pages(sys, job);
+        if(    need > ws_room(sys) || need > group_room(job)
+            || !make_room(sys, need) )
+            break;
+        MEM_admit_jobs(sys);
+    }
+}
+
+/** Put pcb at the end of the swap queue. */
+static void swapq_add(SYSGEN * sys, PCB * pcb)
+{
+    SWAP * sw = sys->SWAP;
+    pcb->LINK = NULL;
+    if( sw->tail )
+        sw->tail->LINK = pcb;
+    else
+        sw->head = pcb;
+    sw->tail = pcb;
+    sw->WAIT_n++;
+}
+
+void MEM_block(SYSGEN * sys, PCB * pcb)
+{
+    if( sys->SWAP && PCB_mem(pcb)->suspended == 0 )
+        heap_push(sys->SWAP, pcb);
+}
+
+int MEM_wake(SYSGEN * sys, PCB * pcb)
+{
+    PCB_MEM * mem = PCB_mem(pcb);
+    if( sys->SWAP )
+        heap_remove(sys->SWAP, pcb);
+    if( mem->suspended <= 0 ){
+        mem->suspended = 0;
+        return 1;
+    }
+    swapq_add(sys, pcb);
+    printf("PID %d is ready but swapped out.\n", pcb->PID);
+    return 0;
+}
+
+PCB *MEM_swapq_kill(SYSGEN * sys, int pid)
+{
+    SWAP * sw = sys->SWAP;
+    if( sw == NULL )
+        return NULL;
+    PCB * prev = NULL;
+    for(PCB * p = sw->head; p; prev = p, p = p->LINK){
+        if( p->PID != pid )
+            continue;
+        if( prev )
+            prev->LINK = p->LINK;
+        else
+            sw->head = p->LINK;
+        if( sw->tail == p )
+            sw->tail = prev;
+        p->LINK = NULL;
+        sw->WAIT_n--;
+        return p;
+    }
+    return NULL;
+}
+
+/** Local replacement: page out one of pcb's private pages, clock order,
+ *  giving referenced pages a second chance. Pages first to last are about
+ *  to be used and stay.
+ *  \return 1 if a page went out. */
+static int replace_page(SYSGEN * sys, PCB * pcb, int first, int last)
+{
+    PCB_MEM * mem = PCB_mem(pcb);
+    PTABLE * pt = mem->page_table;
+    if( sys->SWAP == NULL || sys->SWAP->free == 0 )
+        return 0;
+    for(int step = 0; step < 2 * (mem->resident + mem->swapped); step++){
+        int i = PT_next(pt, mem->hand);
+        if( i < 0 )
+            i = PT_next(pt, 0);
+        mem->hand = i + 1;
+        int pte = PT_get(pt, i);
+        if( (i >= first && i <= last) || !private_page(sys, pte) )
+            continue;
+        if( pte & PTE_REF ){
+            PT_clear(pt, i, PTE_REF);
+            continue;
+        }
+        SWAP_RUN run = { .len = 0 };
+        page_out(sys, pcb, i, &run);
+        run_end(sys, NULL, 'w', &run);
+        return 1;
+    }
+    return 0;
+}
+
+/** Make sure a frame is free for page of pcb, replacing one of its own
+ *  pages if it is at its allocation, its group is at its quota or memory
+ *  is full. Pages first to last are the ones being touched.
+ *  \return 1 if there is one. */
+static int fault_frame(SYSGEN * sys, PCB * pcb, int page, int first,
+                       int last)
+{
+    PCB_MEM * mem = PCB_mem(pcb);
+    if(    (   mem->resident >= mem->frames || sys->num_free_frames == 0
+            || group_room(pcb) == 0)
+        && !replace_page(sys, pcb, first, last) ){
+        if( group_room(pcb) == 0 ){
+            PCB_acct(pcb)->GROUP->QUOTA_n++;
+            printf("Page fault on page %d of PID %d: group %d is at its"
+                   " frame quota.\n", page, pcb->PID,
+                    PCB_acct(pcb)->GROUP->NUM);
+            return 0;
+        }
+        if( sys->num_free_frames == 0 ){
+            printf("Page fault on page %d of PID %d: no free frame.\n",
+                    page, pcb->PID);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/** Count a page fault of pcb. */
+static void fault_count(SYSGEN * sys, PCB * pcb)
+{
+    PCB_MEM * mem = PCB_mem(pcb);
+    if( mem->resident > mem->frames )
+        mem->frames = mem->resident;
+    mem->faults++;
+    if( sys->WS )
+        sys->WS->FAULT_n++;
+}
+
+/** Fault page of pcb in from swap. Pages first to last are the ones being
+ *  touched.
+ *  \return 1 if the read is queued. */
+static int page_fault(SYSGEN * sys, PCB * pcb, int page, int first, int last)
+{
+    PCB_MEM * mem = PCB_mem(pcb);
+    if( !fault_frame(sys, pcb, page, first, last) )
+        return 0;
+    int * pte = PT_entry(mem->page_table, page);
+    int slot = PTE_FRAME(*pte);
+    *pte = take_frame(sys, pcb, page);
+    put_slot(sys->SWAP, slot);
+    mem->swapped--;
+    swap_io(sys, pcb, 'r', slot, 1);
+    fault_count(sys, pcb);
+    printf("Page fault: page %d of PID %d read in from swap to frame %d.\n",
+            page, pcb->PID, *pte);
+    return 1;
+}
+
+/** \return the first of n free frames in a row, aligned to n, taken off
+ *          the free list for pages from page on of pcb; -1 if there are
+ *          none. */
+static int take_aligned(SYSGEN * sys, PCB * pcb, int page, int n)
+{
+    frame_list * fl = &sys->frame_bag;
+    for(int k = 0; k < fl->count; k++){
+        FRAME_RUN * r = &fl->runs[k];
+        int a = (r->start + n - 1) / n * n;
+        if( a + n > r->start + r->len )
+            continue;
+        carve(fl, k, a, n);
+        sys->num_free_frames -= n;
+        own_run(sys, pcb, page, (FRAME_RUN){ .start = a, .len = n });
+        return a;
+    }
+    return -1;
+}
+
+/** Give page of pcb a zero-filled frame. If its large page fits in the
+ *  allocation and an aligned run of frames is free for it, the whole large
+ *  page is mapped instead. The caller has checked a frame is free.
+ *  \return the pages mapped. */
+static int zero_fill(SYSGEN * sys, PCB * pcb, int page)
+{
+    PCB_MEM * mem = PCB_mem(pcb);
+    int n = PT_large_pages(sys->PT);
+    if(    PT_large_fits(mem->page_table, page)
+        && mem->resident + n <= mem->frames && n <= group_room(pcb) ){
+        int base = take_aligned(sys, pcb, page & ~(n - 1), n);
+        if( base >= 0 ){
+            PT_map_large(mem->page_table, page, base);
+            return n;
+        }
+    }
+    *PT_entry(mem->page_table, page) = take_frame(sys, pcb, page);
+    return 1;
+}
+
+/** Demand fault page of pcb, which has never been touched, into a frame
+ *  of its own. Pages first to last are the ones being touched.
+ *  \return 1 if it is mapped. */
+static int zero_fault(SYSGEN * sys, PCB * pcb, int page, int first,
+                      int last)
+{
+    if( !fault_frame(sys, pcb, page, first, last) )
+        return 0;
+    int n = zero_fill(sys, pcb, page);
+    fault_count(sys, pcb);
+    sys->ZERO_FILL_n += n;
+    int pte = PT_get(PCB_mem(pcb)->page_table, page);
+    if( n > 1 )
+        printf("Page fault: pages %d-%d of PID %d zero-filled in a large"
+               " page at frames %d-%d.\n", page & ~(n - 1),
+                (page & ~(n - 1)) + n - 1, pcb->PID,
+                PTE_FRAME(pte) - page % n, PTE_FRAME(pte) - page % n + n - 1);
+    else
+        printf("Page fault: page %d of PID %d zero-filled in frame %d.\n",
+                page, pcb->PID, PTE_FRAME(pte));
+    return 1;
+}
+
+int MEM_touch(SYSGEN * sys, PCB * pcb, int first, int last, int write)
+{
+    PTABLE * pt = PCB_mem(pcb)->page_table;
+    for(int page = first; page <= last; page++){
+        int pte = PT_translate(pt, page);
+        if( pte == PTE_NONE ){
+            if( !zero_fault(sys, pcb, page, first, last) )
+                return 0;
+        }
+        else if( (pte & PTE_SWAP) && !page_fault(sys, pcb, page, first, last) )
+            return 0;
+        if( write && !MEM_write(sys, pcb, page) )
+            return 0;
+        PT_mark(pt, page, PTE_REF);
+    }
+    return 1;
+}
+
+/** Suspend pcb, which is in memory and off the CPU: to swap, or to the job
+ *  pool if there is no swap. */
+static void suspend(SYSGEN * sys, PCB * pcb)
+{
+    int ready =    PCB_acct(pcb)->IO_PENDING == 0
+                && READYQ_remove(sys->READY_QUEUE, pcb);
+    sys->WS->SUSPEND_n++;
+    printf("Working sets overload memory: PID %d suspended.\n", pcb->PID);
+    if( sys->SWAP == NULL ){
+        MEM_unmap(sys, pcb);
+        JOBQ_enqueue(sys->JOB_QUEUE, pcb);
+        return;
+    }
+    swap_out(sys, pcb);
+    if( ready )
+        swapq_add(sys, pcb);
+}
+
+/** \return 1 if pcb may be suspended: it is in memory, off the CPU and
+ *          either has private pages that fit on swap, or, without swap,
+ *          is ready and has no shared memory attached. Going back to the
+ *          job pool would detach it, and a reload doesn't attach it 
+ *          again. */
+static int suspendable(SYSGEN * sys, PCB * pcb)
+{
+    PCB_MEM * mem = PCB_mem(pcb);
+    if(    pcb == sys->CPU->RUNNING_PROCESS || mem->suspended != 0
+        || (mem->resident == 0 && mem->swapped == 0) )
+        return 0;
+    if( sys->SWAP == NULL )
+        return PCB_acct(pcb)->IO_PENDING == 0 && mem->shm_pages == 0;
+    return mem->private > 0 && mem->private <= sys->SWAP->free;
+}
+
+/** Grow or shrink the allocation of pcb by its page fault frequency. A
+ *  shrunk process gives up the pages outside its working set. */
+static void pff(SYSGEN * sys, PCB * pcb, unsigned char mask)
+{
+    WSET * ws = sys->WS;
+    PCB_MEM * mem = PCB_mem(pcb);
+    int floor = mem->wss > 0 ? mem->wss : 1;
+    if( mem->faults > ws->pff_high && mem->frames < mem->num_pages ){
+        mem->frames += mem->faults - ws->pff_high;
+        if( mem->frames > mem->num_pages )
+            mem->frames = mem->num_pages;
+        ws->GROW_n++;
+        printf("PFF: PID %d took %d fault(s), allocation grown to %d.\n",
+                pcb->PID, mem->faults, mem->frames);
+    }
+    else if( mem->faults < ws->pff_low && mem->frames > floor ){
+        mem->frames = floor;
+        PTABLE * pt = mem->page_table;
+        SWAP_RUN run = { .len = 0 };
+        for(int i = PT_next(pt, 0); i >= 0 && mem->resident > mem->frames;
+                i = PT_next(pt, i + 1))
+            if(    !(*PT_hist(pt, i) & mask)
+                && private_page(sys, PT_get(pt, i))
+                && sys->SWAP->free > 0 )
+                page_out(sys, pcb, i, &run);
+        run_end(sys, NULL, 'w', &run);
+        ws->SHRINK_n++;
+        printf("PFF: PID %d took %d fault(s), allocation shrunk to %d.\n",
+                pcb->PID, mem->faults, mem->frames);
+    }
+}
+
+/** Sampling timer: age the reference bits into each process' history,
+ *  measure the working sets, run the PFF controller, and suspend
+ *  processes while the working sets overload memory. */
+static void ws_sample(TIMER * timer)
+{
+    SYSGEN * sys = timer->arg;
+    WSET * ws = sys->WS;
+    unsigned char mask = (1 << ws->window) - 1;
+    ws->SAMPLE_n++;
+    ws->SUM = 0;
+    for(PCB * p = PCB_next(NULL); p; p = PCB_next(p)){
+        PCB_MEM * mem = PCB_mem(p);
+        if( mem->suspended > 0 || (mem->resident == 0 && mem->swapped == 0) )
+            continue;
+        mem->wss = PT_age(mem->page_table, PTE_REF, mask);
+        if( sys->SWAP )
+            pff(sys, p, mask);
+        mem->faults = 0;
+        ws->SUM += mem->wss;
+    }
+
+    /** Load control: the largest working set goes first. */
+    while( ws->SUM > user_frames(sys) ){
+        PCB * victim = NULL;
+        for(PCB * p = PCB_next(NULL); p; p = PCB_next(p))
+            if(    suspendable(sys, p)
+                && (victim == NULL || PCB_mem(p)->wss > PCB_mem(victim)->wss) )
+                victim = p;
+        if( victim == NULL )
+            break;
+        suspend(sys, victim);
+    }
+    MEM_balance(sys);
+    if( sys->CPU->RUNNING_PROCESS == NULL && !READYQ_empty(sys->READY_QUEUE) )
+        dispatch_next(sys);
+
+    TWHEEL_arm(sys->TIMERS, &ws->TIMER,
+               ms_to_ticks(sys->clock + ws->interval));
+}
+
+WSET *MEM_ws_new(SYSGEN * sys, double interval, int window, int pff_low,
+                 int pff_high)
+{
+    WSET * ws = calloc( 1, sizeof(WSET) );
+    ws->interval = interval;
+    ws->window = window;
+    ws->pff_low = pff_low;
+    ws->pff_high = pff_high;
+    TIMER_init(&ws->TIMER, ws_sample, sys);
+    TWHEEL_arm(sys->TIMERS, &ws->TIMER, ms_to_ticks(sys->clock + interval));
+    return ws;
+}
+
+PCB *MEM_fork(SYSGEN * sys, PCB * parent)
+{
+    PCB_MEM * pmem = PCB_mem(parent);
+    if( pmem->swapped > 0 && pmem->swapped > sys->SWAP->free )
+        return NULL;
+
+    PCB * child = PCB_new(sys->t, pmem->proc_size, pmem->page_size,
+                          pmem->num_pages);
+    RG_join(PCB_acct(parent)->GROUP, child);
+    PCB_MEM * cmem = PCB_mem(child);
+    PTABLE * ppt = pmem->page_table;
+    PTABLE * cpt = PT_clone(ppt);
+    cmem->page_table = cpt;
+
+    /** Pages on swap are copied to slots of the child's own. Large pages
+     *  are shared whole. */
+    SWAP_RUN run = { .len = 0 };
+    for(int i = PT_next(ppt, 0); i >= 0; i = PT_next(ppt, i + 1)){
+        int pte = PT_get(ppt, i);
+        if( pte & PTE_SWAP ){
+            int slot = take_slot(sys->SWAP);
+            *PT_entry(cpt, i) = slot | PTE_SWAP;
+            cmem->swapped++;
+            run_add(sys, NULL, 'w', &run, slot);
+            continue;
+        }
+        if( !(pte & PTE_SHM) ){
+            PT_mark(ppt, i, PTE_COW);
+            PT_mark(cpt, i, PTE_COW);
+        }
+        rmap_add(sys, PTE_FRAME(pte), child, i);
+    }
+    run_end(sys, NULL, 'w', &run);
+    cmem->frames = pmem->frames;
+    cmem->shm_pages = pmem->shm_pages;
+    cmem->wss = pmem->wss;
+    ws_count(sys, child, 1);
+    sys->FORK_n++;
+    return child;
+}
+
+int MEM_write(SYSGEN * sys, PCB * pcb, int page)
+{
+    PTABLE * pt = PCB_mem(pcb)->page_table;
+    if( !(PT_get(pt, page) & PTE_COW) )
+        return 1;
+
+    /** Only the page written is copied; a large page is split. */
+    int * pte = PT_entry(pt, page);
+
+    /** The last one mapping a frame just gets it back. */
+    int old = PTE_FRAME(*pte);
+    if( sys->frame_table[old].REF == 1 ){
+        *pte = old | (*pte & PTE_REF);
+        sys->COW_REUSE_n++;
+        return 1;
+    }
+
+    if( sys->num_free_frames == 0 ){
+        printf("Copy-on-write fault on page %d of PID %d: no free frame.\n",
+                page, pcb->PID);
+        return 0;
+    }
+    if( group_room(pcb) == 0 ){
+        PCB_acct(pcb)->GROUP->QUOTA_n++;
+        printf("Copy-on-write fault on page %d of PID %d: group %d is at"
+               " its frame quota.\n", page, pcb->PID,
+                PCB_acct(pcb)->GROUP->NUM);
+        return 0;
+    }
+    *pte = take_frame(sys, pcb, page) | (*pte & PTE_REF);
+    put_frame(sys, old, pcb);
+    sys->COW_COPY_n++;
+    printf("Copy-on-write fault: page %d of PID %d copied from frame %d"
+           " to %d.\n", page, pcb->PID, old, PTE_FRAME(*pte));
+    return 1;
+}
+
+SHM_SEG *MEM_shm_find(SYSGEN * sys, char * name)
+{
+    for(SHM_SEG * seg = sys->SEGMENTS; seg; seg = seg->next)
+        if( !strcmp(seg->name, name) )
+            return seg;
+    return NULL;
+}
+
+int MEM_shm_attach(SYSGEN * sys, PCB * pcb, char * name, int size)
+{
+    PCB_MEM * mem = PCB_mem(pcb);
+    SHM_SEG * seg = MEM_shm_find(sys, name);
+    int base = mem->num_pages;
+    int pages = seg ? seg->num_pages
+                    : ceil( (double)size / (double)sys->frame_size );
+    if( seg == NULL && pages > sys->num_free_frames )
+        return -1;
+    if( seg == NULL && pages > group_room(pcb) ){
+        PCB_acct(pcb)->GROUP->QUOTA_n++;
+        return -3;
+    }
+    if( !PT_resize(mem->page_table, base + pages) )
+        return -2;
+
+    mem->num_pages += pages;
+    mem->shm_pages += pages;
+    mem->frames += pages;
+    mem->wss += pages;
+    if( sys->WS )
+        sys->WS->SUM += pages;
+    if( seg ){
+        for(int i = 0; i < pages; i++){
+            *PT_entry(mem->page_table, base+i) =
+                seg->frames[i] | PTE_SHM | PTE_REF;
+            rmap_add(sys, seg->frames[i], pcb, base+i);
+        }
+        return base;
+    }
+
+    seg = calloc( 1, sizeof(SHM_SEG) );
+    seg->name = strdup(name);
+    seg->num_pages = pages;
+    seg->frames = malloc( sizeof(int) * pages );
+    for(int i = 0; i < pages; i++){
+        seg->frames[i] = take_frame(sys, pcb, base+i);
+        sys->frame_table[seg->frames[i]].SHM = 1;
+        add_private(sys, pcb, -1);
+        *PT_entry(mem->page_table, base+i) =
+            seg->frames[i] | PTE_SHM | PTE_REF;
+    }
+    seg->next = sys->SEGMENTS;
+    sys->SEGMENTS = seg;
+    return base;
+}
+
+void MEM_free(SYSGEN * sys)
+{
+    free(sys->frame_bag.runs);
+    for(int i = 0; i < sys->num_frames; i++)
+        while( sys->frame_table[i].rmap ){
+            RMAP * r = sys->frame_table[i].rmap;
+            sys->frame_table[i].rmap = r->next;
+            free(r);
+        }
+    while( sys->SEGMENTS ){
+        SHM_SEG * seg = sys->SEGMENTS;
+        sys->SEGMENTS = seg->next;
+        free(seg->frames);
+        free(seg->name);
+        free(seg);
+    }
+    if( sys->SWAP ){
+        while( sys->SWAP->head ){
+            PCB * pcb = sys->SWAP->head;
+            sys->SWAP->head = pcb->LINK;
+            PCB_free(pcb);
+        }
+        free(sys->SWAP->map);
+        free(sys->SWAP->heap);
+        free(sys->SWAP->pick);
+        free(sys->SWAP);
+    }
+
+    /** The timer wheel is gone by now, and the sampling timer with it. */
+    free(sys->WS);
+}
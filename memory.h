@@ -0,0 +1,232 @@
+/** \file
+ *  memory.h:   Interface for frame allocation and process address spaces.
+ *
+ *              Free frames are kept as runs of consecutive frames
+ *              (frame_bag), so a process is loaded a run at a time and its
+ *              frames go back the same way, merging with the runs beside
+ *              them. A frame records its first mapping itself; page table
+ *              entries that share it are on its reverse map (RMAP), REF
+ *              mappings in all. A frame goes back on the list when its last
+ *              mapping goes.
+ *
+ *              Fork gives the child a copy of the parent's page table.
+ *              Every private page of both is marked copy-on-write (PTE_COW)
+ *              and its frame is shared. A process about to write a shared
+ *              page takes a fault: the page is copied to a frame of its
+ *              own, or, if it is the only one left mapping the frame,
+ *              simply made writable again. The simulated writes to memory
+ *              are device reads, which land in the process' buffer.
+ *
+ *              Shared memory segments (SHM_SEG) are named runs of frames
+ *              that any process can attach. Attaching appends the segment
+ *              to the end of the process' address space, marked PTE_SHM;
+ *              writes go to the shared frames and forks share them too.
+ *              The frames are allocated once, by the first process to
+ *              attach, and the segment goes away with its last mapping.
+ *
+ *              With a swap area (SWAP), the end of one disk, a medium-term
+ *              scheduler keeps memory from running short: a process that
+ *              waits on swap-in or in the job pool and doesn't fit makes
+ *              room by swapping out processes blocked on I/O, those with
+ *              the most private pages first. Only private pages go; shared
+ *              ones stay put. Their frames are freed at once and the page
+ *              writes queue up at the swap disk like any other request. A
+ *              swapped out process that becomes ready waits on the swap
+ *              queue until its pages have been read back in.
+ *
+ *              Working set control (WSET) samples the reference bits of
+ *              every page at fixed intervals. A process' working set is
+ *              the pages referenced within the last few samples; pages are
+ *              referenced by the I/O buffers of its requests. Processes
+ *              with swap behind them are demand paged: a page on swap is
+ *              read back in when a request touches it, and the process
+ *              blocks until it arrives. Each process has a resident frame
+ *              allocation, which a page fault frequency (PFF) controller
+ *              grows when the process faults too often and shrinks to the
+ *              working set when it hardly faults; a fault on a process at
+ *              its allocation replaces one of its own pages, clock order.
+ *              When the working sets add up to more than memory, the
+ *              process with the largest one is suspended, to swap or,
+ *              without swap, back to the job pool. Without swap, processes
+ *              with shared memory attached are left alone. Nothing is
+ *              resumed or admitted while its working set wouldn't fit.
+ *
+ *              Page tables (PTABLE) are flat or have two or three levels,
+ *              see page_table.h. With a flat table a process is loaded
+ *              whole. With levels, it is loaded on demand: it is admitted
+ *              with just its first page, and a page it touches for the
+ *              first time gets a zero-filled frame then, or, with large
+ *              pages on, a whole aligned run of frames if one is free.
+ *
+ *              Frames are charged to resource groups, see rgroup.h: a
+ *              process is only loaded, and a page only given a frame, while
+ *              its group is under its frame quota. */
+
+#ifndef MEMORY_H_
+#define MEMORY_H_
+
+#include "pcb.h"
+#include "page_table.h"
+#include "timer_wheel.h"
+
+/** Page table entries hold a frame number, plus PTE_COW while the page is
+ *  shared copy-on-write or PTE_SHM if it belongs to a shared segment. A
+ *  page out on swap has PTE_SWAP and the number of its swap slot. PTE_REF
+ *  is the reference bit. */
+#define PTE_COW             (1 << 30)
+#define PTE_SHM             (1 << 29)
+#define PTE_SWAP            (1 << 28)
+#define PTE_REF             (1 << 27)
+#define PTE_FRAME(pte)      ((pte) & ~(PTE_COW | PTE_SHM | PTE_SWAP | PTE_REF))
+
+struct SYSGEN;
+
+/** Reverse map entry: one more page table entry mapping a frame. */
+typedef struct RMAP {
+    struct RMAP     *   next;
+    PCB             *   pcb;
+    int                 page;
+} RMAP;
+
+/** Shared memory segment. */
+typedef struct SHM_SEG {
+    struct SHM_SEG  *   next;
+    char            *   name;
+    int             *   frames;
+    int                 num_pages;
+} SHM_SEG;
+
+/** Swap area: page sized slots at the end of a disk. */
+typedef struct SWAP {
+    int                 disk;           // Swap disk, counting from 1.
+    int                 slots;          // Page slots.
+    unsigned int        base;           // Disk block of slot 0.
+    unsigned char   *   map;            // One flag per slot.
+    int                 free;           // Free slots.
+    int                 rotor;          // Where next fit searches from.
+    PCB             *   head;           // Swap queue: ready processes
+    PCB             *   tail;           //   waiting to swap in.
+    int                 WAIT_n;
+    PCB             **  heap;           // Swap-out candidates: processes
+    int                 heap_n;         //   blocked on I/O in memory, a
+    int                 heap_cap;       //   max-heap by private pages.
+    PCB             **  pick;           // make_room()'s picks, heap_cap
+                                        //   long.
+
+    /** Statistics */
+    long                SWAP_OUT_n;     // Processes swapped out.
+    long                SWAP_IN_n;      //   and back in.
+    long                PAGES_OUT_n;
+    long                PAGES_IN_n;
+} SWAP;
+
+/** Working set control. */
+typedef struct WSET {
+    double              interval;       // Sampling interval in ms.
+    int                 window;         // Samples in a working set, 1-8.
+    int                 pff_low;        // Faults per sample below which an
+    int                 pff_high;       //   allocation shrinks, and above
+                                        //   which it grows.
+    int                 SUM;            // Working sets of the processes in
+                                        //   memory, summed.
+    TIMER               TIMER;          // Next sample.
+
+    /** Statistics */
+    long                SAMPLE_n;
+    long                FAULT_n;        // Page faults.
+    long                GROW_n;         // Allocations grown.
+    long                SHRINK_n;       //   and shrunk.
+    long                SUSPEND_n;      // Processes suspended.
+} WSET;
+
+/** \return the frames pcb is loaded with: all of its pages, or just the
+ *          first if processes are loaded on demand. */
+int MEM_load_pages(struct SYSGEN * sys, PCB * pcb);
+
+/** Load pcb, giving the pages it is loaded with frames of their own. The
+ *  caller has checked that there are enough free frames. */
+void MEM_map(struct SYSGEN * sys, PCB * pcb);
+
+/** Drop all mappings of pcb. Frames nobody else maps are freed, and so
+ *  are segments nobody has attached any more. */
+void MEM_unmap(struct SYSGEN * sys, PCB * pcb);
+
+/** \return the length of the longest free run. It is kept as runs are
+ *  split and merged, and only looked for again after the longest one
+ *  has been split. */
+int MEM_largest_free(struct SYSGEN * sys);
+
+/** Move jobs that can be loaded in the free frames from the job pool to
+ *  the ready queue, largest fit first. Jobs whose group has no room for
+ *  them stay. */
+void MEM_admit_jobs(struct SYSGEN * sys);
+
+/** \return the frames a new process may take: the free ones, or fewer if
+ *          its working set wouldn't fit beside the others. */
+int MEM_room(struct SYSGEN * sys);
+
+/** Medium-term scheduler. Swap in processes off the swap queue in order
+ *  and then admit jobs, swapping out blocked processes to make room where
+ *  that is enough. Without a swap area this just admits jobs. */
+void MEM_balance(struct SYSGEN * sys);
+
+/** pcb, just taken off the CPU, has blocked on I/O: it may be swapped out
+ *  to make room until it wakes up. */
+void MEM_block(struct SYSGEN * sys, PCB * pcb);
+
+/** pcb is about to wake up from I/O.
+ *  \return 1 if it can, 0 if it has pages on swap and now waits on the
+ *          swap queue. */
+int MEM_wake(struct SYSGEN * sys, PCB * pcb);
+
+/** Take the process pid off the swap queue.
+ *  \return the process, NULL if it isn't there. */
+PCB *MEM_swapq_kill(struct SYSGEN * sys, int pid);
+
+/** Set up a swap area of slots pages at the end of disk, counting
+ *  from 1. */
+SWAP *MEM_swap_new(struct SYSGEN * sys, int disk, int slots);
+
+/** Start working set control.
+ *  \param  interval is the sampling interval in ms.
+ *  \param  window is the number of samples in a working set, 1 to 8.
+ *  \param  pff_low and pff_high bound the page faults per sample. */
+WSET *MEM_ws_new(struct SYSGEN * sys, double interval, int window,
+                 int pff_low, int pff_high);
+
+/** \return a child of parent sharing all of its frames, copy-on-write
+ *          except for shared segments, NULL if the parent's pages on swap
+ *          can't be copied for want of swap slots. */
+PCB *MEM_fork(struct SYSGEN * sys, PCB * parent);
+
+/** pcb is about to write page. Breaks copy-on-write sharing if needed.
+ *  \return 1 if the page is writable, 0 if a copy was needed and there was
+ *          no free frame for it. */
+int MEM_write(struct SYSGEN * sys, PCB * pcb, int page);
+
+/** The CPU process pcb references pages first to last, writing them if
+ *  write is set. Each reference is translated through its page table.
+ *  Pages never touched are zero-filled. Pages on swap are faulted in:
+ *  their reads are queued at the swap disk and pcb has to block until
+ *  they complete.
+ *  \return 1 if all pages are there, 0 if one couldn't be faulted in or
+ *          made writable. */
+int MEM_touch(struct SYSGEN * sys, PCB * pcb, int first, int last,
+              int write);
+
+/** \return the segment called name, NULL if there is none. */
+SHM_SEG *MEM_shm_find(struct SYSGEN * sys, char * name);
+
+/** Attach segment name to the end of pcb's address space, creating it
+ *  with size bytes if there is no such segment.
+ *  \return the first page of the segment in pcb, -1 if it had to be
+ *          created and there were not enough free frames, -2 if it is
+ *          beyond what the page table can map, -3 if it had to be created
+ *          and pcb's group has no room for it. */
+int MEM_shm_attach(struct SYSGEN * sys, PCB * pcb, char * name, int size);
+
+/** Free the reverse maps, segments, swap area, working set control and
+ *  processes on the swap queue left at shutdown. */
+void MEM_free(struct SYSGEN * sys);
+
+#endif
@@ -0,0 +1,359 @@
+/** \file
+ *  page_table.c:   Implementation for process page tables. */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "page_table.h"
+
+/** \return the page number bits a table of a frame of frame_size words
+ *          takes, at least one. */
+static int bits_for(int frame_size)
+{
+    int bits = 1;
+    while( (2 << bits) <= frame_size )
+        bits++;
+    return bits;
+}
+
+PT_CONFIG *PT_config_new(int levels, int frame_size, int large)
+{
+    PT_CONFIG * cfg = calloc( 1, sizeof(PT_CONFIG) );
+    cfg->levels = levels;
+    cfg->bits = bits_for(frame_size);
+    cfg->large = levels > 1 && large;
+    return cfg;
+}
+
+long long PT_capacity(int levels, int frame_size)
+{
+    int bits = bits_for(frame_size);
+    if( levels == 1 || bits * levels >= 31 )
+        return INT_MAX;
+    return 1LL << (bits * levels);
+}
+
+int PT_large_pages(PT_CONFIG * cfg)
+{
+    return 1 << cfg->bits;
+}
+
+/** \return the entries in each table of pt: a frame's worth, or every
+ *          page for a flat table. */
+static int width(PTABLE * pt)
+{
+    return pt->cfg->levels == 1 ? pt->num_pages : 1 << pt->cfg->bits;
+}
+
+/** \return the index of page in a table of level l, 0 being the last. */
+static int index_of(PTABLE * pt, int page, int l)
+{
+    if( pt->cfg->levels == 1 )
+        return page;
+    return (page >> (l * pt->cfg->bits)) & ((1 << pt->cfg->bits) - 1);
+}
+
+static PT_NODE *node_new(PT_CONFIG * cfg, int n, int interior)
+{
+    PT_NODE * t = malloc( sizeof(PT_NODE) );
+    t->pte = malloc( sizeof(int) * n );
+    for(int i = 0; i < n; i++)
+        t->pte[i] = PTE_NONE;
+    t->hist = calloc( n, sizeof(unsigned char) );
+    t->child = interior ? calloc( n, sizeof(PT_NODE*) ) : NULL;
+    cfg->TABLE_n++;
+    cfg->WORDS += n;
+    return t;
+}
+
+static void node_free(PT_CONFIG * cfg, PT_NODE * t, int n)
+{
+    if( t->child ){
+        for(int i = 0; i < n; i++)
+            if( t->child[i] )
+                node_free(cfg, t->child[i], n);
+        free(t->child);
+    }
+    free(t->pte);
+    free(t->hist);
+    free(t);
+    cfg->TABLE_n--;
+    cfg->WORDS -= n;
+}
+
+static PT_NODE *node_copy(PT_CONFIG * cfg, PT_NODE * t, int n)
+{
+    PT_NODE * c = node_new(cfg, n, t->child != NULL);
+    memcpy(c->pte, t->pte, sizeof(int) * n);
+    memcpy(c->hist, t->hist, n);
+    if( t->child )
+        for(int i = 0; i < n; i++)
+            if( t->child[i] )
+                c->child[i] = node_copy(cfg, t->child[i], n);
+    return c;
+}
+
+PTABLE *PT_new(PT_CONFIG * cfg, int num_pages)
+{
+    PTABLE * pt = malloc( sizeof(PTABLE) );
+    pt->cfg = cfg;
+    pt->num_pages = num_pages;
+    pt->root = node_new(cfg, width(pt), cfg->levels > 1);
+    cfg->FLAT_WORDS += num_pages;
+    return pt;
+}
+
+PTABLE *PT_clone(PTABLE * pt)
+{
+    PTABLE * c = malloc( sizeof(PTABLE) );
+    *c = *pt;
+    c->root = node_copy(pt->cfg, pt->root, width(pt));
+    pt->cfg->FLAT_WORDS += pt->num_pages;
+    return c;
+}
+
+int PT_resize(PTABLE * pt, int num_pages)
+{
+    PT_CONFIG * cfg = pt->cfg;
+    if( num_pages > PT_capacity(cfg->levels, 1 << cfg->bits) )
+        return 0;
+    int old = pt->num_pages;
+    pt->num_pages = num_pages;
+    cfg->FLAT_WORDS += num_pages - old;
+    if( cfg->levels > 1 )
+        return 1;
+
+    PT_NODE * t = pt->root;
+    t->pte = realloc( t->pte, sizeof(int) * num_pages );
+    t->hist = realloc( t->hist, num_pages );
+    for(int i = old; i < num_pages; i++){
+        t->pte[i] = PTE_NONE;
+        t->hist[i] = 0;
+    }
+    cfg->WORDS += num_pages - old;
+    return 1;
+}
+
+/** Walk pt down to the entry mapping page.
+ *  \param  idx receives the entry's index in its table.
+ *  \param  level receives its level, above 0 for a large page.
+ *  \param  steps counts the tables read.
+ *  \return the table holding the entry, NULL if page isn't mapped. */
+static PT_NODE *find(PTABLE * pt, int page, int * idx, int * level,
+                     int * steps)
+{
+    PT_NODE * t = pt->root;
+    for(int l = pt->cfg->levels - 1; l > 0; l--){
+        int i = index_of(pt, page, l);
+        (*steps)++;
+        if( t->pte[i] != PTE_NONE ){
+            *idx = i;
+            *level = l;
+            return t;
+        }
+        t = t->child[i];
+        if( t == NULL )
+            return NULL;
+    }
+    (*steps)++;
+    *idx = index_of(pt, page, 0);
+    *level = 0;
+    return t->pte[*idx] == PTE_NONE ? NULL : t;
+}
+
+/** \return the entry of page, counting the tables read in steps. */
+static int lookup(PTABLE * pt, int page, int * steps)
+{
+    int i, l;
+    PT_NODE * t = find(pt, page, &i, &l, steps);
+    if( t == NULL )
+        return PTE_NONE;
+    if( l == 0 )
+        return t->pte[i];
+    return t->pte[i] + (page & ((1 << (l * pt->cfg->bits)) - 1));
+}
+
+int PT_get(PTABLE * pt, int page)
+{
+    int steps = 0;
+    return lookup(pt, page, &steps);
+}
+
+int PT_translate(PTABLE * pt, int page)
+{
+    int steps = 0;
+    int pte = lookup(pt, page, &steps);
+    pt->cfg->WALK_n++;
+    pt->cfg->STEP_n += steps;
+    return pte;
+}
+
+/** Split the large page in entry i of t into the new table below it. */
+static void split(PT_CONFIG * cfg, PT_NODE * t, int i, int n)
+{
+    PT_NODE * last = t->child[i];
+    for(int j = 0; j < n; j++){
+        last->pte[j] = t->pte[i] + j;
+        last->hist[j] = t->hist[i];
+    }
+    t->pte[i] = PTE_NONE;
+    t->hist[i] = 0;
+    cfg->SPLIT_n++;
+}
+
+int *PT_entry(PTABLE * pt, int page)
+{
+    int n = width(pt);
+    PT_NODE * t = pt->root;
+    for(int l = pt->cfg->levels - 1; l > 0; l--){
+        int i = index_of(pt, page, l);
+        if( t->child[i] == NULL ){
+            t->child[i] = node_new(pt->cfg, n, l > 1);
+            if( t->pte[i] != PTE_NONE )
+                split(pt->cfg, t, i, n);
+        }
+        t = t->child[i];
+    }
+    return &t->pte[index_of(pt, page, 0)];
+}
+
+void PT_fill(PTABLE * pt, int page, int entry, int len)
+{
+    int n = width(pt);
+    while( len > 0 ){
+        int * pte = PT_entry(pt, page);
+        int k = n - index_of(pt, page, 0);
+        if( k > len )
+            k = len;
+        for(int i = 0; i < k; i++)
+            pte[i] = entry + i;
+        page += k;
+        entry += k;
+        len -= k;
+    }
+}
+
+void PT_mark(PTABLE * pt, int page, int flag)
+{
+    int i, l, steps = 0;
+    PT_NODE * t = find(pt, page, &i, &l, &steps);
+    if( t )
+        t->pte[i] |= flag;
+}
+
+void PT_clear(PTABLE * pt, int page, int flag)
+{
+    int i, l, steps = 0;
+    PT_NODE * t = find(pt, page, &i, &l, &steps);
+    if( t )
+        t->pte[i] &= ~flag;
+}
+
+unsigned char *PT_hist(PTABLE * pt, int page)
+{
+    int i, l, steps = 0;
+    PT_NODE * t = find(pt, page, &i, &l, &steps);
+    return t ? &t->hist[i] : NULL;
+}
+
+int PT_large_fits(PTABLE * pt, int page)
+{
+    int n = PT_large_pages(pt->cfg);
+    if( !pt->cfg->large || (page & ~(n - 1)) + n > pt->num_pages )
+        return 0;
+    PT_NODE * t = pt->root;
+    for(int l = pt->cfg->levels - 1; l > 1; l--){
+        t = t->child[index_of(pt, page, l)];
+        if( t == NULL )
+            return 1;
+    }
+    int i = index_of(pt, page, 1);
+    return t->child[i] == NULL && t->pte[i] == PTE_NONE;
+}
+
+void PT_map_large(PTABLE * pt, int page, int entry)
+{
+    PT_NODE * t = pt->root;
+    for(int l = pt->cfg->levels - 1; l > 1; l--){
+        int i = index_of(pt, page, l);
+        if( t->child[i] == NULL )
+            t->child[i] = node_new(pt->cfg, width(pt), 1);
+        t = t->child[i];
+    }
+    int i = index_of(pt, page, 1);
+    t->pte[i] = entry;
+    t->hist[i] = 0;
+    pt->cfg->LARGE_n++;
+}
+
+/** \return the first mapped page from from on under table t of level l,
+ *          whose first page is base, -1 if there is none. */
+static long long next_in(PTABLE * pt, PT_NODE * t, int l, long long base,
+                         long long from)
+{
+    long long span = pt->cfg->levels == 1 ? 1 : 1LL << (l * pt->cfg->bits);
+    for(int i = (from - base) / span; i < width(pt); i++){
+        long long first = base + i * span;
+        long long start = first > from ? first : from;
+        if( first >= pt->num_pages )
+            return -1;
+        if( t->pte[i] != PTE_NONE )
+            return start;
+        if( l > 0 && t->child[i] ){
+            long long page = next_in(pt, t->child[i], l - 1, first, start);
+            if( page >= 0 )
+                return page;
+        }
+    }
+    return -1;
+}
+
+int PT_next(PTABLE * pt, int page)
+{
+    if( page >= pt->num_pages )
+        return -1;
+    return next_in(pt, pt->root, pt->cfg->levels - 1, 0, page);
+}
+
+static int age(PTABLE * pt, PT_NODE * t, int l, int ref_bit,
+               unsigned char mask)
+{
+    int count = 0;
+    for(int i = 0; i < width(pt); i++){
+        if( t->pte[i] != PTE_NONE ){
+            t->hist[i] = (t->hist[i] << 1) | ((t->pte[i] & ref_bit) != 0);
+            t->pte[i] &= ~ref_bit;
+            if( t->hist[i] & mask )
+                count += 1 << (l * pt->cfg->bits);
+        }
+        else if( l > 0 && t->child[i] )
+            count += age(pt, t->child[i], l - 1, ref_bit, mask);
+    }
+    return count;
+}
+
+int PT_age(PTABLE * pt, int ref_bit, unsigned char mask)
+{
+    return age(pt, pt->root, pt->cfg->levels - 1, ref_bit, mask);
+}
+
+void PT_reset(PTABLE * pt)
+{
+    int n = width(pt);
+    PT_NODE * t = pt->root;
+    for(int i = 0; i < n; i++){
+        if( t->child && t->child[i] ){
+            node_free(pt->cfg, t->child[i], n);
+            t->child[i] = NULL;
+        }
+        t->pte[i] = PTE_NONE;
+        t->hist[i] = 0;
+    }
+}
+
+void PT_free(PTABLE * pt)
+{
+    node_free(pt->cfg, pt->root, width(pt));
+    pt->cfg->FLAT_WORDS -= pt->num_pages;
+    free(pt);
+}
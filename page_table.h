@@ -0,0 +1,132 @@
+/** \file
+ *  page_table.h:   Interface for process page tables (PTABLE).
+ *
+ *                  A page table is a radix tree of one to three levels.
+ *                  Each table holds one entry per word of a frame, so a
+ *                  table fills a frame and takes log2(frame size) bits of
+ *                  the page number, the last level the lowest ones. With
+ *                  one level the table is flat, an entry for every page of
+ *                  the process. With more, a table below the top is only
+ *                  allocated once a page it covers is mapped, so a large
+ *                  address space that is mostly holes costs a few tables.
+ *
+ *                  An entry one level above the last may map a large page
+ *                  instead of pointing to a table: a run of frames, aligned
+ *                  to the size of a table, covering every page that table
+ *                  would. A lookup stops there, one level short. Changing
+ *                  one page of a large page splits it back into a table of
+ *                  ordinary entries first.
+ *
+ *                  Every entry also keeps a reference history byte for
+ *                  working set sampling; a large page has one for all of
+ *                  its pages. */
+
+#ifndef PAGE_TABLE_H_
+#define PAGE_TABLE_H_
+
+/** Entry of a page that isn't mapped. */
+#define PTE_NONE            (-1)
+
+/** Page table configuration, shared by all page tables. */
+typedef struct PT_CONFIG {
+    int                 levels;         // 1 to 3.
+    int                 bits;           // Page number bits per level.
+    int                 large;          // 1 if large pages may be mapped.
+
+    /** Statistics */
+    long                TABLE_n;        // Tables allocated now.
+    long                WORDS;          //   and the words they take.
+    long                FLAT_WORDS;     // Words flat tables would take.
+    long                WALK_n;         // Translations.
+    long                STEP_n;         // Tables they read.
+    long                LARGE_n;        // Large pages mapped.
+    long                SPLIT_n;        //   and split.
+} PT_CONFIG;
+
+/** Table of one level. Interior tables point to the tables below them;
+ *  one level above the last, an entry other than PTE_NONE is a large
+ *  page. */
+typedef struct PT_NODE {
+    int             *   pte;
+    unsigned char   *   hist;
+    struct PT_NODE  **  child;          // NULL at the last level.
+} PT_NODE;
+
+/** Page table of one process. */
+typedef struct PTABLE {
+    PT_CONFIG       *   cfg;
+    int                 num_pages;
+    PT_NODE         *   root;
+} PTABLE;
+
+/** \return a configuration of levels levels for frames of frame_size
+ *          words, with large pages if large is set. */
+PT_CONFIG *PT_config_new(int levels, int frame_size, int large);
+
+/** \return the most pages a page table of levels levels can map with
+ *          frames of frame_size words. */
+long long PT_capacity(int levels, int frame_size);
+
+/** \return the pages in a large page of cfg. */
+int PT_large_pages(PT_CONFIG * cfg);
+
+/** \return an empty page table of num_pages pages. */
+PTABLE *PT_new(PT_CONFIG * cfg, int num_pages);
+
+/** \return a copy of pt, entries and histories alike. */
+PTABLE *PT_clone(PTABLE * pt);
+
+/** Resize pt to num_pages pages.
+ *  \return 1, 0 if that is beyond its capacity. */
+int PT_resize(PTABLE * pt, int num_pages);
+
+/** \return the entry of page, PTE_NONE if it isn't mapped. The entry of a
+ *          page in a large page is the large page's plus the offset. */
+int PT_get(PTABLE * pt, int page);
+
+/** PT_get() for an address translation by the process. The tables read
+ *  are counted as its cost. */
+int PT_translate(PTABLE * pt, int page);
+
+/** \return the entry of page, to be written. The tables down to it are
+ *          allocated, and a large page holding it split. */
+int *PT_entry(PTABLE * pt, int page);
+
+/** Map len pages from page on to consecutive frames, the first of them
+ *  entry with its flags, table by table. */
+void PT_fill(PTABLE * pt, int page, int entry, int len);
+
+/** Set flag in the entry mapping page, whether its own or a large page's.
+ *  Nothing happens if page isn't mapped. */
+void PT_mark(PTABLE * pt, int page, int flag);
+
+/** Clear flag likewise. */
+void PT_clear(PTABLE * pt, int page, int flag);
+
+/** \return the reference history of the entry mapping page, NULL if page
+ *          isn't mapped. */
+unsigned char *PT_hist(PTABLE * pt, int page);
+
+/** \return 1 if the large page holding page could be mapped: large pages
+ *          are on, it lies inside the address space and none of its
+ *          pages are mapped. */
+int PT_large_fits(PTABLE * pt, int page);
+
+/** Map the large page holding page to entry, the first frame of the run
+ *  with its flags. The caller has checked PT_large_fits(). */
+void PT_map_large(PTABLE * pt, int page, int entry);
+
+/** \return the first mapped page from page on, -1 if there is none. */
+int PT_next(PTABLE * pt, int page);
+
+/** Shift each entry's ref_bit into its history and clear it.
+ *  \return the pages referenced within the samples of mask. */
+int PT_age(PTABLE * pt, int ref_bit, unsigned char mask);
+
+/** Unmap every page and free the tables below the top. */
+void PT_reset(PTABLE * pt);
+
+/** Free pt and its tables. */
+void PT_free(PTABLE * pt);
+
+#endif
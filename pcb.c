@@ -2,37 +2,183 @@
 #include <strings.h>
 #include <stdio.h>
 #include <math.h>
-#include "pcb.h" 
+#include "pcb.h"
 
-/** PCB_new() */ 
+/** Process table. Slab i holds the entries for slots
+ *  [i*PCB_SLAB_SIZE, (i+1)*PCB_SLAB_SIZE). Freed PCB's are chained through
+ *  their LINK field onto free_list. */
+static PCB      **  hot_slabs   = NULL;
+PCB_ACCT        **  PCB_acct_slabs = NULL;
+PCB_MEM         **  PCB_mem_slabs  = NULL;
+PCB_SCHED       **  PCB_sched_slabs = NULL;
+PCB_TUNE        **  PCB_tune_slabs = NULL;
+static int          tune        = 0;
+static int          num_slabs   = 0;
+static PCB      *   free_list   = NULL;
+
+_Static_assert( sizeof(PCB_SCHED) == PCB_LINE,
+                "PCB_SCHED must fill one cache line" );
+
+/** Slot of each PID handed out, -1 once the PCB is freed. PIDs are never
+ *  reused, so this only grows. */
+static int      *   pid_slot    = NULL;
+static int          pid_cap     = 0;
+
+/** Add another slab to the table and chain its entries onto the free list.
+ *  Only the arrays of slab pointers are reallocated; existing slabs stay
+ *  where they are so outstanding PCB* handles remain valid. */
+static void grow_table()
+{
+    num_slabs++;
+    hot_slabs      = realloc(hot_slabs, sizeof(PCB*) * num_slabs);
+    PCB_acct_slabs = realloc(PCB_acct_slabs, sizeof(PCB_ACCT*) * num_slabs);
+    PCB_mem_slabs  = realloc(PCB_mem_slabs, sizeof(PCB_MEM*) * num_slabs);
+    PCB_sched_slabs = realloc(PCB_sched_slabs,
+                              sizeof(PCB_SCHED*) * num_slabs);
+    if( tune )
+        PCB_tune_slabs = realloc(PCB_tune_slabs,
+                                 sizeof(PCB_TUNE*) * num_slabs);
+
+    int s = num_slabs - 1;
+    hot_slabs[s]      = malloc( sizeof(PCB) * PCB_SLAB_SIZE );
+    PCB_acct_slabs[s] = malloc( sizeof(PCB_ACCT) * PCB_SLAB_SIZE );
+    PCB_mem_slabs[s]  = malloc( sizeof(PCB_MEM) * PCB_SLAB_SIZE );
+    PCB_sched_slabs[s] = aligned_alloc( PCB_LINE,
+                                        sizeof(PCB_SCHED) * PCB_SLAB_SIZE );
+    if( tune )
+        PCB_tune_slabs[s] = malloc( sizeof(PCB_TUNE) * PCB_SLAB_SIZE );
+
+    /** Chain in reverse so that the lowest slot is handed out first. */
+    for(int i = PCB_SLAB_SIZE - 1; i >= 0; i--){
+        hot_slabs[s][i].slot = s * PCB_SLAB_SIZE + i;
+        hot_slabs[s][i].PID = -1;
+        hot_slabs[s][i].LINK = free_list;
+        free_list = &hot_slabs[s][i];
+    }
+}
+
+/** PCB_table_tune() */
+void PCB_table_tune()
+{
+    tune = 1;
+}
+
+/** PCB_new() */
 PCB *PCB_new(double tau_init, int p_size, int pg_size, int n_pages)
 {
-    /** new_pid holds the next available pid value; a post-increment 
-     *  assignment assigns this value while bumping up the value for the 
+    /** new_pid holds the next available pid value; a post-increment
+     *  assignment assigns this value while bumping up the value for the
      *  next process. */
-    static int new_pid = 1; 
-    PCB *new_PCB = malloc( sizeof(PCB) ); 
-    
-    // Initialize PCB values: 
-    *new_PCB = (PCB){   .PID = new_pid++, 
-                        .LINK = NULL,
-                        .TAU_n_plus1 = tau_init, 
-                        .TAU_r = tau_init, 
-                        .CPU_t = 0.00, 
-                        .BURST_n = 0,
-                        .BURST_avg = 0,
+    static int new_pid = 1;
+
+    if( free_list == NULL )
+        grow_table();
+    PCB *new_PCB = free_list;
+    free_list = free_list->LINK;
+
+    // Initialize PCB values:
+    *new_PCB = (PCB){   .LINK = NULL,
+                        .TAU_r = tau_init,
+                        .PID = new_pid++,
+                        .slot = new_PCB->slot};
+    *PCB_acct(new_PCB) = (PCB_ACCT){
+                        .TAU_n_plus1 = tau_init,
+                        .CPU_t = 0.00,
+                        .BURST = { 0 },
+                        .PRED_ERR = { 0 },
+                        .TAU_FIXED = tau_init,
+                        .ALPHA = -1,
                         .BURST_t = 0,
+                        .LAST_RAN = -1};
+    if( tune )
+        for(int k = 0; k < ALPHA_GRID; k++){
+            PCB_tune(new_PCB)->TAU_GRID[k] = tau_init;
+            PCB_tune(new_PCB)->ERR_GRID[k] = 0;
+        }
+    *PCB_mem(new_PCB) = (PCB_MEM){
                         .page_table = NULL,
                         .proc_size = p_size,
                         .page_size = pg_size,
-                        .num_pages = n_pages};
-    return new_PCB;      
+                        .num_pages = n_pages,
+                        .swap_idx = -1,
+                        .frames = n_pages};
+    *PCB_sched(new_PCB) = (PCB_SCHED){ .heap_idx = -1 };
+
+    if( new_PCB->PID >= pid_cap ){
+        int cap = pid_cap ? 2 * pid_cap : PCB_SLAB_SIZE;
+        pid_slot = realloc(pid_slot, sizeof(int) * cap);
+        for(int i = pid_cap; i < cap; i++)
+            pid_slot[i] = -1;
+        pid_cap = cap;
+    }
+    pid_slot[new_PCB->PID] = new_PCB->slot;
+    return new_PCB;
 }
 
-/** PCB_free() */ 
+/** PCB_free() */
 void PCB_free(PCB *recycle)
 {
-    if( recycle->page_table != NULL )
-        free(recycle->page_table);
-    free(recycle);
+    if( PCB_mem(recycle)->page_table != NULL )
+        PT_free(PCB_mem(recycle)->page_table);
+    PCB_mem(recycle)->page_table = NULL;
+    if( recycle->PID > 0 && recycle->PID < pid_cap )
+        pid_slot[recycle->PID] = -1;
+    recycle->PID = -1;
+    recycle->LINK = free_list;
+    free_list = recycle;
+}
+
+PCB *PCB_find(int pid)
+{
+    if( pid < 1 || pid >= pid_cap || pid_slot[pid] < 0 )
+        return NULL;
+    int slot = pid_slot[pid];
+    return &hot_slabs[slot >> PCB_SLAB_SHIFT][slot & PCB_SLAB_MASK];
+}
+
+PCB *PCB_next(PCB * p)
+{
+    int slot = p ? p->slot + 1 : 0;
+    for( ; slot < num_slabs * PCB_SLAB_SIZE; slot++){
+        PCB * q = &hot_slabs[slot >> PCB_SLAB_SHIFT][slot & PCB_SLAB_MASK];
+        if( q->PID != -1 )
+            return q;
+    }
+    return NULL;
+}
+
+void PCB_io_release(PCB * p)
+{
+    if( p == NULL )
+        return;
+    if( --PCB_acct(p)->IO_PENDING <= 0 )
+        PCB_free(p);
+}
+
+/** PCB_table_free() */
+void PCB_table_free()
+{
+    for(int i = 0; i < num_slabs; i++){
+        free(hot_slabs[i]);
+        free(PCB_acct_slabs[i]);
+        free(PCB_mem_slabs[i]);
+        free(PCB_sched_slabs[i]);
+        if( tune )
+            free(PCB_tune_slabs[i]);
+    }
+    free(hot_slabs);
+    free(PCB_acct_slabs);
+    free(PCB_mem_slabs);
+    free(PCB_sched_slabs);
+    free(PCB_tune_slabs);
+    hot_slabs = NULL;
+    PCB_acct_slabs = NULL;
+    PCB_mem_slabs = NULL;
+    PCB_sched_slabs = NULL;
+    PCB_tune_slabs = NULL;
+    num_slabs = 0;
+    free(pid_slot);
+    pid_slot = NULL;
+    pid_cap = 0;
+    free_list = NULL;
 }
@@ -1,39 +1,206 @@
 /** \file:  pcb.h
- *          Interface for PCB object. */
+ *          Interface for PCB object.
+ *
+ *          PCB's live in a structure-of-arrays process table indexed by a
+ *          slot number. The PCB struct itself only holds the scheduler-hot
+ *          fields (the ones the ready queue reads on every comparison), so
+ *          a queue walk touches one small record per element. Accounting
+ *          and paging info are kept in separate cold arrays at the same
+ *          slot, reached through PCB_acct() and PCB_mem().
+ *
+ *          The table grows in fixed size slabs which are never moved, so a
+ *          PCB* stays a valid handle for the lifetime of the process. */
 
 #ifndef PCB_H_
 #define PCB_H_
 
-/** struct PCB is a Process Control Block. */ 
-typedef struct PCB{ 
-    
-    int             PID;        // Process ID. 
-    struct PCB  *   LINK;       // Link to next PCB. 
+#include "page_table.h"
+#include "stats.h"
+#include "timer_wheel.h"
 
-    /** CPU accounting info*/
-    double          TAU_n_plus1;// Prediction for next CPU burst. 
+/** Slabs hold 2^PCB_SLAB_SHIFT entries each. */
+#define PCB_SLAB_SHIFT  12
+#define PCB_SLAB_SIZE   (1 << PCB_SLAB_SHIFT)
+#define PCB_SLAB_MASK   (PCB_SLAB_SIZE - 1)
+
+/** Cache line size the scheduler slabs are aligned to. */
+#define PCB_LINE        64
+
+/** Candidate history parameters of adaptive prediction, 0 to 1 in equal
+ *  steps. */
+#define ALPHA_GRID      11
+
+/** Budget below which a real-time job counts as out of budget, well under
+ *  a clock tick. */
+#define RT_MIN_LEFT     1e-6
+
+struct SYSGEN;
+struct RGROUP;
+
+/** struct PCB is the hot part of a Process Control Block. */
+typedef struct PCB{
+
+    struct PCB  *   LINK;       // Link to next PCB.
     double          TAU_r;      // Remaining tau value(if interrupt occurs).
-    double          CPU_t;      // Total CPU time. 
-    double          BURST_n;    // Number of CPU bursts.    
-    double          BURST_avg;  // Average CPU burst time. 
+    int             PID;        // Process ID.
+    int             slot;       // Index of the cold records in the table.
+} PCB;
+
+/** Real-time parameters and the current job, see realtime.h. */
+typedef struct PCB_RT{
+    double          PERIOD;     // Release interval in ms, 0 for a process
+                                // of the normal class.
+    double          BUDGET;     // CPU time each job may take.
+    double          DEADLINE;   // Relative deadline, at most PERIOD.
+    double          RELEASED;   // Clock time the current job was released,
+    double          DUE;        //   its absolute deadline,
+    double          LEFT;       //   and the budget it has left.
+    int             DONE;       // 1 once the current job has completed.
+    long            JOB_n;      // Jobs released,
+    long            MISS_n;     //   and deadlines missed.
+    TIMER           RELEASE;    // Next release.
+    struct SYSGEN * sys;        // For the release timer.
+} PCB_RT;
+
+/** CPU accounting info. */
+typedef struct PCB_ACCT{
+    double          TAU_n_plus1;// Prediction for next CPU burst.
+    double          CPU_t;      // Total CPU time.
+    WELFORD         BURST;      // Lengths of completed CPU bursts.
+    WELFORD         PRED_ERR;   // |TAU_n_plus1 - burst| of each, the
+                                // error of the prediction it had.
+    double          TAU_FIXED;  // Prediction with the system's a.
+    double          ALPHA;      // History parameter TAU_n_plus1 follows.
     double          BURST_t;    // Current burst time.
+    double          LAST_RAN;   // Clock time the process last held the
+                                // CPU, -1 if it never has.
+    double          READY_AT;   // Clock time it joined the ready queue.
+    PCB_RT          RT;         // Real-time class.
+    struct RGROUP * GROUP;      // Resource group, NULL if there are
+                                // none, see rgroup.h.
+    int             IO_PENDING; // Outstanding I/O requests; the process
+                                // is blocked while this is above 0.
+} PCB_ACCT;
 
-    /** Paging info. */ 
-    int *           page_table; // Pointer to page table entries. Very simple 
-                                // in this software implementation: 
-                                // each entry just holds the number of a frame 
-                                // in memory. 
+/** Per process tuning of the history parameter, only kept when it is
+ *  turned on, see PCB_table_tune(). */
+typedef struct PCB_TUNE{
+    double          TAU_GRID[ALPHA_GRID];   // Prediction with each 
+    double          ERR_GRID[ALPHA_GRID];   // candidate, and its recent
+                                            // absolute error.
+} PCB_TUNE;
+
+/** Paging info. */
+typedef struct PCB_MEM{
+    PTABLE *        page_table; // Page table. Each entry just holds the
+                                // number of a frame in memory, see
+                                // page_table.h and memory.h.
     int             proc_size;  // Process size.
-    int             page_size;  // Page size. 
-    int             num_pages;  // Number of pages.  
-} PCB; 
+    int             page_size;  // Page size.
+    int             num_pages;  // Number of pages.
+    int             resident;   // Pages in frames.
+    int             swapped;    // Pages out on swap.
+    int             private;    // Resident pages it alone maps, outside
+                                // shared segments: what swapping it out
+                                // frees.
+    int             shm_pages;  // Pages of attached shared memory
+                                // segments.
+    int             suspended;  // 1 while swapped out by the medium-term
+                                // scheduler, -1 while being read back in.
+    int             swap_idx;   // Position in the swap-out heap, -1 if
+                                // none, see memory.h.
+    int             frames;     // Resident frame allocation.
+    int             wss;        // Working set size at the last sample.
+    int             faults;     // Page faults since the last sample.
+    int             hand;       // Clock hand for local replacement.
+    struct PCB  *   jq_left;    // Job pool treap links, see job_queue.h.
+    struct PCB  *   jq_right;
+    double          jq_key;     // Job pool priority, less aging * now.
+    double          jq_at;      // Clock time it joined the job pool.
+    long            jq_seq;     // Job pool arrival number.
+    int             jq_min;     // Smallest proc_size in its subtree.
+} PCB_MEM;
+
+/** Scheduler bookkeeping. Each field is owned by whichever policy the
+ *  ready queue was generated with (see scheduler.h); PCB_new() zeroes the
+ *  record and sets heap_idx to -1. Sized to fit a single cache line, and
+ *  the slabs start on one, so each record sits in exactly one. */
+typedef struct PCB_SCHED{
+    struct PCB  *   rb_parent;  // Red-black tree links (fair policy).
+    struct PCB  *   rb_left;
+    struct PCB  *   rb_right;
+    struct PCB  *   prev;       // Back link of the LINK list (RR, MLFQ,
+                                // and the held list while queued is 2).
+    double          vruntime;   // Virtual runtime (fair policy).
+    double          slice_used; // Time used out of the current quantum.
+    long            seq;        // Enqueue sequence number, FIFO tiebreak.
+    int             heap_idx;   // Position in the SJF heap, -1 if none.
+    unsigned char   level;      // MLFQ level, 0 is the highest priority.
+    unsigned char   rb_red;     // Red-black node color (fair policy).
+    unsigned char   queued;     // 1 on the ready queue, 2 on its held
+                                // list, 0 off it; kept by the ready
+                                // queue, not the policy.
+} PCB_SCHED;
 
-/** Return a pointer to a new PCB object. 
+/** Cold slab arrays, indexed through the accessors below. */
+extern PCB_ACCT **  PCB_acct_slabs;
+extern PCB_MEM  **  PCB_mem_slabs;
+extern PCB_SCHED ** PCB_sched_slabs;
+extern PCB_TUNE **  PCB_tune_slabs;
+
+/** \return the accounting record of a PCB. */
+static inline PCB_ACCT *PCB_acct(PCB * p)
+{
+    return &PCB_acct_slabs[p->slot >> PCB_SLAB_SHIFT][p->slot & PCB_SLAB_MASK];
+}
+
+/** \return the paging record of a PCB. */
+static inline PCB_MEM *PCB_mem(PCB * p)
+{
+    return &PCB_mem_slabs[p->slot >> PCB_SLAB_SHIFT][p->slot & PCB_SLAB_MASK];
+}
+
+/** \return the scheduler record of a PCB. */
+static inline PCB_SCHED *PCB_sched(PCB * p)
+{
+    return &PCB_sched_slabs[p->slot >> PCB_SLAB_SHIFT][p->slot & PCB_SLAB_MASK];
+}
+
+/** \return the tuning record of a PCB. Only valid once the table has been
+ *          set up with PCB_table_tune(). */
+static inline PCB_TUNE *PCB_tune(PCB * p)
+{
+    return &PCB_tune_slabs[p->slot >> PCB_SLAB_SHIFT][p->slot & PCB_SLAB_MASK];
+}
+
+/** Give every PCB a tuning record. Called before the first PCB_new(). */
+void PCB_table_tune();
+
+/** Return a pointer to a new PCB object.
  *  \param tau_init is the system's initial value for estimated burst time. */
 PCB *PCB_new(double tau_init, int p_size, int page_size, int num_pages);
 
-/** Free an allocated PCB object. */
-void PCB_free(PCB *recycle); 
+/** \return the live PCB with PID pid, NULL if there is none. */
+PCB *PCB_find(int pid);
+
+/** Free an allocated PCB object. Its slot goes back on the table's free
+ *  list for reuse by the next PCB_new(). */
+void PCB_free(PCB *recycle);
+
+/** Walk the live PCB's in table order.
+ *  \return the live PCB after p, the first one if p is NULL, or NULL when
+ *          there are no more. */
+PCB *PCB_next(PCB * p);
+
+/** Drop one outstanding I/O request of a blocked process, freeing the PCB
+ *  along with the last one. Used when device queues holding several 
+ *  requests of the same process are torn down. Kernel requests have no 
+ *  PCB; NULL is ignored. */
+void PCB_io_release(PCB * p);
+
+/** Release the slabs of the process table. Every PCB must have been freed
+ *  beforehand. */
+void PCB_table_free();
 
 
 #endif
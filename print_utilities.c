@@ -2,13 +2,133 @@
  *  print_utilities.c */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "print_utilities.h"
 
+/** Predictions of a recent burst: adaptive, with the system's a, and the
+ *  burst itself as the perfect one. */
+#define PRED_TAU        0
+#define PRED_FIXED      1
+#define PRED_ORACLE     2
+
+static double predicted(BURST_SAMPLE * s, int which)
+{
+    return which == PRED_TAU ? s->TAU : which == PRED_FIXED ? s->TAU_FIXED
+                                                            : s->BURST;
+}
+
+/** \return the fraction of pairs of the n recent bursts of different
+ *          lengths that the predictions order like the bursts, as SJF
+ *          would. A tied prediction counts half. */
+static double pairs_in_order(BURST_SAMPLE * s, int n, int which)
+{
+    double right = 0;
+    int pairs = 0;
+    for(int i = 0; i < n; i++)
+        for(int j = i + 1; j < n; j++){
+            double d = s[i].BURST - s[j].BURST;
+            if( d == 0 )
+                continue;
+            double p = predicted(&s[i], which) - predicted(&s[j], which);
+            pairs++;
+            right += p * d > 0 ? 1 : p == 0 ? 0.5 : 0;
+        }
+    return pairs ? right / pairs : 1;
+}
+
+/** \return the mean time the n recent bursts would wait for one another
+ *          if they were all ready at once and run shortest prediction
+ *          first. */
+static double sjf_wait(BURST_SAMPLE * s, int n, int which)
+{
+    int order[BURST_WINDOW];
+    for(int i = 0; i < n; i++){
+        int j = i;
+        while( j > 0 && predicted(&s[order[j-1]], which) 
+                        > predicted(&s[i], which) ){
+            order[j] = order[j-1];
+            j--;
+        }
+        order[j] = i;
+    }
+    double start = 0;
+    double waited = 0;
+    for(int i = 0; i < n; i++){
+        waited += start;
+        start += s[order[i]].BURST;
+    }
+    return n ? waited / n : 0;
+}
+
+/** Print how well burst prediction would order the recent bursts for SJF,
+ *  the adaptive predictions against the system's a when they differ. */
+static void print_prediction(SYSGEN * sys)
+{
+    int n = sys->RECENT_n < BURST_WINDOW ? sys->RECENT_n : BURST_WINDOW;
+    BURST_SAMPLE * s = sys->RECENT;
+    printf("SJF on the last %d burst(s): a = %.2lf orders %.1lf%% of pairs"
+           " right, mean wait %.3lfms",
+            n,
+            sys->a,
+            100 * pairs_in_order(s, n, PRED_FIXED),
+            sjf_wait(s, n, PRED_FIXED));
+    if( sys->ADAPT )
+        printf("; alpha per process %.1lf%%, %.3lfms, prediction error"
+               " %.3lfms against %.3lfms",
+                100 * pairs_in_order(s, n, PRED_TAU),
+                sjf_wait(s, n, PRED_TAU),
+                sys->PRED_ERR.mean,
+                sys->FIXED_ERR.mean);
+    printf("; shortest first %.3lfms.\n", sjf_wait(s, n, PRED_ORACLE));
+}
+
 void print_system_CPU_time(SYSGEN * sys)
 {
     printf("System average CPU time of completed processes:" 
             " %.3lfms.\n", 
-            sys->CPU_avg);
+            sys->CPU_TOTAL.mean);
+    printf("CPU bursts: %ld, mean %.3lfms, sd %.3lfms, p50 %.3lfms, p90"
+           " %.3lfms, p99 %.3lfms; prediction error with %s%.2lf: mean"
+           " %.3lfms, sd %.3lfms.\n",
+            sys->BURST.n,
+            sys->BURST.mean,
+            WELFORD_sd(&sys->BURST),
+            QSKETCH_get(&sys->BURST_P50),
+            QSKETCH_get(&sys->BURST_P90),
+            QSKETCH_get(&sys->BURST_P99),
+            sys->ADAPT ? "alpha per process from a = " : "a = ",
+            sys->a,
+            sys->PRED_ERR.mean,
+            WELFORD_sd(&sys->PRED_ERR));
+    print_prediction(sys);
+    printf("Longest wait: ready queue %.3lfms (aging %.3lf), job pool"
+           " %.3lfms (aging %.3lf).\n",
+            sys->READY_QUEUE->WAIT_MAX,
+            sys->READY_QUEUE->aging,
+            sys->JOB_QUEUE->WAIT_MAX,
+            sys->JOB_QUEUE->aging);
+    if( sys->RT )
+        printf("Real-time: %d process(es), density %.3lf of %.3lf, %ld"
+               " turned away; %ld job(s), %ld missed, %ld over budget;"
+               " response mean %.3lfms, sd %.3lfms; latest %.3lfms past a"
+               " deadline.\n",
+                sys->RT->TASK_n,
+                sys->RT->UTIL,
+                sys->RT->cap,
+                sys->RT->REJECT_n,
+                sys->RT->JOB_n,
+                sys->RT->MISS_n,
+                sys->RT->OVERRUN_n,
+                sys->RT->RESPONSE.mean,
+                WELFORD_sd(&sys->RT->RESPONSE),
+                sys->RT->LATE_MAX);
+    printf("System time: %.3lfms (%.2lf%% of %.3lfms elapsed), context"
+            " switches %.3lfms over %ld switches.\n",
+            sys->SYS_t,
+            sys->clock > 0 ? 100 * sys->SYS_t / sys->clock : 0.0,
+            sys->clock,
+            sys->SWITCH_t,
+            sys->SWITCH_n);
 }
 
 void print_rq_header()
@@ -18,28 +138,77 @@ void print_rq_header()
     char * CPU_TIME         = "CPU_TIME";
     char * TAU_NEXT         = "TAU_NEXT";
     char * TAU_REMAINING    = "TAU_REMAINING";
+    char * BURST_SD         = "BURST_SD";
+    char * PRED_ERR         = "PRED_ERR";
+    char * ALPHA            = "ALPHA";
 
-    printf("%-4s %-10s %-9s %-9s %-15s\n",  
+    printf("%-4s %-10s %-9s %-9s %-15s %-9s %-9s %-5s\n",  
             PID, 
             BURST_AVG,
             CPU_TIME,
             TAU_NEXT,
-            TAU_REMAINING); 
+            TAU_REMAINING,
+            BURST_SD,
+            PRED_ERR,
+            ALPHA); 
+}
+
+/** Print the history parameter ptr's predictions follow: its own once
+ *  adaptive prediction has tuned one, the system's a otherwise. */
+static void print_alpha(PCB * ptr, SYSGEN * sys)
+{
+    double a = PCB_acct(ptr)->ALPHA;
+    printf("%-5.2lf ", a >= 0 ? a : sys->a);
+}
+
+/** Walk callback printing one ready queue row. */
+static void print_rq_entry(PCB * ptr, void * arg)
+{
+    printf("%-4d "     ,     ptr->PID);
+    printf("%-10.3lf " ,     PCB_acct(ptr)->BURST.mean);
+    printf("%-9.3lf " ,     PCB_acct(ptr)->CPU_t);
+    printf("%-9.3lf " ,     PCB_acct(ptr)->TAU_n_plus1);  
+    printf("%-15.3lf " ,     ptr->TAU_r);
+    printf("%-9.3lf " ,     WELFORD_sd(&PCB_acct(ptr)->BURST));
+    printf("%-9.3lf " ,     PCB_acct(ptr)->PRED_ERR.mean);
+    print_alpha(ptr, arg);
+    printf("\n");
+}
+
+/** Print the jobs of the real-time processes, wherever the processes
+ *  are. */
+static void print_realtime(SYSGEN * sys)
+{
+    printf("%-4s %-9s %-9s %-9s %-9s %-9s %-6s %-6s\n",
+            "PID", "PERIOD", "BUDGET", "DEADLINE", "DUE", "LEFT", "JOBS",
+            "MISSED");
+    printf("----Real-time\n");
+    for(PCB * ptr = PCB_next(NULL); ptr; ptr = PCB_next(ptr)){
+        PCB_RT * rt = &PCB_acct(ptr)->RT;
+        if( rt->PERIOD == 0 )
+            continue;
+        printf("%-4d %-9.3lf %-9.3lf %-9.3lf %-9.3lf ",
+                ptr->PID, rt->PERIOD, rt->BUDGET, rt->DEADLINE, rt->DUE);
+        if( rt->DONE )
+            printf("%-9s ", "done");
+        else
+            printf("%-9.3lf ", rt->LEFT);
+        printf("%-6ld %-6ld\n", rt->JOB_n, rt->MISS_n);
+    }
 }
 
 void print_ready_queue(SYSGEN * sys)
 {
-    PCB * ptr = sys->READY_QUEUE->head;
-    char * dummy = "";
-    printf("----Ready Queue\n");
-    while( ptr ){
-        printf("%-4d "     ,     ptr->PID);
-        printf("%-10.3lf " ,     ptr->BURST_avg);
-        printf("%-9.3lf " ,     ptr->CPU_t);
-        printf("%-9.3lf " ,     ptr->TAU_n_plus1);  
-        printf("%-15.3lf " ,     ptr->TAU_r);
+    READYQ * rq = sys->READY_QUEUE;
+    if( rq->rt )
+        printf("----Ready Queue (%s, %s)\n", rq->rt->policy->name,
+               rq->policy->name);
+    else
+        printf("----Ready Queue (%s)\n", rq->policy->name);
+    READYQ_walk(rq, print_rq_entry, sys);
+    if( sys->RT ){
         printf("\n");
-        ptr = ptr->LINK;
+        print_realtime(sys);
     }
 }
 
@@ -63,6 +232,19 @@ void print_header()
             FILELEN);
 }
 
+/** Print the PID, burst average and CPU time of the process that made a
+ *  request, or dashes for a kernel request. */
+static void print_requester(D_NODE * ptr)
+{
+    if( ptr->D_PCB == NULL ){
+        printf("%-4s %-10s %-9s ", "-", "-", "-");
+        return;
+    }
+    printf("%-4d " ,        ptr->D_PCB->PID);
+    printf("%-10.2f ",        PCB_acct(ptr->D_PCB)->BURST.mean);
+    printf("%-9.2f ",        PCB_acct(ptr->D_PCB)->CPU_t);
+}
+
 void print_printer_queues(SYSGEN * sys)
 {
     for( int i = 0; i < sys->PRINTER_COUNT; i++){
@@ -72,9 +254,7 @@ void print_printer_queues(SYSGEN * sys)
             D_NODE * ptr = sys->PRINTERS[i]->head;
             printf("----p%d\n", i+1);
             while(ptr){
-                printf("%-4d " ,        ptr->D_PCB->PID);
-                printf("%-10.2f ",        ptr->D_PCB->BURST_avg);
-                printf("%-9.2f ",        ptr->D_PCB->CPU_t);
+                print_requester(ptr);
                 printf("%-10s ",        ptr->PROCESS_PARAMS.FILE_NAME);
                 printf("%-9x ",        ptr->PROCESS_PARAMS.MEM_START);
                 printf("%-4c " ,        ptr->PROCESS_PARAMS.READ_WRITE);
@@ -96,9 +276,7 @@ void print_flashdrive_queues(SYSGEN * sys)
             D_NODE * ptr = sys->FLASHDRIVES[i]->head;
             printf("----f%d\n", i+1);
             while(ptr){
-                printf("%-4d " ,        ptr->D_PCB->PID);
-                printf("%-10.2f ",        ptr->D_PCB->BURST_avg);
-                printf("%-9.2f ",        ptr->D_PCB->CPU_t);
+                print_requester(ptr);
                 printf("%-10s ",        ptr->PROCESS_PARAMS.FILE_NAME);
                 printf("%-9x ",        ptr->PROCESS_PARAMS.MEM_START);
                 printf("%-4c " ,        ptr->PROCESS_PARAMS.READ_WRITE);
@@ -133,15 +311,16 @@ void print_disk_header()
             CYLINDER); 
 }
 
+static void print_job(PCB * ptr, void * arg)
+{
+    printf("%-5d %-12d \n", ptr->PID, PCB_mem(ptr)->proc_size);
+}
+
 void print_job_queue(SYSGEN * sys)
 {
     printf("%-5s %-12s \n", "PID", "Process Size");  
     printf("----Job Pool\n");
-    PCB * ptr = sys->JOB_QUEUE->head;
-    while( ptr ){
-        printf("%-5d %-12d \n", ptr->PID, ptr->proc_size);
-        ptr = ptr->LINK;
-    }
+    JOBQ_walk(sys->JOB_QUEUE, print_job, NULL);
 }
 
 void print_disk_queues(SYSGEN * sys)
@@ -153,9 +332,7 @@ void print_disk_queues(SYSGEN * sys)
             D_NODE * ptr = sys->DISKS[i]->head;
             printf("----d%d\n", i+1);
             while(ptr){
-                printf("%-4d " ,        ptr->D_PCB->PID);
-                printf("%-10.2f ",        ptr->D_PCB->BURST_avg);
-                printf("%-9.2f ",        ptr->D_PCB->CPU_t);
+                print_requester(ptr);
                 printf("%-10s ",        ptr->PROCESS_PARAMS.FILE_NAME);
                 printf("%-9x ",        ptr->PROCESS_PARAMS.MEM_START);
                 printf("%-4c " ,        ptr->PROCESS_PARAMS.READ_WRITE);
@@ -177,36 +354,529 @@ void print_cpu(SYSGEN * sys)
     printf("----CPU\n");
     if(!ptr) return;
         printf("%-4d "     ,     ptr->PID);
-        printf("%-10.3lf " ,     ptr->BURST_avg);
-        printf("%-9.3lf " ,     ptr->CPU_t);
-        printf("%-9.3lf " ,     ptr->TAU_n_plus1);  
+        printf("%-10.3lf " ,     PCB_acct(ptr)->BURST.mean);
+        printf("%-9.3lf " ,     PCB_acct(ptr)->CPU_t);
+        printf("%-9.3lf " ,     PCB_acct(ptr)->TAU_n_plus1);  
         printf("%-15.3lf " ,     ptr->TAU_r);
+        printf("%-9.3lf " ,     WELFORD_sd(&PCB_acct(ptr)->BURST));
+        printf("%-9.3lf " ,     PCB_acct(ptr)->PRED_ERR.mean);
+        print_alpha(ptr, sys);
         printf("\n");
 
 }
 
-void print_frame_table(SYSGEN * sys)
+void print_groups(SYSGEN * sys)
+{
+    RGSET * gs = sys->GROUPS;
+    if( gs == NULL )
+        return;
+    printf("%-5s %-6s %-5s %-5s %-5s %-9s %-6s %-6s %-6s %-9s %-6s\n",
+            "GROUP", "WEIGHT", "CAP", "QUOTA", "PROCS", "CPU_TIME",
+            "SHARE", "FRAMES", "PEAK", "THROTTLED", "DENIED");
+    printf("----Resource groups");
+    if( gs->period > 0 )
+        printf(" (cap period %.3lfms)", gs->period);
+    printf("\n");
+    for(int i = 0; i < gs->count; i++){
+        RGROUP * g = &gs->g[i];
+        printf("%-5d %-6.2lf ", g->NUM, g->weight);
+        if( g->cap > 0 )
+            printf("%-5.2lf ", g->cap);
+        else
+            printf("%-5s ", "-");
+        if( g->quota > 0 )
+            printf("%-5d ", g->quota);
+        else
+            printf("%-5s ", "-");
+        printf("%-5d %-9.3lf %5.1lf%% %-6d %-6d %-9ld %-6ld\n",
+                g->PROC_n,
+                g->CPU_t,
+                sys->CPU->BUSY_t > 0 ? 100 * g->CPU_t / sys->CPU->BUSY_t
+                                     : 0.0,
+                g->FRAMES,
+                g->FRAMES_MAX,
+                g->THROTTLE_n,
+                g->QUOTA_n);
+    }
+}
+
+/** Count a run of len frames in hist, by powers of two. */
+static void count_run(int * hist, int len)
 {
-    printf("Free frames: ");
-    for( int i = sys->frame_bag.counter; i >= 0; i--)
-    {
-        printf("%d, ", sys->frame_bag.frames[i]);
+    int b = 0;
+    while( (2 << b) <= len )
+        b++;
+    hist[b]++;
+}
+
+static void print_hist(char * title, int * hist)
+{
+    int none = 1;
+    printf("%s:", title);
+    for(int b = 0; b < 31; b++){
+        if( hist[b] == 0 )
+            continue;
+        none = 0;
+        if( b == 0 )
+            printf(" 1 x%d", hist[b]);
+        else
+            printf(" %d-%d x%d", 1 << b, (2 << b) - 1, hist[b]);
+    }
+    printf("%s\n", none ? " none" : "");
+}
+
+/** Print the free and used runs of frames. Everything here comes from the
+ *  free list and the processes' counters; no frame is looked at. */
+static void print_frame_summary(SYSGEN * sys)
+{
+    frame_list * fl = &sys->frame_bag;
+    int cache = sys->CACHE ? sys->CACHE->capacity : 0;
+    int largest = MEM_largest_free(sys);
+    printf("Free frames: %d in %d run(s), largest %d, fragmentation"
+           " %.2f.\n",
+            sys->num_free_frames,
+            fl->count,
+            largest,
+            sys->num_free_frames ? 
+                1.0 - (double)largest / sys->num_free_frames : 0.0);
+
+    /** Used runs are the gaps between free ones, below the cache. */
+    int free_hist[32] = { 0 };
+    int used_hist[32] = { 0 };
+    int used_runs = 0;
+    int end = 0;
+    printf("Free runs:");
+    for(int k = 0; k < fl->count; k++){
+        FRAME_RUN * r = &fl->runs[k];
+        if( k < RUN_LIST && r->len == 1 )
+            printf(" %d", r->start);
+        else if( k < RUN_LIST )
+            printf(" %d-%d", r->start, r->start + r->len - 1);
+        count_run(free_hist, r->len);
+        if( r->start > end ){
+            count_run(used_hist, r->start - end);
+            used_runs++;
+        }
+        end = r->start + r->len;
+    }
+    if( fl->count > RUN_LIST )
+        printf(" and %d more", fl->count - RUN_LIST);
+    printf("%s\n", fl->count == 0 ? " none" : "");
+    if( sys->num_frames - cache > end ){
+        count_run(used_hist, sys->num_frames - cache - end);
+        used_runs++;
+    }
+    print_hist("Free run lengths", free_hist);
+    printf("Used runs: %d", used_runs);
+    if( cache > 0 )
+        printf(", cache %d-%d", sys->num_frames - cache, sys->num_frames - 1);
+    printf("\n");
+    print_hist("Used run lengths", used_hist);
+
+    printf("Resident pages by PID:");
+    for(PCB * p = PCB_next(NULL); p; p = PCB_next(p)){
+        PCB_MEM * mem = PCB_mem(p);
+        if( mem->resident == 0 && mem->swapped == 0 )
+            continue;
+        printf(" %d=%d", p->PID, mem->resident);
+        if( mem->swapped > 0 )
+            printf(" (+%d on swap)", mem->swapped);
     }
-    printf("\n\n");
-    printf("%-10s %-10s %-10s %-10s %-15s\n", 
+    printf("\n");
+}
+
+void print_frames(SYSGEN * sys, int first, int last)
+{
+    if( last >= sys->num_frames )
+        last = sys->num_frames - 1;
+    if( first < 0 )
+        first = 0;
+    int shown = last;
+    if( shown - first + 1 > FRAME_PAGE )
+        shown = first + FRAME_PAGE - 1;
+    printf("%-10s %-10s %-10s %-10s %-5s %-15s\n", 
             "Frame", 
             "PID", 
             "Status",
             "Page Number",
+            "Refs",
             "Physical base address"); 
-    for(int i = 0; i < sys->num_frames; i++){
-        printf("%-10d %-10d %-10s %-10x   %-15x\n", 
+    for(int i = first; i <= shown; i++){
+        printf("%-10d %-10d %-10s %-10x  %-5d %-15x\n", 
                 i, 
                 sys->frame_table[i].PID,
-                sys->frame_table[i].PID == -1 ? "Free" : "Taken", 
+                sys->frame_table[i].PID == -1          ? "Free"   :
+                sys->frame_table[i].PID == FRAME_CACHE ? "Cache"  :
+                sys->frame_table[i].REF > 1            ? "Shared" : "Taken",
                 sys->frame_table[i].PAGE_NUM, 
+                sys->frame_table[i].REF,
                 i*sys->frame_size);
         }
+    if( shown < last )
+        printf("Frames %d-%d not shown; ask again from frame %d.\n",
+                shown + 1, last, shown + 1);
+}
+
+void print_frame_table(SYSGEN * sys)
+{
+    print_frame_summary(sys);
+    printf("\n");
+    if( sys->num_frames <= FRAME_PAGE )
+        print_frames(sys, 0, sys->num_frames - 1);
+    else
+        printf("%d frames; snapshot M lists a range of them.\n",
+                sys->num_frames);
+    printf("\nForks: %ld, pages copied on write: %ld, reclaimed by the last"
+            " sharer: %ld, frames saved by sharing: %d.\n",
+            sys->FORK_n,
+            sys->COW_COPY_n,
+            sys->COW_REUSE_n,
+            sys->FRAMES_SHARED);
+
+    /** Each frame is counted once, however many processes map it. */
+    int cache = sys->CACHE ? sys->CACHE->capacity : 0;
+    int used = sys->num_frames - sys->num_free_frames - cache;
+    printf("Frames in use: %d, mapped %d times.\n",
+            used,
+            used + sys->FRAMES_SHARED);
+    PT_CONFIG * pt = sys->PT;
+    printf("Page tables: %d level(s), %ld table(s) of %ld word(s), flat"
+           " %ld; %ld translation(s), %.2f table(s) read each; %ld large"
+           " page(s), %ld split; %ld page(s) zero-filled.\n",
+            pt->levels,
+            pt->TABLE_n,
+            pt->WORDS,
+            pt->FLAT_WORDS,
+            pt->WALK_n,
+            pt->WALK_n ? (double)pt->STEP_n / pt->WALK_n : 0.0,
+            pt->LARGE_n,
+            pt->SPLIT_n,
+            sys->ZERO_FILL_n);
+    for(SHM_SEG * seg = sys->SEGMENTS; seg; seg = seg->next){
+        printf("Segment %s: %d page(s) from frame %d, %d mapping(s):",
+                seg->name,
+                seg->num_pages,
+                seg->frames[0],
+                sys->frame_table[seg->frames[0]].REF);
+        printf(" %d", sys->frame_table[seg->frames[0]].PID);
+        for(RMAP * r = sys->frame_table[seg->frames[0]].rmap; r; r = r->next)
+            printf(" %d", r->pcb->PID);
+        printf("\n");
+    }
+    SWAP * sw = sys->SWAP;
+    if( sw )
+        printf("Swap on d%d: %d of %d slot(s) used, %ld swap-out(s) of %ld"
+               " page(s), %ld swap-in(s) of %ld page(s), %d waiting,"
+               " overcommit %.2f.\n",
+                sw->disk,
+                sw->slots - sw->free,
+                sw->slots,
+                sw->SWAP_OUT_n,
+                sw->PAGES_OUT_n,
+                sw->SWAP_IN_n,
+                sw->PAGES_IN_n,
+                sw->WAIT_n,
+                (double)(used + sw->slots - sw->free)
+              / (double)(sys->num_frames - cache));
+
+    /** Working sets of the processes in memory. */
+    WSET * ws = sys->WS;
+    if( ws == NULL )
+        return;
+    printf("Working sets: %d page(s) over %d sample(s) of %.3lfms, %d"
+           " frame(s) for processes, %ld page fault(s), %ld allocation(s)"
+           " grown, %ld shrunk, %ld process(es) suspended.\n",
+            ws->SUM,
+            ws->window,
+            ws->interval,
+            sys->num_frames - cache,
+            ws->FAULT_n,
+            ws->GROW_n,
+            ws->SHRINK_n,
+            ws->SUSPEND_n);
+    printf("%-5s %-9s %-9s %-7s %-7s %-7s\n",
+            "PID", "Resident", "Swapped", "Alloc", "WSS", "Faults");
+    for(PCB * p = PCB_next(NULL); p; p = PCB_next(p)){
+        PCB_MEM * mem = PCB_mem(p);
+        if( mem->resident == 0 && mem->swapped == 0 )
+            continue;
+        printf("%-5d %-9d %-9d %-7d %-7d %-7d%s\n",
+                p->PID,
+                mem->resident,
+                mem->swapped,
+                mem->frames,
+                mem->wss,
+                mem->faults,
+                mem->suspended > 0 ? " suspended"   :
+                mem->suspended < 0 ? " swapping in" : "");
+    }
+}
+
+void print_device_stats(SYSGEN * sys, char kind)
+{
+    int count = kind == DEVICE_PRINTER ? sys->PRINTER_COUNT
+              : kind == DEVICE_DISK    ? sys->DISK_COUNT
+              :                          sys->FLASHDRIVE_COUNT;
+    printf("%-5s %-7s %-10s %-13s %-6s %-6s %-5s\n",
+            "DEV",
+            "UTIL%",
+            "AVG_DEPTH",
+            "AVG_RESP(ms)",
+            "DONE",
+            "IN_SVC",
+            "GC");
+    for( int i = 0; i < count; i++){
+        DEVICE * dev = DEVICE_lookup(sys, kind, i+1);
+        printf("%c%-4d %-7.2lf %-10.3lf %-13.3lf %-6ld %-6d %-5ld\n",
+                kind,
+                i+1,
+                100 * DEVICE_utilization(dev),
+                DEVICE_avg_depth(dev),
+                DEVICE_avg_response(dev),
+                dev->DONE_n,
+                dev->ACTIVE,
+                dev->GC_n);
+    }
+}
+
+void print_io_rings(SYSGEN * sys)
+{
+    IO_RING * ring = sys->IO;
+    long entries = ring->ENTER_n + ring->REAP_n;
+    printf("I/O rings: %ld requests in %ld submissions, %ld completions in"
+            " %ld interrupts.\n",
+            ring->SQE_n,
+            ring->ENTER_n,
+            ring->CQE_n,
+            ring->REAP_n);
+    printf("Kernel entries per I/O: %.3lf, overhead %.3lfms per I/O.\n",
+            ring->SQE_n > 0 ? (double)entries / ring->SQE_n : 0.0,
+            ring->SQE_n > 0 ? ring->OVERHEAD_t / ring->SQE_n : 0.0);
+}
+
+void print_buffer_cache(SYSGEN * sys)
+{
+    BCACHE * bc = sys->CACHE;
+    if( bc == NULL )
+        return;
+    long lookups = bc->HIT_n + bc->MISS_n;
+    printf("Buffer cache: %s, %d of %d blocks, %d dirty.\n",
+            BCACHE_policy_name(bc->policy),
+            bc->lists[BC_RECENT].size + bc->lists[BC_FREQUENT].size,
+            bc->capacity,
+            bc->dirty_n);
+    printf("Block hit rate %.2lf%% (%ld of %ld), disk reads avoided %ld of"
+            " %ld, writes absorbed %ld.\n",
+            lookups > 0 ? 100.0 * bc->HIT_n / lookups : 0.0,
+            bc->HIT_n,
+            lookups,
+            bc->READ_HIT_n,
+            bc->READ_n,
+            bc->WRITE_n);
+    printf("Blocks written back %ld, evicted %ld.\n",
+            bc->WRITEBACK_n,
+            bc->EVICT_n);
+}
+
+void print_readahead(SYSGEN * sys, char kind)
+{
+    if( sys->RA == NULL )
+        return;
+    RA_STATS * stats = READAHEAD_stats(sys->RA, kind);
+    long settled = stats->USEFUL_n + stats->WASTED_n;
+    printf("Readahead: %ld of %ld reads served, %ld prefetches issued,"
+            " %ld useful, %ld wasted (%.2lf%% useful).\n",
+            stats->SERVED_n,
+            stats->READ_n,
+            stats->ISSUED_n,
+            stats->USEFUL_n,
+            stats->WASTED_n,
+            settled > 0 ? 100.0 * stats->USEFUL_n / settled : 0.0);
+}
+
+void print_filesystems(SYSGEN * sys)
+{
+    printf("%-5s %-6s %-13s %-12s %-10s %-14s\n",
+            "DEV",
+            "FILES",
+            "BLOCKS",
+            "EXT/FILE",
+            "SEEK/REQ",
+            "BYTES/ms");
+    for( int i = 0; i < sys->DISK_COUNT; i++){
+        FSYS * fs = sys->FILESYS[i];
+        DEVICE * dev = DEVICE_lookup(sys, DEVICE_DISK, i+1);
+        char blocks[32];
+        snprintf(blocks, sizeof(blocks), "%u/%u", fs->USED_n, fs->total);
+        printf("d%-4d %-6d %-13s %-12.2lf %-10.2lf %-14.2lf\n",
+                i+1,
+                fs->FILE_n,
+                blocks,
+                fs->FILE_n > 0 ? (double)fs->EXTENT_n / fs->FILE_n : 0.0,
+                dev->DONE_n > 0 ? (double)dev->SEEK_n / dev->DONE_n : 0.0,
+                sys->clock > 0 ? dev->BYTES / sys->clock : 0.0);
+    }
+}
+
+void print_volume(SYSGEN * sys)
+{
+    VOLUME * vol = sys->VOL;
+    if( vol == NULL )
+        return;
+    double bytes = 0;
+    for( int i = 0; i < vol->members; i++)
+        bytes += DEVICE_lookup(sys, DEVICE_DISK, i+1)->BYTES;
+    double rate = sys->clock > 0 ? bytes / sys->clock : 0.0;
+    printf("Volume v1: %s over %d disks, stripe unit %d block(s), %u of %u"
+            " blocks used.\n",
+            VOLUME_layout_name(vol->layout),
+            vol->members,
+            vol->stripe,
+            vol->fs->USED_n,
+            vol->fs->total);
+    printf("Requests %ld split into %ld disk requests, %.0lf bytes"
+            " requested.\n",
+            vol->REQ_n,
+            vol->SUB_n,
+            vol->BYTES);
+    if( vol->layout == VOL_RAID10 )
+        printf("Mirrored reads sent to the second copy: %ld of %ld.\n",
+                vol->SECOND_n,
+                vol->READ_n);
+    printf("Member throughput %.2lf bytes/ms aggregate, %.2lf per disk.\n",
+            rate,
+            rate / vol->members);
 }
 
+/** One aggregate of the summary snapshot. */
+typedef struct AGG {
+    char        name[32];
+    double      val;
+    int         prec;           // Decimals printed.
+    int         line;           // 1 if it starts a new line.
+} AGG;
+
+static void add_agg(AGG * a, int * n, int line, int prec, double val,
+                    char * name)
+{
+    snprintf(a[*n].name, sizeof(a[*n].name), "%s", name);
+    a[*n].val = val;
+    a[*n].prec = prec;
+    a[*n].line = line;
+    (*n)++;
+}
 
+/** Add the queue and service counters of one device. */
+static void add_device(AGG * a, int * n, DEVICE * dev, int queued,
+                       long bytes)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%c%d queued", dev->KIND, dev->NUM);
+    add_agg(a, n, 1, 0, queued, name);
+    snprintf(name, sizeof(name), "%c%d bytes", dev->KIND, dev->NUM);
+    add_agg(a, n, 0, 0, bytes, name);
+    snprintf(name, sizeof(name), "%c%d in service", dev->KIND, dev->NUM);
+    add_agg(a, n, 0, 0, dev->ACTIVE, name);
+    snprintf(name, sizeof(name), "%c%d done", dev->KIND, dev->NUM);
+    add_agg(a, n, 0, 0, dev->DONE_n, name);
+}
+
+/** \return the aggregates there are room for in a. */
+static int agg_count(SYSGEN * sys)
+{
+    return 8 + 4 * (sys->PRINTER_COUNT + sys->DISK_COUNT 
+                    + sys->FLASHDRIVE_COUNT)
+             + 4 * (sys->GROUPS ? sys->GROUPS->count : 0);
+}
+
+/** Fill a with the aggregates of the summary snapshot. Each is a counter
+ *  kept up to date as queues change; no queue is walked.
+ *  \return how many there are, always the same for a system. */
+static int collect(SYSGEN * sys, AGG * a)
+{
+    int n = 0;
+    PCB * running = sys->CPU->RUNNING_PROCESS;
+    add_agg(a, &n, 1, 3, sys->clock, "clock (ms)");
+    add_agg(a, &n, 0, 1, sys->clock > 0 ? 
+                         100 * sys->CPU->BUSY_t / sys->clock : 0.0,
+            "CPU busy (%)");
+    add_agg(a, &n, 0, 0, running ? running->PID : 0, "running PID");
+    add_agg(a, &n, 0, 0, sys->READY_QUEUE->count, "ready");
+    add_agg(a, &n, 0, 0, sys->JOB_QUEUE->count, "job pool");
+    add_agg(a, &n, 0, 0, sys->JOB_QUEUE->WORDS, "job pool words");
+    add_agg(a, &n, 0, 0, sys->SWAP ? sys->SWAP->WAIT_n : 0, "swap queue");
+    add_agg(a, &n, 0, 0, sys->num_free_frames, "free frames");
+    for(int i = 0; i < sys->PRINTER_COUNT; i++)
+        add_device(a, &n, &sys->PRINTER_UNITS[i], sys->PRINTERS[i]->count,
+                   sys->PRINTERS[i]->BYTES);
+    for(int i = 0; i < sys->DISK_COUNT; i++)
+        add_device(a, &n, &sys->DISK_UNITS[i], sys->DISKS[i]->count,
+                   sys->DISKS[i]->BYTES);
+    for(int i = 0; i < sys->FLASHDRIVE_COUNT; i++)
+        add_device(a, &n, &sys->FLASH_UNITS[i], sys->FLASHDRIVES[i]->count,
+                   sys->FLASHDRIVES[i]->BYTES);
+    for(int i = 0; sys->GROUPS && i < sys->GROUPS->count; i++){
+        RGROUP * g = &sys->GROUPS->g[i];
+        char name[32];
+        snprintf(name, sizeof(name), "g%d processes", g->NUM);
+        add_agg(a, &n, 1, 0, g->PROC_n, name);
+        snprintf(name, sizeof(name), "g%d CPU (ms)", g->NUM);
+        add_agg(a, &n, 0, 3, g->CPU_t, name);
+        snprintf(name, sizeof(name), "g%d frames", g->NUM);
+        add_agg(a, &n, 0, 0, g->FRAMES, name);
+        snprintf(name, sizeof(name), "g%d throttled", g->NUM);
+        add_agg(a, &n, 0, 0, g->THROTTLE_n, name);
+    }
+    return n;
+}
+
+/** Keep the values of a as the base of the next diff. */
+static void keep_snap(SYSGEN * sys, AGG * a, int n)
+{
+    if( sys->SNAP == NULL )
+        sys->SNAP = malloc( sizeof(double) * n );
+    for(int i = 0; i < n; i++)
+        sys->SNAP[i] = a[i].val;
+    sys->SNAP_n = n;
+}
+
+void print_summary(SYSGEN * sys)
+{
+    AGG * a = malloc( sizeof(AGG) * agg_count(sys) );
+    int n = collect(sys, a);
+    for(int i = 0; i < n; i++)
+        printf("%s%s %.*f", 
+                i == 0 ? "" : a[i].line ? "\n" : ", ",
+                a[i].name,
+                a[i].prec,
+                a[i].val);
+    printf("\n");
+    keep_snap(sys, a, n);
+    free(a);
+}
+
+void print_changes(SYSGEN * sys)
+{
+    if( sys->SNAP == NULL ){
+        print_summary(sys);
+        return;
+    }
+    AGG * a = malloc( sizeof(AGG) * agg_count(sys) );
+    int n = collect(sys, a);
+    int changed = 0;
+    for(int i = 0; i < n; i++){
+        if( a[i].val == sys->SNAP[i] )
+            continue;
+        printf("%s%s %.*f -> %.*f", 
+                changed ? ", " : "",
+                a[i].name,
+                a[i].prec,
+                sys->SNAP[i],
+                a[i].prec,
+                a[i].val);
+        changed++;
+    }
+    printf(changed ? "\n" : "No change since the last snapshot.\n");
+    keep_snap(sys, a, n);
+    free(a);
+}
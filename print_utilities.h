@@ -17,7 +17,36 @@ void print_printer_queues(SYSGEN * sys);
 void print_flashdrive_queues(SYSGEN * sys);
 void print_disk_queues(SYSGEN * sys);
 void print_frame_table(SYSGEN * sys);
+
+/** Frames the memory snapshot lists one per line, and the most a frame
+ *  range lists at a time. Larger memories are summarized instead. */
+#define FRAME_PAGE  64
+
+/** Free runs the memory snapshot lists. */
+#define RUN_LIST    16
+
+/** Print frames first to last, FRAME_PAGE of them at most. */
+void print_frames(SYSGEN * sys, int first, int last);
 void print_job_queue(SYSGEN * sys);
+void print_device_stats(SYSGEN * sys, char kind);
+void print_io_rings(SYSGEN * sys);
+void print_buffer_cache(SYSGEN * sys);
+void print_readahead(SYSGEN * sys, char kind);
+void print_filesystems(SYSGEN * sys);
+void print_volume(SYSGEN * sys);
+
+/** Print the limits and usage of each resource group, if there are any. */
+void print_groups(SYSGEN * sys);
+
+/** Print the running aggregates: clock, CPU utilization, queue lengths,
+ *  per device the requests and bytes queued, in service and done, and
+ *  per resource group its processes, CPU time, frames and throttling.
+ *  They are counters kept as things change, so this walks no queue. */
+void print_summary(SYSGEN * sys);
+
+/** Print just the aggregates that changed since the last summary or
+ *  diff, with their old and new values. The first one prints them all. */
+void print_changes(SYSGEN * sys);
 
 
 
@@ -0,0 +1,220 @@
+/** \file
+ *  readahead.c:    Implementation for sequential readahead. */
+
+#include <stdlib.h>
+#include <string.h>
+#include "readahead.h"
+#include "sysgen.h"
+
+READAHEAD *READAHEAD_new(SYSGEN * sys, unsigned int min_window,
+                         unsigned int max_window)
+{
+    READAHEAD * ra = calloc( 1, sizeof(READAHEAD) );
+    ra->sys = sys;
+    ra->min_window = min_window;
+    ra->max_window = max_window;
+    return ra;
+}
+
+RA_STATS *READAHEAD_stats(READAHEAD * ra, char kind)
+{
+    return kind == DEVICE_DISK ? &ra->DISK : &ra->FLASH;
+}
+
+/** Drop the first prefetch of a stream. */
+static void drop_chunk(READAHEAD * ra, RA_STREAM * s)
+{
+    RA_CHUNK * c = s->head;
+    if( !c->USED )
+        READAHEAD_stats(ra, s->KIND)->WASTED_n++;
+    s->head = c->next;
+    if( s->head == NULL )
+        s->tail = NULL;
+    free(c);
+}
+
+/** Close a stream's window and drop its prefetches. Ones still in flight
+ *  find nothing when they complete: the stream moves on to a new
+ *  generation. */
+static void reset_stream(READAHEAD * ra, RA_STREAM * s)
+{
+    while( s->head )
+        drop_chunk(ra, s);
+    s->WINDOW = 0;
+    s->END = 0;
+    s->GEN = ++ra->GEN_n;
+}
+
+static void free_stream(READAHEAD * ra, RA_STREAM * s)
+{
+    reset_stream(ra, s);
+    free(s->name);
+    free(s);
+}
+
+/** \return the stream of a file on a device, NULL if it has none.
+ *  \param  prev receives the stream before it in the list. */
+static RA_STREAM *find_stream(READAHEAD * ra, char kind, int num,
+                              char * name, RA_STREAM ** prev)
+{
+    *prev = NULL;
+    for(RA_STREAM * s = ra->streams; s; *prev = s, s = s->next)
+        if( s->KIND == kind && s->NUM == num && !strcmp(s->name, name) )
+            return s;
+    return NULL;
+}
+
+/** \return the stream of req's file, moved to the front of the list. A new
+ *  stream recycles the least recently used one once there are RA_STREAMS.
+ *  \param  fresh is set to 1 if the stream is new. */
+static RA_STREAM *use_stream(READAHEAD * ra, char kind, int num,
+                             D_NODE * req, int * fresh)
+{
+    PARAMS * params = &req->PROCESS_PARAMS;
+    RA_STREAM * prev;
+    RA_STREAM * s = find_stream(ra, kind, num, params->FILE_NAME, &prev);
+    *fresh = s == NULL;
+    if( s ){
+        if( prev ){
+            prev->next = s->next;
+            s->next = ra->streams;
+            ra->streams = s;
+        }
+        return s;
+    }
+
+    if( ra->STREAM_n == RA_STREAMS ){
+        RA_STREAM ** link = &ra->streams;
+        while( (*link)->next )
+            link = &(*link)->next;
+        free_stream(ra, *link);
+        *link = NULL;
+        ra->STREAM_n--;
+    }
+    s = calloc( 1, sizeof(RA_STREAM) );
+    s->KIND = kind;
+    s->NUM = num;
+    s->name = strdup(params->FILE_NAME);
+    s->next = ra->streams;
+    ra->streams = s;
+    ra->STREAM_n++;
+    return s;
+}
+
+int READAHEAD_read(READAHEAD * ra, char kind, int num, D_NODE * req)
+{
+    PARAMS * params = &req->PROCESS_PARAMS;
+    RA_STATS * stats = READAHEAD_stats(ra, kind);
+    unsigned int off = params->FILE_OFF;
+    unsigned int end = off + (params->FILE_LEN > 0 ? params->FILE_LEN : 1);
+    int fresh;
+    RA_STREAM * s = use_stream(ra, kind, num, req, &fresh);
+    stats->READ_n++;
+
+    /** Sequential reads open the window and then double it; anything else
+     *  closes it. */
+    if( !fresh && off == s->NEXT ){
+        s->WINDOW = s->WINDOW ? 2 * s->WINDOW : ra->min_window;
+        if( s->WINDOW > ra->max_window )
+            s->WINDOW = ra->max_window;
+    }
+    else
+        reset_stream(ra, s);
+    s->NEXT = end;
+
+    /** Prefetches the reader has moved past are done with. */
+    while( s->head && s->head->OFF + s->head->LEN <= off )
+        drop_chunk(ra, s);
+
+    /** Covered if arrived prefetches run unbroken from off to end. */
+    unsigned int pos = off;
+    for(RA_CHUNK * c = s->head; c && pos < end; c = c->next){
+        if( c->OFF > pos || !c->ARRIVED )
+            break;
+        pos = c->OFF + c->LEN;
+    }
+    if( pos < end )
+        return 0;
+
+    for(RA_CHUNK * c = s->head; c && c->OFF < end; c = c->next)
+        if( !c->USED ){
+            c->USED = 1;
+            stats->USEFUL_n++;
+        }
+    stats->SERVED_n++;
+    return 1;
+}
+
+void READAHEAD_prefetch(READAHEAD * ra, char kind, int num, D_NODE * req)
+{
+    SYSGEN * sys = ra->sys;
+    RA_STREAM * prev;
+    RA_STREAM * s = find_stream(ra, kind, num,
+                                req->PROCESS_PARAMS.FILE_NAME, &prev);
+    if( s == NULL || s->WINDOW == 0 )
+        return;
+    if( s->END < s->NEXT )
+        s->END = s->NEXT;
+    if( s->END - s->NEXT > s->WINDOW / 2 )
+        return;
+
+    /** A disk prefetch lays out its whole range and goes to the cylinder
+     *  the range starts on. */
+    int cyl = 0;
+    if( kind == DEVICE_DISK ){
+        cyl = FSYS_cylinder(sys->FILESYS[num-1], s->name, s->END, s->WINDOW);
+        if( cyl < 0 )
+            return;
+    }
+
+    RA_CHUNK * c = calloc( 1, sizeof(RA_CHUNK) );
+    c->OFF = s->END;
+    c->LEN = s->WINDOW;
+    c->GEN = s->GEN;
+    if( s->tail )
+        s->tail->next = c;
+    else
+        s->head = c;
+    s->tail = c;
+    s->END += s->WINDOW;
+    READAHEAD_stats(ra, kind)->ISSUED_n++;
+
+    PARAMS obj = {  .CYLINDER = cyl,
+                    .FILE_NAME = strdup(s->name),
+                    .MEM_START = 0,
+                    .READ_WRITE = 'r',
+                    .FILE_LEN = c->LEN,
+                    .FILE_OFF = c->OFF };
+    D_NODE * pf = D_NODE_new(NULL, obj);
+    pf->RA_GEN = c->GEN;
+    if( kind == DEVICE_DISK )
+        DISKQ_enqueue(sys->DISKS[num-1], pf);
+    else
+        DEVICEQ_enqueue(sys->FLASHDRIVES[num-1], pf);
+    DEVICE_submit(DEVICE_lookup(sys, kind, num));
+}
+
+void READAHEAD_complete(READAHEAD * ra, char kind, int num, D_NODE * req)
+{
+    PARAMS * params = &req->PROCESS_PARAMS;
+    RA_STREAM * prev;
+    RA_STREAM * s = find_stream(ra, kind, num, params->FILE_NAME, &prev);
+    if( s == NULL )
+        return;
+    for(RA_CHUNK * c = s->head; c; c = c->next)
+        if(    c->GEN == req->RA_GEN && c->OFF == params->FILE_OFF
+            && !c->ARRIVED ){
+            c->ARRIVED = 1;
+            return;
+        }
+}
+
+void READAHEAD_free(READAHEAD * ra)
+{
+    while( ra->streams ){
+        RA_STREAM * s = ra->streams;
+        ra->streams = s->next;
+        free_stream(ra, s);
+    }
+    free(ra);
+}
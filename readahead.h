@@ -0,0 +1,113 @@
+/** \file
+ *  readahead.h:    Interface for sequential readahead (READAHEAD) on disks
+ *                  and flash drives.
+ *
+ *                  Reads are tracked per stream, a stream being one file on
+ *                  one device. A read that starts where the last one of its
+ *                  stream ended is sequential. The first sequential read
+ *                  opens a readahead window of the initial size, and every
+ *                  further one doubles it, up to the maximum. A read that
+ *                  breaks the sequence closes the window and drops whatever
+ *                  was prefetched for the stream.
+ *
+ *                  While a window is open, a prefetch of one window's worth
+ *                  is queued behind the demand read whenever less than half
+ *                  a window is left ahead of the reader. So the next
+ *                  prefetch is already in flight before the reader catches
+ *                  up. Prefetches are kernel requests: D_NODE's with no PCB.
+ *                  A demand read that lies entirely within prefetches that
+ *                  have arrived needs no device I/O and completes at once.
+ *
+ *                  A completing prefetch is matched to its chunk by offset
+ *                  and by the generation of its stream. The generation is
+ *                  new whenever the stream's prefetches are dropped, and on
+ *                  a recycled stream. So a prefetch still in flight from
+ *                  before can't pass for a new one of the same range.
+ *
+ *                  A prefetch is useful once a demand read has used it and
+ *                  wasted if it is dropped before that. Streams beyond
+ *                  RA_STREAMS are recycled least recently used first. */
+
+#ifndef READAHEAD_H_
+#define READAHEAD_H_
+
+#include "device_node.h"
+
+#define RA_STREAMS  64
+
+struct SYSGEN;
+
+/** One prefetch request. */
+typedef struct RA_CHUNK {
+    struct RA_CHUNK *   next;       // Next prefetch of the stream, by offset.
+    unsigned int        OFF;        // File range prefetched.
+    unsigned int        LEN;
+    long                GEN;        // Generation of the stream it was
+                                    //   issued in.
+    int                 ARRIVED;    // 1 once the prefetch completed.
+    int                 USED;       // 1 once a demand read used it.
+} RA_CHUNK;
+
+/** Readahead state of one file on one device. */
+typedef struct RA_STREAM {
+    struct RA_STREAM *  next;       // Streams, most recently used first.
+    char                KIND;       // Device class, see device.h.
+    int                 NUM;        // Device number.
+    char            *   name;       // File name.
+    unsigned int        NEXT;       // Offset a sequential read starts at.
+    unsigned int        WINDOW;     // Readahead window in bytes, 0 if
+                                    //   closed.
+    unsigned int        END;        // Prefetched up to here.
+    long                GEN;        // New whenever its prefetches are
+                                    //   dropped.
+    RA_CHUNK        *   head;       // Prefetches in offset order.
+    RA_CHUNK        *   tail;
+} RA_STREAM;
+
+/** Statistics for one device class. */
+typedef struct RA_STATS {
+    long                READ_n;     // Demand reads seen.
+    long                SERVED_n;   // Demand reads served by prefetches.
+    long                ISSUED_n;   // Prefetches issued.
+    long                USEFUL_n;   // Prefetches a demand read used.
+    long                WASTED_n;   // Prefetches dropped unused.
+} RA_STATS;
+
+/** READAHEAD struct. */
+typedef struct READAHEAD {
+    struct SYSGEN   *   sys;
+    unsigned int        min_window; // Window a stream opens with, bytes.
+    unsigned int        max_window; // Largest window, bytes.
+    RA_STREAM       *   streams;
+    int                 STREAM_n;
+    long                GEN_n;      // Stream generations handed out.
+    RA_STATS            DISK;       // Statistics for disks
+    RA_STATS            FLASH;      //   and flash drives.
+} READAHEAD;
+
+/** Generate and return a READAHEAD for sys.
+ *  \param  min_window is the window, in bytes, a sequential stream opens
+ *          with.
+ *  \param  max_window is the largest window in bytes. */
+READAHEAD *READAHEAD_new(struct SYSGEN * sys, unsigned int min_window,
+                         unsigned int max_window);
+
+/** A demand read req was made on device kind num. Updates its stream.
+ *  \return 1 if prefetches that have arrived cover it, so it needs no
+ *          device I/O, 0 otherwise. */
+int READAHEAD_read(READAHEAD * ra, char kind, int num, D_NODE * req);
+
+/** Top up the readahead window of req's stream. Called once the demand
+ *  read req has been queued or served, so prefetches queue behind it. */
+void READAHEAD_prefetch(READAHEAD * ra, char kind, int num, D_NODE * req);
+
+/** A prefetch on device kind num completed. */
+void READAHEAD_complete(READAHEAD * ra, char kind, int num, D_NODE * req);
+
+/** \return the statistics for a device class. */
+RA_STATS *READAHEAD_stats(READAHEAD * ra, char kind);
+
+/** Free the READAHEAD and all stream state. */
+void READAHEAD_free(READAHEAD * ra);
+
+#endif
@@ -1,124 +1,201 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "ready_queue.h"
+#include "rgroup.h"
 
-READYQ *READYQ_new()
+READYQ *READYQ_new(int policy, double quantum, double aging,
+                   const double * clock)
 {
     READYQ *rq = malloc( sizeof(READYQ) );
-    *rq = (READYQ){ .head = NULL, .tail = NULL};
+    *rq = (READYQ){ .policy = SCHED_lookup(policy),
+                    .state = NULL,
+                    .count = 0,
+                    .quantum = quantum,
+                    .aging = aging,
+                    .clock = clock,
+                    .rt = NULL,
+                    .held = NULL,
+                    .HELD_n = 0,
+                    .WAIT_MAX = 0};
+    rq->policy->init(rq);
     return rq;
 }
 
+void READYQ_rt_class(READYQ * rq)
+{
+    rq->rt = READYQ_new(SCHED_POLICY_EDF, 0, 0, rq->clock);
+}
 
-/** READYQ is now a priority queue. TAU_r is used as a key for insertions, 
- *  with lower TAU_r values having a higher priority. */
-void READYQ_enqueue(READYQ * rq, PCB *insert)
+/** \return 1 if pcb belongs to rq's real-time class. */
+static int is_rt(READYQ * rq, PCB * pcb)
+{
+    return rq->rt && PCB_acct(pcb)->RT.PERIOD > 0;
+}
+
+int READYQ_can_run(READYQ * rq, PCB * pcb)
+{
+    PCB_RT * rt = &PCB_acct(pcb)->RT;
+    RGROUP * g = PCB_acct(pcb)->GROUP;
+    if( g && g->THROTTLED )
+        return 0;
+    return !is_rt(rq, pcb) || (!rt->DONE && rt->LEFT >= RT_MIN_LEFT);
+}
+
+int READYQ_unhold(READYQ * rq, PCB * pcb)
+{
+    PCB_SCHED * sch = PCB_sched(pcb);
+    if( sch->queued != 2 )
+        return 0;
+    if( sch->prev )
+        sch->prev->LINK = pcb->LINK;
+    else
+        rq->held = pcb->LINK;
+    if( pcb->LINK )
+        PCB_sched(pcb->LINK)->prev = sch->prev;
+    pcb->LINK = NULL;
+    rq->HELD_n--;
+    sch->queued = 0;
+    return 1;
+}
+
+/** Put pcb on the held list. */
+static void hold(READYQ * rq, PCB * pcb)
 {
-    double ins_key = insert->TAU_r; 
-    PCB * save_ptr;
+    PCB_sched(pcb)->prev = NULL;
+    if( rq->held )
+        PCB_sched(rq->held)->prev = pcb;
+    pcb->LINK = rq->held;
+    rq->held = pcb;
+    rq->HELD_n++;
+    PCB_sched(pcb)->queued = 2;
+}
 
-    if( READYQ_empty(rq) ){
-        rq->head = insert;
-        rq->tail = insert; 
+void READYQ_enqueue(READYQ * rq, PCB *insert)
+{
+    insert->LINK = NULL;
+    PCB_acct(insert)->READY_AT = *rq->clock;
+    if( !READYQ_can_run(rq, insert) ){
+        hold(rq, insert);
+        return;
     }
-    else{
-        /** If the head of the queue has a higher TAU_r than the insert key, 
-         *  queue the process at the front. */
-        if( rq->head->TAU_r > ins_key ){
-            save_ptr = rq->head; 
-            rq->head = insert; 
-            rq->head->LINK = save_ptr; 
-        }
-        else{
-            /** Otherwise iterate through starting from the head,
-             *  checking for nodes which have a higher TAU_r value than 
-             *  the insert key; insert before such a node. */
-            PCB * curr_ptr = rq->head;
-            while( curr_ptr->LINK ){
-                if( curr_ptr->LINK->TAU_r > ins_key ){
-                    save_ptr = curr_ptr->LINK;
-                    curr_ptr->LINK = insert; 
-                    insert->LINK = save_ptr; 
-                    break;
-                }
-                else{
-                    curr_ptr = curr_ptr->LINK;
-                }
-            }
-            /** Reached the end of the list, insert at the end. */
-            if( curr_ptr->LINK == NULL){
-                rq->tail->LINK = insert;
-                rq->tail = insert;
-            }
-        }
+    if( is_rt(rq, insert) ){
+        rq->rt->policy->enqueue(rq->rt, insert);
+        rq->rt->count++;
     }
-    while( rq->tail->LINK ) 
-        rq->tail->LINK = rq->tail->LINK->LINK;
+    else
+        rq->policy->enqueue(rq, insert);
+    rq->count++;
+    PCB_sched(insert)->queued = 1;
+    RG_ready(PCB_acct(insert)->GROUP, 1);
 }
 
+/** Members of a group throttled while they were queued are still on the
+ *  queue; they are moved to the held list as they come up. */
 void READYQ_dequeue(READYQ * rq, PCB** dequeued )
 {
-    if( !READYQ_empty(rq) )
-    {
-        *dequeued = rq->head;
-        if( rq->head == rq->tail ){
-            rq->head = NULL;
-            rq->tail = NULL;
+    *dequeued = NULL;
+    while( !READYQ_empty(rq) ){
+        PCB * next;
+        if( rq->rt && !READYQ_empty(rq->rt) ){
+            next = rq->rt->policy->pick_next(rq->rt);
+            rq->rt->count--;
         }
         else
-            rq->head = rq->head->LINK;
-        
-        (*dequeued)->LINK = NULL;
+            next = rq->policy->pick_next(rq);
+        rq->count--;
+        next->LINK = NULL;
+        PCB_sched(next)->queued = 0;
+        RG_ready(PCB_acct(next)->GROUP, -1);
+        if( !READYQ_can_run(rq, next) ){
+            hold(rq, next);
+            continue;
+        }
+        double wait = *rq->clock - PCB_acct(next)->READY_AT;
+        if( wait > rq->WAIT_MAX )
+            rq->WAIT_MAX = wait;
+        *dequeued = next;
+        return;
+    }
+}
+
+int READYQ_remove(READYQ * rq, PCB * pcb)
+{
+    if( READYQ_unhold(rq, pcb) )
+        return 1;
+    if( PCB_sched(pcb)->queued != 1 )
+        return 0;
+    if( is_rt(rq, pcb) ){
+        rq->rt->policy->remove(rq->rt, pcb);
+        rq->rt->count--;
     }
     else
-        *dequeued = NULL;
+        rq->policy->remove(rq, pcb);
+    rq->count--;
+    PCB_sched(pcb)->queued = 0;
+    RG_ready(PCB_acct(pcb)->GROUP, -1);
+    pcb->LINK = NULL;
+    return 1;
 }
 
 void READYQ_kill(READYQ * rq, PCB ** dequeued, int pid)
 {
-    if( rq->head == NULL ){
-        *dequeued = NULL;
-        return;
-    }
-    else{
-        if( rq->head->PID == pid ){
-            *dequeued = rq->head;
-            if( rq->head == rq->tail ){
-                rq->head = rq->tail = NULL;
-            }
-            else{
-                rq->head = rq->head->LINK;
-            }
-            (*dequeued)->LINK = NULL;
-        }
-        else{
-            PCB * curr_ptr = rq->head;
-            while( curr_ptr->LINK ){
-                if( curr_ptr->LINK->PID == pid ){
-                    *dequeued = curr_ptr->LINK;
-                    if( curr_ptr->LINK == rq->tail ){
-                        rq->tail = curr_ptr;
-                        curr_ptr->LINK = (*dequeued)->LINK; 
-                    }
-                    else{
-                       curr_ptr->LINK = (*dequeued)->LINK;
-                    }
-                    (*dequeued)->LINK = NULL;
-                    return;
-                }
-                else
-                    curr_ptr = curr_ptr->LINK;
-            }
-            if( curr_ptr->LINK == NULL )
-                *dequeued = NULL;
-        }
-    }
+    PCB * pcb = PCB_find(pid);
+    *dequeued = pcb && READYQ_remove(rq, pcb) ? pcb : NULL;
+}
+
+/** \return the class pcb runs in: 1 for a real-time process, 0 for a
+ *          normal one and -1 for one that would be held, which
+ *          preempts nothing. */
+static int rank(READYQ * rq, PCB * pcb)
+{
+    if( !READYQ_can_run(rq, pcb) )
+        return -1;
+    return is_rt(rq, pcb);
+}
+
+int READYQ_should_preempt(READYQ * rq, PCB * running, PCB * incoming)
+{
+    int r = rank(rq, running);
+    int i = rank(rq, incoming);
+    if( r != i )
+        return i > r;
+    if( i < 0 )
+        return 0;
+    if( i > 0 )
+        return READYQ_should_preempt(rq->rt, running, incoming);
+    return rq->policy->should_preempt(rq, running, incoming);
 }
 
+int READYQ_tick(READYQ * rq, PCB * running, double elapsed)
+{
+    if( is_rt(rq, running) )
+        return READYQ_tick(rq->rt, running, elapsed);
+    return rq->policy->on_tick(rq, running, elapsed);
+}
+
+double READYQ_slice_left(READYQ * rq, PCB * running)
+{
+    if( is_rt(rq, running) )
+        return READYQ_slice_left(rq->rt, running);
+    return rq->policy->slice_left(rq, running);
+}
+
+void READYQ_walk(READYQ * rq, SCHED_VISIT visit, void * arg)
+{
+    int rt_n = 0;
+    if( rq->rt ){
+        READYQ_walk(rq->rt, visit, arg);
+        rt_n = rq->rt->count;
+    }
+    if( rq->count > rt_n )
+        rq->policy->walk(rq, visit, arg);
+    for(PCB * ptr = rq->held; ptr; ptr = ptr->LINK)
+        visit(ptr, arg);
+}
 
 int READYQ_empty(READYQ * rq)
 {
-    if(rq->head == NULL)
+    if(rq->count == 0)
         return 1;
     else
         return 0;
@@ -126,12 +203,19 @@ int READYQ_empty(READYQ * rq)
 
 void READYQ_free(READYQ * rq)
 {
-    PCB * curr_ptr = rq->head;
-    PCB * prev_ptr = rq->head;
-    while( curr_ptr ){
-        curr_ptr = curr_ptr->LINK;
-        PCB_free(prev_ptr);
-        prev_ptr = curr_ptr;
+    PCB * recycle;
+    READYQ_dequeue(rq, &recycle);
+    while( recycle ){
+        PCB_free(recycle);
+        READYQ_dequeue(rq, &recycle);
+    }
+    while( rq->held ){
+        recycle = rq->held;
+        rq->held = recycle->LINK;
+        PCB_free(recycle);
     }
+    if( rq->rt )
+        READYQ_free(rq->rt);
+    rq->policy->free(rq);
     free(rq);
 }
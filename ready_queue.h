@@ -1,41 +1,106 @@
-/** \file   
- *  ready_queue.h:  Interface for the ready queue,
- *                  which is a preemptive history based scheduling queue 
- *                  for processes waiting to run. */
+/** \file
+ *  ready_queue.h:  Interface for the ready queue, the set of processes
+ *                  waiting to run. The ordering is decided by the
+ *                  scheduling policy chosen at sysgen, see scheduler.h.
+ *
+ *                  With aging, a waiting process' predicted burst counts
+ *                  for less the longer it waits, aging ms for every ms, so
+ *                  a long burst can't be passed over forever by a stream
+ *                  of short ones. Only SJF orders by predicted burst, so
+ *                  only SJF ages; the other policies bound waiting on
+ *                  their own.
+ *
+ *                  With a real-time class, real-time processes have a
+ *                  queue of their own, ordered by EDF, which is always
+ *                  served first; a real-time process preempts any other.
+ *                  One that has used up its budget or completed its job
+ *                  is held off the queue until its next release.
+ *
+ *                  Members of a resource group that has used up its CPU
+ *                  cap are held too, until the group's next period (see
+ *                  rgroup.h). */
 
 #ifndef READY_QUEUE_H_
 #define READY_QUEUE_H_
 
 #include "pcb.h"
+#include "scheduler.h"
 
 /** READYQ struct. */
 typedef struct READYQ{
-    PCB *  head;  // Pointer to head of queue (front of the line).
-    PCB *  tail;  // Pointer to tail of queue (back of the line).
+    const SCHED *   policy;     // Scheduling policy operations.
+    void        *   state;      // Policy private queue state.
+    int             count;      // Number of queued processes.
+    double          quantum;    // Time quantum in ms (RR, MLFQ base,
+                                // FAIR granularity).
+    double          aging;      // ms of burst forgiven per ms waited.
+    const double *  clock;      // Simulation clock.
+    struct READYQ * rt;         // Real-time class queue, NULL if none.
+    PCB         *   held;       // Processes that may not run yet:
+    int             HELD_n;     //   real-time ones waiting for their
+                                //   next release and members of
+                                //   throttled groups. Linked back
+                                //   through PCB_SCHED.prev.
+
+    /** Statistics */
+    double          WAIT_MAX;   // Longest wait in the queue, ms.
 } READYQ;
 
-/** Generate and return a READYQ. */
-READYQ *READYQ_new();
+/** Generate and return a READYQ.
+    \param  policy is one of the SCHED_POLICY_* numbers.
+    \param  quantum is the policy's time quantum in ms.
+    \param  aging is the aging rate, 0 for none.
+    \param  clock points at the simulation clock waits are timed by. */
+READYQ *READYQ_new(int policy, double quantum, double aging,
+                   const double * clock);
+
+/** Give rq a real-time class. */
+void READYQ_rt_class(READYQ * rq);
+
+/** \return 0 if pcb would be held: it is a real-time process whose job
+ *          is done or out of budget, or its group is throttled. */
+int READYQ_can_run(READYQ * rq, PCB * pcb);
 
-/** Enqueueing operation. 
-    \param  rq is a pointer to a READYQ object. 
-    \param  insert is a pointer to a PCB to be inserted. 
-    \post   To implement a preemptive history based scheduling algorithm, the 
-            RQ is implemented as a priority queue with the PCB's TAU_r, 
-            remaining tau burst prediction value serving as a key. 
-            Lower TAU_r values get pushed to the front of the queue. */
+/** Take pcb off the held list.
+ *  \return 1 if it was there. */
+int READYQ_unhold(READYQ * rq, PCB * pcb);
+
+/** Enqueueing operation.
+    \param  rq is a pointer to a READYQ object.
+    \param  insert is a pointer to a PCB to be inserted. */
 void READYQ_enqueue(READYQ * rq, PCB* insert);
 
 /** Dequeueing operation.
     \param  rq is a pointer to a READYQ object to be dequeued.
     \param  dequeued is a PCB* passed by pointer(syntax to pass by reference
-            in the program itself; the pointer to the dequeued PCB
-            goes in here; PCB is NOT deallocated. */
+            in the program itself; the pointer to the next PCB picked by
+            the policy goes in here; PCB is NOT deallocated. */
 void READYQ_dequeue(READYQ * rq, PCB** dequeued);
 
-/** Dequeue process with PID pid and place it into dequeued. */
+/** Take pcb off rq, or off its held list, wherever it is queued. The
+ *  policy removes it directly, without looking for it.
+ *  \return 1 if it was there. */
+int READYQ_remove(READYQ * rq, PCB * pcb);
+
+/** Dequeue process with PID pid and place it into dequeued, NULL if it
+ *  isn't on rq. It is looked up in the process table, see PCB_find(). */
 void READYQ_kill(READYQ * rq, PCB ** dequeued, int pid);
 
+/** Ask the policy whether an arriving process preempts the running one.
+    \return 1 if incoming should be given the CPU. */
+int READYQ_should_preempt(READYQ * rq, PCB * running, PCB * incoming);
+
+/** Charge elapsed CPU time to the running process' policy bookkeeping.
+    \return 1 if the running process' time slice has expired. */
+int READYQ_tick(READYQ * rq, PCB * running, double elapsed);
+
+/** \return ms left of the running process' time slice, 0 if the policy
+    does not slice time. */
+double READYQ_slice_left(READYQ * rq, PCB * running);
+
+/** Visit each queued process: real-time ones first, held ones last. */
+void READYQ_walk(READYQ * rq, SCHED_VISIT visit, void * arg);
+
 /** READYY_empty()
     \param  rq is a pointer to a READYQ object which was dynamically
             allocated via a vall to READYQ_new().
@@ -0,0 +1,123 @@
+/** \file
+ *  realtime.c:     Implementation for the real-time class. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "realtime.h"
+#include "sysgen.h"
+#include "dispatcher.h"
+#include "interrupts.h"
+
+RTCLASS *RT_new(double cap)
+{
+    RTCLASS * rt = calloc( 1, sizeof(RTCLASS) );
+    rt->cap = cap;
+    return rt;
+}
+
+int RT_admit(SYSGEN * sys, double budget, double deadline)
+{
+    RTCLASS * cls = sys->RT;
+    double util = cls->UTIL + budget / deadline;
+    if( util > cls->cap + 1e-9 ){
+        cls->REJECT_n++;
+        printf("Real-time process not admitted: density %.3lf would be over"
+               " the cap of %.3lf.\n", util, cls->cap);
+        return 0;
+    }
+    return 1;
+}
+
+/** Count the current job of pcb as decided, missed if late. */
+static void job_over(RTCLASS * cls, PCB * pcb, int late)
+{
+    cls->JOB_n++;
+    if( late ){
+        cls->MISS_n++;
+        PCB_acct(pcb)->RT.MISS_n++;
+    }
+}
+
+/** Release timer: the current job is given up if it isn't done, and the
+ *  next one starts with a full budget. Where the process is decides what
+ *  happens to it: on the CPU or on the ready queue its deadline has moved,
+ *  so EDF gets to look again; held, it is ready again. Anywhere else it
+ *  will be by the time it is ready. */
+static void release(TIMER * timer)
+{
+    PCB * pcb = timer->arg;
+    PCB_RT * rt = &PCB_acct(pcb)->RT;
+    SYSGEN * sys = rt->sys;
+
+    if( !rt->DONE ){
+        job_over(sys->RT, pcb, 1);
+        printf("Real-time PID %d missed its deadline at %.3lfms.\n",
+               pcb->PID, rt->DUE);
+    }
+    rt->RELEASED = sys->clock;
+    rt->DUE = sys->clock + rt->DEADLINE;
+    rt->LEFT = rt->BUDGET;
+    rt->DONE = 0;
+    rt->JOB_n++;
+    TWHEEL_arm(sys->TIMERS, timer, ms_to_ticks(rt->RELEASED + rt->PERIOD));
+
+    READYQ * rq = sys->READY_QUEUE;
+    if( sys->CPU->RUNNING_PROCESS == pcb ){
+        READYQ_enqueue(rq, pcb);
+        dispatch_next(sys);
+    }
+    else if( READYQ_remove(rq, pcb) )
+        wake_process(sys, pcb);
+}
+
+void RT_start(SYSGEN * sys, PCB * pcb, double period, double budget,
+              double deadline)
+{
+    PCB_RT * rt = &PCB_acct(pcb)->RT;
+    *rt = (PCB_RT){ .PERIOD = period,
+                    .BUDGET = budget,
+                    .DEADLINE = deadline,
+                    .RELEASED = sys->clock,
+                    .DUE = sys->clock + deadline,
+                    .LEFT = budget,
+                    .DONE = 0,
+                    .JOB_n = 1,
+                    .MISS_n = 0,
+                    .sys = sys};
+    TIMER_init(&rt->RELEASE, release, pcb);
+    TWHEEL_arm(sys->TIMERS, &rt->RELEASE, ms_to_ticks(sys->clock + period));
+    sys->RT->UTIL += budget / deadline;
+    sys->RT->TASK_n++;
+    sys->RT->ADMIT_n++;
+}
+
+void RT_job_done(SYSGEN * sys, PCB * pcb)
+{
+    PCB_RT * rt = &PCB_acct(pcb)->RT;
+    if( rt->PERIOD == 0 || rt->DONE )
+        return;
+    rt->DONE = 1;
+    double late = sys->clock - rt->DUE;
+    WELFORD_add(&sys->RT->RESPONSE, sys->clock - rt->RELEASED);
+    if( late > sys->RT->LATE_MAX )
+        sys->RT->LATE_MAX = late;
+    job_over(sys->RT, pcb, late > 0);
+}
+
+void RT_overrun(SYSGEN * sys, PCB * pcb)
+{
+    sys->RT->OVERRUN_n++;
+    printf("Timer interrupt: real-time PID %d used up its budget.\n",
+           pcb->PID);
+}
+
+void RT_exit(SYSGEN * sys, PCB * pcb)
+{
+    PCB_RT * rt = &PCB_acct(pcb)->RT;
+    if( rt->PERIOD == 0 )
+        return;
+    TWHEEL_cancel(sys->TIMERS, &rt->RELEASE);
+    sys->RT->UTIL -= rt->BUDGET / rt->DEADLINE;
+    sys->RT->TASK_n--;
+    rt->PERIOD = 0;
+}
@@ -0,0 +1,78 @@
+/** \file
+ *  realtime.h:     Interface for the real-time class (RTCLASS).
+ *
+ *                  A real-time process is periodic: every PERIOD ms a job
+ *                  is released, which may take up to BUDGET ms of CPU time
+ *                  and is due DEADLINE ms after its release. A job is done
+ *                  when the process ends its CPU burst, by blocking on I/O
+ *                  or terminating. Real-time processes are scheduled EDF,
+ *                  above the normal class (see ready_queue.h).
+ *
+ *                  A job that uses up its budget is throttled: the process
+ *                  is held off the CPU until its next release, so one that
+ *                  overruns can't take time the others were promised. So
+ *                  is a process that becomes ready with its job already
+ *                  done; it waits for the next one.
+ *
+ *                  Admission control keeps the density of the class, the
+ *                  sum of BUDGET / DEADLINE over its processes, within a
+ *                  cap of at most the one CPU. Under EDF that is enough
+ *                  for every job that keeps to its budget to meet its
+ *                  deadline, and a cap below 1 leaves the rest of the CPU
+ *                  to the normal class.
+ *
+ *                  A job completed after its deadline has missed it, and
+ *                  so has one that is still not done at its next release.
+ *                  A forked child is a process of the normal class. */
+
+#ifndef REALTIME_H_
+#define REALTIME_H_
+
+#include "pcb.h"
+#include "stats.h"
+
+struct SYSGEN;
+
+/** Real-time class. */
+typedef struct RTCLASS {
+    double              cap;            // Density the class may admit.
+    double              UTIL;           // Density admitted.
+    int                 TASK_n;         // Real-time processes.
+
+    /** Statistics */
+    long                ADMIT_n;        // Processes admitted,
+    long                REJECT_n;       //   and turned away.
+    long                JOB_n;          // Jobs completed or given up,
+    long                MISS_n;         //   and those past their deadline.
+    long                OVERRUN_n;      // Jobs that used up their budget.
+    WELFORD             RESPONSE;       // Release to completion, ms.
+    double              LATE_MAX;       // Latest completion past a
+                                        //   deadline, ms.
+} RTCLASS;
+
+/** \return a real-time class admitting a density of up to cap. */
+RTCLASS *RT_new(double cap);
+
+/** Admission control for a process of the given budget and relative
+ *  deadline. Its density is budget / deadline; the period doesn't enter
+ *  into it, since the deadline is at most the period.
+ *  \return 1 if it fits, 0 if it doesn't, saying why. Nothing is taken
+ *          until RT_start(). */
+int RT_admit(struct SYSGEN * sys, double budget, double deadline);
+
+/** Make pcb a real-time process, admitted beforehand, and release its
+ *  first job now. */
+void RT_start(struct SYSGEN * sys, PCB * pcb, double period, double budget,
+              double deadline);
+
+/** pcb's CPU burst ended, which completes its job if it is real-time. */
+void RT_job_done(struct SYSGEN * sys, PCB * pcb);
+
+/** The running real-time process pcb used up its budget. */
+void RT_overrun(struct SYSGEN * sys, PCB * pcb);
+
+/** pcb is leaving the system. If it is real-time, its releases stop and
+ *  its density goes back to the class. */
+void RT_exit(struct SYSGEN * sys, PCB * pcb);
+
+#endif
@@ -0,0 +1,136 @@
+/** \file
+ *  rgroup.c:   Implementation for resource groups. */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "rgroup.h"
+#include "sysgen.h"
+#include "dispatcher.h"
+#include "interrupts.h"
+
+RGSET *RG_new(SYSGEN * sys, int count)
+{
+    RGSET * gs = calloc( 1, sizeof(RGSET) );
+    gs->sys = sys;
+    gs->count = count;
+    gs->g = calloc( count, sizeof(RGROUP) );
+    for(int i = 0; i < count; i++){
+        gs->g[i].NUM = i+1;
+        gs->g[i].weight = 1;
+    }
+    return gs;
+}
+
+/** Period timer: every group gets its time back, and the members held
+ *  while their group was throttled are ready again. */
+static void refill(TIMER * timer)
+{
+    RGSET * gs = timer->arg;
+    SYSGEN * sys = gs->sys;
+    int woke = 0;
+    for(int i = 0; i < gs->count; i++){
+        RGROUP * g = &gs->g[i];
+        g->USED = 0;
+        if( g->THROTTLED ){
+            g->THROTTLED = 0;
+            woke = 1;
+            printf("Timer interrupt: group %d's CPU cap refilled.\n",
+                   g->NUM);
+        }
+    }
+    TWHEEL_arm(sys->TIMERS, timer, ms_to_ticks(sys->clock + gs->period));
+    if( !woke )
+        return;
+
+    READYQ * rq = sys->READY_QUEUE;
+    PCB * next;
+    for(PCB * p = rq->held; p; p = next){
+        next = p->LINK;
+        if( READYQ_can_run(rq, p) ){
+            READYQ_unhold(rq, p);
+            wake_process(sys, p);
+        }
+    }
+}
+
+void RG_start(RGSET * gs, double period)
+{
+    gs->period = period;
+    for(int i = 0; i < gs->count; i++)
+        gs->g[i].LIMIT = gs->g[i].cap * period;
+    TIMER_init(&gs->REFILL, refill, gs);
+    TWHEEL_arm(gs->sys->TIMERS, &gs->REFILL,
+               ms_to_ticks(gs->sys->clock + period));
+}
+
+void RG_join(RGROUP * g, PCB * pcb)
+{
+    PCB_acct(pcb)->GROUP = g;
+    if( g )
+        g->PROC_n++;
+}
+
+void RG_exit(PCB * pcb)
+{
+    RGROUP * g = PCB_acct(pcb)->GROUP;
+    if( g == NULL )
+        return;
+    g->PROC_n--;
+    g->DONE_n++;
+}
+
+void RG_frames(RGROUP * g, int n)
+{
+    if( g == NULL )
+        return;
+    g->FRAMES += n;
+    if( g->FRAMES > g->FRAMES_MAX )
+        g->FRAMES_MAX = g->FRAMES;
+}
+
+int RG_frame_room(RGROUP * g)
+{
+    if( g == NULL || g->quota == 0 )
+        return INT_MAX;
+    return g->FRAMES < g->quota ? g->quota - g->FRAMES : 0;
+}
+
+void RG_ready(RGROUP * g, int n)
+{
+    if( g )
+        g->READY_n += n;
+}
+
+int RG_charge_cpu(RGROUP * g, double ms)
+{
+    if( g == NULL )
+        return 0;
+    g->CPU_t += ms;
+    g->USED += ms;
+    if( g->LIMIT > 0 && !g->THROTTLED && g->LIMIT - g->USED < RG_MIN_LEFT ){
+        g->THROTTLED = 1;
+        g->THROTTLE_n++;
+    }
+    return g->THROTTLED;
+}
+
+double RG_cpu_left(RGROUP * g)
+{
+    if( g == NULL || g->LIMIT == 0 )
+        return -1;
+    return g->LIMIT > g->USED ? g->LIMIT - g->USED : 0;
+}
+
+double RG_vscale(RGROUP * g)
+{
+    if( g == NULL )
+        return 1;
+    return (g->READY_n + 1) / g->weight;
+}
+
+void RG_free(RGSET * gs)
+{
+    free(gs->g);
+    free(gs);
+}
@@ -0,0 +1,112 @@
+/** \file
+ *  rgroup.h:   Interface for resource groups (RGROUP).
+ *
+ *              Every process belongs to a group, chosen when it is
+ *              created; a forked child joins its parent's. A group bounds
+ *              what its processes take together, CPU time and frames.
+ *
+ *              CPU weight: under the fair policy a group's weight is split
+ *              among its members on the ready queue or the CPU, and each
+ *              member's vruntime grows by its elapsed time over its share.
+ *              Groups that are all busy get the CPU in proportion to their
+ *              weights, however many processes each has. The other
+ *              policies don't order by share and ignore weights.
+ *
+ *              CPU cap: a capped group may use cap of the CPU in every
+ *              period, under any policy. Once its members have used
+ *              cap * period ms between them the group is throttled: the
+ *              one on the CPU is taken off it and all of them are held off
+ *              the ready queue until the next period starts, when the
+ *              group's time is refilled. Unused time is not carried over.
+ *
+ *              Frame quota: a frame is charged to the group of its first
+ *              mapping, and moves to the next mapping's group when that
+ *              one goes, so shared and copy-on-write frames are counted
+ *              once. A process isn't loaded while its group has no room
+ *              for it and waits in the job pool; a page fault or
+ *              copy-on-write fault in a group at its quota replaces one of
+ *              the process' own pages or fails. */
+
+#ifndef RGROUP_H_
+#define RGROUP_H_
+
+#include "pcb.h"
+#include "timer_wheel.h"
+
+struct SYSGEN;
+
+/** CPU time below which a capped group counts as out of time, well under
+ *  a clock tick. */
+#define RG_MIN_LEFT     1e-6
+
+/** Resource group. */
+typedef struct RGROUP {
+    int                 NUM;            // Counting from 1.
+    double              weight;         // CPU share weight.
+    double              cap;            // Share of the CPU per period, 0
+                                        //   for no cap.
+    int                 quota;          // Frames, 0 for no quota.
+    double              LIMIT;          // CPU time per period, cap * period.
+    double              USED;           // CPU time used this period.
+    int                 THROTTLED;      // 1 once USED reaches LIMIT.
+    int                 PROC_n;         // Members,
+    int                 READY_n;        //   and those on the ready queue.
+    int                 FRAMES;         // Frames charged to the group.
+
+    /** Statistics */
+    double              CPU_t;          // CPU time of all members.
+    long                DONE_n;         // Members terminated or killed.
+    int                 FRAMES_MAX;     // Most frames charged at once.
+    long                THROTTLE_n;     // Periods the group was throttled.
+    long                QUOTA_n;        // Loads and faults turned down by
+                                        //   the quota.
+} RGROUP;
+
+/** The resource groups of the system. */
+typedef struct RGSET {
+    struct SYSGEN   *   sys;
+    int                 count;
+    RGROUP          *   g;              // Group n is g[n-1].
+    double              period;         // Cap period in ms, 0 if no group
+                                        //   is capped.
+    TIMER               REFILL;         // Next period.
+} RGSET;
+
+/** \return count groups of weight 1, with no cap and no quota. */
+RGSET *RG_new(struct SYSGEN * sys, int count);
+
+/** Start the cap periods, period ms each, once the caps are set. */
+void RG_start(RGSET * gs, double period);
+
+/** Make pcb a member of g, NULL for none. */
+void RG_join(RGROUP * g, PCB * pcb);
+
+/** pcb is leaving the system. Its frames stay charged until they are
+ *  unmapped. */
+void RG_exit(PCB * pcb);
+
+/** Charge n frames to g, or take them back if n is negative. */
+void RG_frames(RGROUP * g, int n);
+
+/** \return the frames g may still take, INT_MAX with no quota or no
+ *          group. */
+int RG_frame_room(RGROUP * g);
+
+/** A member of g joined (n = 1) or left (n = -1) the ready queue. */
+void RG_ready(RGROUP * g, int n);
+
+/** Charge ms of CPU time to g.
+ *  \return 1 if g is throttled. */
+int RG_charge_cpu(RGROUP * g, double ms);
+
+/** \return the CPU time g has left this period, -1 if it isn't capped. */
+double RG_cpu_left(RGROUP * g);
+
+/** \return how much faster than real time the vruntime of a running
+ *          member of g grows: its members in play over its weight, 1 with
+ *          no group. */
+double RG_vscale(RGROUP * g);
+
+void RG_free(RGSET * gs);
+
+#endif
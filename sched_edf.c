@@ -0,0 +1,184 @@
+/** \file
+ *  sched_edf.c:    Earliest deadline first, the policy of the real-time
+ *                  class (see realtime.h). It is never picked at sysgen;
+ *                  the ready queue keeps a queue of its own with it when
+ *                  there is a real-time class.
+ *
+ *                  The queue is a binary min-heap keyed on the absolute
+ *                  deadline of each process' current job, laid out like
+ *                  the SJF heap: entries carry a copy of the key and an
+ *                  enqueue sequence number, and PCB_SCHED.heap_idx holds
+ *                  each process' position. A real-time process is never
+ *                  on the SJF heap, so the two don't clash over it.
+ *
+ *                  The time slice is what is left of the job's budget. */
+
+#include <stdlib.h>
+#include "ready_queue.h"
+
+#define EDF_INIT_CAP 16
+
+typedef struct EDF_ENTRY {
+    double  key;
+    long    seq;
+    PCB *   pcb;
+} EDF_ENTRY;
+
+typedef struct EDF_STATE {
+    EDF_ENTRY * heap;
+    int         size;
+    int         cap;
+    long        next_seq;
+} EDF_STATE;
+
+static int entry_less(EDF_ENTRY * a, EDF_ENTRY * b)
+{
+    return  (a->key < b->key)
+        ||  (a->key == b->key && a->seq < b->seq);
+}
+
+static void heap_set(EDF_STATE * s, int i, EDF_ENTRY e)
+{
+    s->heap[i] = e;
+    PCB_sched(e.pcb)->heap_idx = i;
+}
+
+static void sift_up(EDF_STATE * s, int i)
+{
+    EDF_ENTRY e = s->heap[i];
+    while( i > 0 ){
+        int parent = (i - 1) / 2;
+        if( !entry_less(&e, &s->heap[parent]) )
+            break;
+        heap_set(s, i, s->heap[parent]);
+        i = parent;
+    }
+    heap_set(s, i, e);
+}
+
+static void sift_down(EDF_STATE * s, int i)
+{
+    EDF_ENTRY e = s->heap[i];
+    for(;;){
+        int child = 2*i + 1;
+        if( child >= s->size )
+            break;
+        if( child + 1 < s->size && entry_less(&s->heap[child+1],
+                                              &s->heap[child]) )
+            child++;
+        if( !entry_less(&s->heap[child], &e) )
+            break;
+        heap_set(s, i, s->heap[child]);
+        i = child;
+    }
+    heap_set(s, i, e);
+}
+
+static void edf_init(READYQ * rq)
+{
+    EDF_STATE * s = malloc( sizeof(EDF_STATE) );
+    *s = (EDF_STATE){   .heap = malloc( sizeof(EDF_ENTRY) * EDF_INIT_CAP ),
+                        .size = 0,
+                        .cap = EDF_INIT_CAP,
+                        .next_seq = 0};
+    rq->state = s;
+}
+
+static void edf_enqueue(READYQ * rq, PCB * insert)
+{
+    EDF_STATE * s = rq->state;
+    if( s->size == s->cap ){
+        s->cap *= 2;
+        s->heap = realloc(s->heap, sizeof(EDF_ENTRY) * s->cap);
+    }
+    PCB_sched(insert)->seq = s->next_seq++;
+    s->heap[s->size] = (EDF_ENTRY){ .key = PCB_acct(insert)->RT.DUE,
+                                    .seq = PCB_sched(insert)->seq,
+                                    .pcb = insert};
+    s->size++;
+    sift_up(s, s->size - 1);
+}
+
+static void edf_remove(READYQ * rq, PCB * pcb)
+{
+    EDF_STATE * s = rq->state;
+    int i = PCB_sched(pcb)->heap_idx;
+    s->size--;
+    if( i != s->size ){
+        EDF_ENTRY moved = s->heap[s->size];
+        heap_set(s, i, moved);
+        sift_up(s, i);
+        sift_down(s, PCB_sched(moved.pcb)->heap_idx);
+    }
+    PCB_sched(pcb)->heap_idx = -1;
+}
+
+static PCB *edf_pick_next(READYQ * rq)
+{
+    EDF_STATE * s = rq->state;
+    if( s->size == 0 )
+        return NULL;
+    PCB * next = s->heap[0].pcb;
+    edf_remove(rq, next);
+    return next;
+}
+
+/** An arriving job preempts one that is due later. */
+static int edf_should_preempt(READYQ * rq, PCB * running, PCB * incoming)
+{
+    return PCB_acct(incoming)->RT.DUE < PCB_acct(running)->RT.DUE;
+}
+
+/** The slice is over once the job's budget is. */
+static int edf_on_tick(READYQ * rq, PCB * running, double elapsed)
+{
+    PCB_RT * rt = &PCB_acct(running)->RT;
+    rt->LEFT -= elapsed;
+    return rt->LEFT < RT_MIN_LEFT;
+}
+
+static double edf_slice_left(READYQ * rq, PCB * running)
+{
+    return PCB_acct(running)->RT.LEFT;
+}
+
+static int entry_cmp(const void * a, const void * b)
+{
+    EDF_ENTRY * x = (EDF_ENTRY *)a;
+    EDF_ENTRY * y = (EDF_ENTRY *)b;
+    if( entry_less(x, y) ) return -1;
+    if( entry_less(y, x) ) return 1;
+    return 0;
+}
+
+static void edf_walk(READYQ * rq, SCHED_VISIT visit, void * arg)
+{
+    EDF_STATE * s = rq->state;
+    EDF_ENTRY * sorted = malloc( sizeof(EDF_ENTRY) * s->size );
+    for(int i = 0; i < s->size; i++)
+        sorted[i] = s->heap[i];
+    qsort(sorted, s->size, sizeof(EDF_ENTRY), entry_cmp);
+    for(int i = 0; i < s->size; i++)
+        visit(sorted[i].pcb, arg);
+    free(sorted);
+}
+
+static void edf_free(READYQ * rq)
+{
+    EDF_STATE * s = rq->state;
+    free(s->heap);
+    free(s);
+}
+
+const SCHED SCHED_EDF = {
+    .name           = "EDF",
+    .init           = edf_init,
+    .enqueue        = edf_enqueue,
+    .pick_next      = edf_pick_next,
+    .remove         = edf_remove,
+    .should_preempt = edf_should_preempt,
+    .on_tick        = edf_on_tick,
+    .slice_left     = edf_slice_left,
+    .walk           = edf_walk,
+    .free           = edf_free,
+};
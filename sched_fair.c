@@ -0,0 +1,398 @@
+/** \file
+ *  sched_fair.c:   Virtual runtime fair scheduling.
+ *
+ *                  Every process accumulates vruntime while it holds the
+ *                  CPU, and the process with the smallest vruntime runs
+ *                  next. Queued processes are kept in a red-black tree
+ *                  ordered by (vruntime, seq), with the leftmost node cached
+ *                  so picking is O(1) and insert/remove are O(log n). The
+ *                  tree links live in the PCB_SCHED record.
+ *
+ *                  The ready queue quantum is used as the scheduling
+ *                  granularity: a running process is only preempted once it
+ *                  is more than one granularity ahead of the leftmost
+ *                  process, which bounds how often the CPU changes hands.
+ *                  A process coming back from I/O is placed no further than
+ *                  half a granularity behind min_vruntime so that long
+ *                  sleepers can't monopolise the CPU when they wake up.
+ *
+ *                  With resource groups, vruntime grows faster the smaller
+ *                  the process' share of its group's weight (see
+ *                  rgroup.h), so busy groups split the CPU by weight. */
+
+#include <stdlib.h>
+#include "ready_queue.h"
+#include "rgroup.h"
+
+#define RB(p) PCB_sched(p)
+
+typedef struct FAIR_STATE {
+    PCB *   root;
+    PCB *   leftmost;
+    double  min_vruntime;   // Monotonic floor of the vruntimes in play.
+    long    next_seq;
+} FAIR_STATE;
+
+static int is_red(PCB * p)
+{
+    return p != NULL && RB(p)->rb_red;
+}
+
+static int node_less(PCB * a, PCB * b)
+{
+    return  (RB(a)->vruntime < RB(b)->vruntime)
+        ||  (RB(a)->vruntime == RB(b)->vruntime && RB(a)->seq < RB(b)->seq);
+}
+
+static void rotate_left(FAIR_STATE * s, PCB * x)
+{
+    PCB * y = RB(x)->rb_right;
+    RB(x)->rb_right = RB(y)->rb_left;
+    if( RB(y)->rb_left )
+        RB(RB(y)->rb_left)->rb_parent = x;
+    RB(y)->rb_parent = RB(x)->rb_parent;
+    if( RB(x)->rb_parent == NULL )
+        s->root = y;
+    else if( x == RB(RB(x)->rb_parent)->rb_left )
+        RB(RB(x)->rb_parent)->rb_left = y;
+    else
+        RB(RB(x)->rb_parent)->rb_right = y;
+    RB(y)->rb_left = x;
+    RB(x)->rb_parent = y;
+}
+
+static void rotate_right(FAIR_STATE * s, PCB * x)
+{
+    PCB * y = RB(x)->rb_left;
+    RB(x)->rb_left = RB(y)->rb_right;
+    if( RB(y)->rb_right )
+        RB(RB(y)->rb_right)->rb_parent = x;
+    RB(y)->rb_parent = RB(x)->rb_parent;
+    if( RB(x)->rb_parent == NULL )
+        s->root = y;
+    else if( x == RB(RB(x)->rb_parent)->rb_right )
+        RB(RB(x)->rb_parent)->rb_right = y;
+    else
+        RB(RB(x)->rb_parent)->rb_left = y;
+    RB(y)->rb_right = x;
+    RB(x)->rb_parent = y;
+}
+
+static void insert_fixup(FAIR_STATE * s, PCB * z)
+{
+    PCB * p;
+    while( (p = RB(z)->rb_parent) && is_red(p) ){
+        PCB * g = RB(p)->rb_parent;
+        if( p == RB(g)->rb_left ){
+            PCB * u = RB(g)->rb_right;
+            if( is_red(u) ){
+                RB(p)->rb_red = 0;
+                RB(u)->rb_red = 0;
+                RB(g)->rb_red = 1;
+                z = g;
+            }
+            else{
+                if( z == RB(p)->rb_right ){
+                    z = p;
+                    rotate_left(s, z);
+                    p = RB(z)->rb_parent;
+                }
+                RB(p)->rb_red = 0;
+                RB(g)->rb_red = 1;
+                rotate_right(s, g);
+            }
+        }
+        else{
+            PCB * u = RB(g)->rb_left;
+            if( is_red(u) ){
+                RB(p)->rb_red = 0;
+                RB(u)->rb_red = 0;
+                RB(g)->rb_red = 1;
+                z = g;
+            }
+            else{
+                if( z == RB(p)->rb_left ){
+                    z = p;
+                    rotate_right(s, z);
+                    p = RB(z)->rb_parent;
+                }
+                RB(p)->rb_red = 0;
+                RB(g)->rb_red = 1;
+                rotate_left(s, g);
+            }
+        }
+    }
+    RB(s->root)->rb_red = 0;
+}
+
+static void rb_insert(FAIR_STATE * s, PCB * z)
+{
+    PCB * y = NULL;
+    PCB * x = s->root;
+    while( x ){
+        y = x;
+        x = node_less(z, x) ? RB(x)->rb_left : RB(x)->rb_right;
+    }
+    RB(z)->rb_parent = y;
+    RB(z)->rb_left = RB(z)->rb_right = NULL;
+    RB(z)->rb_red = 1;
+    if( y == NULL )
+        s->root = z;
+    else if( node_less(z, y) )
+        RB(y)->rb_left = z;
+    else
+        RB(y)->rb_right = z;
+
+    if( s->leftmost == NULL || node_less(z, s->leftmost) )
+        s->leftmost = z;
+    insert_fixup(s, z);
+}
+
+static PCB *rb_minimum(PCB * x)
+{
+    while( RB(x)->rb_left )
+        x = RB(x)->rb_left;
+    return x;
+}
+
+static PCB *rb_next(PCB * x)
+{
+    if( RB(x)->rb_right )
+        return rb_minimum(RB(x)->rb_right);
+    PCB * p = RB(x)->rb_parent;
+    while( p && x == RB(p)->rb_right ){
+        x = p;
+        p = RB(p)->rb_parent;
+    }
+    return p;
+}
+
+/** Replace the subtree rooted at u with the one rooted at v. */
+static void transplant(FAIR_STATE * s, PCB * u, PCB * v)
+{
+    PCB * up = RB(u)->rb_parent;
+    if( up == NULL )
+        s->root = v;
+    else if( u == RB(up)->rb_left )
+        RB(up)->rb_left = v;
+    else
+        RB(up)->rb_right = v;
+    if( v )
+        RB(v)->rb_parent = up;
+}
+
+/** x may be NULL, so its parent is tracked separately. */
+static void erase_fixup(FAIR_STATE * s, PCB * x, PCB * xp)
+{
+    while( x != s->root && !is_red(x) ){
+        if( x == RB(xp)->rb_left ){
+            PCB * w = RB(xp)->rb_right;
+            if( is_red(w) ){
+                RB(w)->rb_red = 0;
+                RB(xp)->rb_red = 1;
+                rotate_left(s, xp);
+                w = RB(xp)->rb_right;
+            }
+            if( !is_red(RB(w)->rb_left) && !is_red(RB(w)->rb_right) ){
+                RB(w)->rb_red = 1;
+                x = xp;
+                xp = RB(x)->rb_parent;
+            }
+            else{
+                if( !is_red(RB(w)->rb_right) ){
+                    RB(RB(w)->rb_left)->rb_red = 0;
+                    RB(w)->rb_red = 1;
+                    rotate_right(s, w);
+                    w = RB(xp)->rb_right;
+                }
+                RB(w)->rb_red = RB(xp)->rb_red;
+                RB(xp)->rb_red = 0;
+                if( RB(w)->rb_right )
+                    RB(RB(w)->rb_right)->rb_red = 0;
+                rotate_left(s, xp);
+                x = s->root;
+                break;
+            }
+        }
+        else{
+            PCB * w = RB(xp)->rb_left;
+            if( is_red(w) ){
+                RB(w)->rb_red = 0;
+                RB(xp)->rb_red = 1;
+                rotate_right(s, xp);
+                w = RB(xp)->rb_left;
+            }
+            if( !is_red(RB(w)->rb_left) && !is_red(RB(w)->rb_right) ){
+                RB(w)->rb_red = 1;
+                x = xp;
+                xp = RB(x)->rb_parent;
+            }
+            else{
+                if( !is_red(RB(w)->rb_left) ){
+                    RB(RB(w)->rb_right)->rb_red = 0;
+                    RB(w)->rb_red = 1;
+                    rotate_left(s, w);
+                    w = RB(xp)->rb_left;
+                }
+                RB(w)->rb_red = RB(xp)->rb_red;
+                RB(xp)->rb_red = 0;
+                if( RB(w)->rb_left )
+                    RB(RB(w)->rb_left)->rb_red = 0;
+                rotate_right(s, xp);
+                x = s->root;
+                break;
+            }
+        }
+    }
+    if( x )
+        RB(x)->rb_red = 0;
+}
+
+static void rb_erase(FAIR_STATE * s, PCB * z)
+{
+    if( s->leftmost == z )
+        s->leftmost = rb_next(z);
+
+    PCB * x;
+    PCB * xp;
+    int removed_red = RB(z)->rb_red;
+
+    if( RB(z)->rb_left == NULL ){
+        x = RB(z)->rb_right;
+        xp = RB(z)->rb_parent;
+        transplant(s, z, x);
+    }
+    else if( RB(z)->rb_right == NULL ){
+        x = RB(z)->rb_left;
+        xp = RB(z)->rb_parent;
+        transplant(s, z, x);
+    }
+    else{
+        PCB * y = rb_minimum(RB(z)->rb_right);
+        removed_red = RB(y)->rb_red;
+        x = RB(y)->rb_right;
+        if( RB(y)->rb_parent == z )
+            xp = y;
+        else{
+            xp = RB(y)->rb_parent;
+            transplant(s, y, x);
+            RB(y)->rb_right = RB(z)->rb_right;
+            RB(RB(y)->rb_right)->rb_parent = y;
+        }
+        transplant(s, z, y);
+        RB(y)->rb_left = RB(z)->rb_left;
+        RB(RB(y)->rb_left)->rb_parent = y;
+        RB(y)->rb_red = RB(z)->rb_red;
+    }
+    if( !removed_red && xp != NULL )
+        erase_fixup(s, x, xp);
+    else if( x )
+        RB(x)->rb_red = 0;
+
+    RB(z)->rb_parent = RB(z)->rb_left = RB(z)->rb_right = NULL;
+}
+
+static void update_min_vruntime(FAIR_STATE * s, PCB * running)
+{
+    double floor = s->min_vruntime;
+    int have = 0;
+    double candidate = 0;
+    if( running ){
+        candidate = RB(running)->vruntime;
+        have = 1;
+    }
+    if( s->leftmost && (!have || RB(s->leftmost)->vruntime < candidate) ){
+        candidate = RB(s->leftmost)->vruntime;
+        have = 1;
+    }
+    if( have && candidate > floor )
+        s->min_vruntime = candidate;
+}
+
+static void fair_init(READYQ * rq)
+{
+    FAIR_STATE * s = malloc( sizeof(FAIR_STATE) );
+    *s = (FAIR_STATE){  .root = NULL,
+                        .leftmost = NULL,
+                        .min_vruntime = 0,
+                        .next_seq = 0};
+    rq->state = s;
+}
+
+static void fair_enqueue(READYQ * rq, PCB * insert)
+{
+    FAIR_STATE * s = rq->state;
+    PCB_SCHED * sch = RB(insert);
+    double place = s->min_vruntime - rq->quantum / 2;
+    if( sch->vruntime < place )
+        sch->vruntime = place;
+    sch->slice_used = 0;
+    sch->seq = s->next_seq++;
+    rb_insert(s, insert);
+}
+
+static PCB *fair_pick_next(READYQ * rq)
+{
+    FAIR_STATE * s = rq->state;
+    PCB * next = s->leftmost;
+    if( next ){
+        rb_erase(s, next);
+        update_min_vruntime(s, next);
+    }
+    return next;
+}
+
+static void fair_remove(READYQ * rq, PCB * pcb)
+{
+    rb_erase(rq->state, pcb);
+}
+
+static int fair_should_preempt(READYQ * rq, PCB * running, PCB * incoming)
+{
+    return RB(incoming)->vruntime + rq->quantum < RB(running)->vruntime;
+}
+
+static int fair_on_tick(READYQ * rq, PCB * running, double elapsed)
+{
+    FAIR_STATE * s = rq->state;
+    PCB_SCHED * sch = RB(running);
+    sch->vruntime += elapsed * RG_vscale(PCB_acct(running)->GROUP);
+    sch->slice_used += elapsed;
+    update_min_vruntime(s, running);
+    return  sch->slice_used >= rq->quantum
+        &&  s->leftmost != NULL
+        &&  RB(s->leftmost)->vruntime < sch->vruntime;
+}
+
+/** Once the granularity is used up the process keeps running until
+ *  somebody is behind it, so check again every granularity. */
+static double fair_slice_left(READYQ * rq, PCB * running)
+{
+    double left = rq->quantum - RB(running)->slice_used;
+    return left > 0 ? left : rq->quantum;
+}
+
+static void fair_walk(READYQ * rq, SCHED_VISIT visit, void * arg)
+{
+    FAIR_STATE * s = rq->state;
+    for(PCB * ptr = s->leftmost; ptr; ptr = rb_next(ptr))
+        visit(ptr, arg);
+}
+
+static void fair_free(READYQ * rq)
+{
+    free(rq->state);
+}
+
+const SCHED SCHED_FAIR = {
+    .name           = "FAIR",
+    .init           = fair_init,
+    .enqueue        = fair_enqueue,
+    .pick_next      = fair_pick_next,
+    .remove         = fair_remove,
+    .should_preempt = fair_should_preempt,
+    .on_tick        = fair_on_tick,
+    .slice_left     = fair_slice_left,
+    .walk           = fair_walk,
+    .free           = fair_free,
+};
@@ -0,0 +1,165 @@
+/** \file
+ *  sched_mlfq.c:   Multi-level feedback queue scheduling.
+ *
+ *                  MLFQ_LEVELS FIFO queues, level 0 being the highest
+ *                  priority. A process at level l gets a quantum of
+ *                  quantum * 2^l. Using up the whole quantum (counted across
+ *                  preemptions and I/O waits, so a process can't game it by
+ *                  yielding just before expiry) demotes the process one
+ *                  level. Every MLFQ_BOOST_QUANTA base quanta of CPU time all
+ *                  processes are moved back to level 0 so that long running
+ *                  processes at the bottom can't starve. The queues are
+ *                  linked back through PCB_SCHED.prev, so a process is
+ *                  taken out from the middle directly. */
+
+#include <stdlib.h>
+#include "ready_queue.h"
+
+#define MLFQ_LEVELS         3
+#define MLFQ_BOOST_QUANTA   50
+
+typedef struct MLFQ_STATE {
+    PCB *   head[MLFQ_LEVELS];
+    PCB *   tail[MLFQ_LEVELS];
+    double  since_boost;        // CPU time since the last priority boost.
+} MLFQ_STATE;
+
+static double level_quantum(READYQ * rq, int level)
+{
+    return rq->quantum * (1 << level);
+}
+
+static void mlfq_init(READYQ * rq)
+{
+    MLFQ_STATE * s = malloc( sizeof(MLFQ_STATE) );
+    for(int i = 0; i < MLFQ_LEVELS; i++)
+        s->head[i] = s->tail[i] = NULL;
+    s->since_boost = 0;
+    rq->state = s;
+}
+
+static void mlfq_enqueue(READYQ * rq, PCB * insert)
+{
+    MLFQ_STATE * s = rq->state;
+    int l = PCB_sched(insert)->level;
+    PCB_sched(insert)->prev = s->tail[l];
+    if( s->head[l] == NULL )
+        s->head[l] = insert;
+    else
+        s->tail[l]->LINK = insert;
+    s->tail[l] = insert;
+}
+
+static PCB *mlfq_pick_next(READYQ * rq)
+{
+    MLFQ_STATE * s = rq->state;
+    for(int l = 0; l < MLFQ_LEVELS; l++){
+        PCB * next = s->head[l];
+        if( next ){
+            s->head[l] = next->LINK;
+            if( s->head[l] )
+                PCB_sched(s->head[l])->prev = NULL;
+            else
+                s->tail[l] = NULL;
+            return next;
+        }
+    }
+    return NULL;
+}
+
+static void mlfq_remove(READYQ * rq, PCB * pcb)
+{
+    MLFQ_STATE * s = rq->state;
+    int l = PCB_sched(pcb)->level;
+    PCB * prev = PCB_sched(pcb)->prev;
+    if( prev )
+        prev->LINK = pcb->LINK;
+    else
+        s->head[l] = pcb->LINK;
+    if( pcb->LINK )
+        PCB_sched(pcb->LINK)->prev = prev;
+    else
+        s->tail[l] = prev;
+}
+
+static int mlfq_should_preempt(READYQ * rq, PCB * running, PCB * incoming)
+{
+    return PCB_sched(incoming)->level < PCB_sched(running)->level;
+}
+
+/** Move every queued process, and the running one, back to level 0. */
+static void boost(READYQ * rq, PCB * running)
+{
+    MLFQ_STATE * s = rq->state;
+    for(int l = 1; l < MLFQ_LEVELS; l++){
+        for(PCB * ptr = s->head[l]; ptr; ptr = ptr->LINK){
+            PCB_sched(ptr)->level = 0;
+            PCB_sched(ptr)->slice_used = 0;
+        }
+        if( s->head[l] ){
+            PCB_sched(s->head[l])->prev = s->tail[0];
+            if( s->head[0] == NULL )
+                s->head[0] = s->head[l];
+            else
+                s->tail[0]->LINK = s->head[l];
+            s->tail[0] = s->tail[l];
+            s->head[l] = s->tail[l] = NULL;
+        }
+    }
+    PCB_sched(running)->level = 0;
+    PCB_sched(running)->slice_used = 0;
+}
+
+static int mlfq_on_tick(READYQ * rq, PCB * running, double elapsed)
+{
+    MLFQ_STATE * s = rq->state;
+    PCB_SCHED * sch = PCB_sched(running);
+
+    s->since_boost += elapsed;
+    if( s->since_boost >= rq->quantum * MLFQ_BOOST_QUANTA ){
+        s->since_boost = 0;
+        boost(rq, running);
+        return 0;
+    }
+
+    sch->slice_used += elapsed;
+    if( sch->slice_used >= level_quantum(rq, sch->level) ){
+        if( sch->level < MLFQ_LEVELS - 1 )
+            sch->level++;
+        sch->slice_used = 0;
+        return 1;
+    }
+    return 0;
+}
+
+static double mlfq_slice_left(READYQ * rq, PCB * running)
+{
+    PCB_SCHED * sch = PCB_sched(running);
+    return level_quantum(rq, sch->level) - sch->slice_used;
+}
+
+static void mlfq_walk(READYQ * rq, SCHED_VISIT visit, void * arg)
+{
+    MLFQ_STATE * s = rq->state;
+    for(int l = 0; l < MLFQ_LEVELS; l++)
+        for(PCB * ptr = s->head[l]; ptr; ptr = ptr->LINK)
+            visit(ptr, arg);
+}
+
+static void mlfq_free(READYQ * rq)
+{
+    free(rq->state);
+}
+
+const SCHED SCHED_MLFQ = {
+    .name           = "MLFQ",
+    .init           = mlfq_init,
+    .enqueue        = mlfq_enqueue,
+    .pick_next      = mlfq_pick_next,
+    .remove         = mlfq_remove,
+    .should_preempt = mlfq_should_preempt,
+    .on_tick        = mlfq_on_tick,
+    .slice_left     = mlfq_slice_left,
+    .walk           = mlfq_walk,
+    .free           = mlfq_free,
+};
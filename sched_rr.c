@@ -0,0 +1,106 @@
+/** \file
+ *  sched_rr.c:     Round robin scheduling.
+ *
+ *                  Plain FIFO through the PCB LINK field, linked back
+ *                  through PCB_SCHED.prev so that a process can be taken
+ *                  out from the middle directly. Arriving processes
+ *                  never preempt; the running process is preempted once it
+ *                  has used a full quantum of CPU time, and a process that
+ *                  goes back on the queue starts its next quantum fresh. */
+
+#include <stdlib.h>
+#include "ready_queue.h"
+
+typedef struct RR_STATE {
+    PCB *   head;
+    PCB *   tail;
+} RR_STATE;
+
+static void rr_init(READYQ * rq)
+{
+    RR_STATE * s = malloc( sizeof(RR_STATE) );
+    *s = (RR_STATE){ .head = NULL, .tail = NULL };
+    rq->state = s;
+}
+
+static void rr_enqueue(READYQ * rq, PCB * insert)
+{
+    RR_STATE * s = rq->state;
+    PCB_sched(insert)->slice_used = 0;
+    PCB_sched(insert)->prev = s->tail;
+    if( s->head == NULL )
+        s->head = insert;
+    else
+        s->tail->LINK = insert;
+    s->tail = insert;
+}
+
+static PCB *rr_pick_next(READYQ * rq)
+{
+    RR_STATE * s = rq->state;
+    PCB * next = s->head;
+    if( next ){
+        s->head = next->LINK;
+        if( s->head )
+            PCB_sched(s->head)->prev = NULL;
+        else
+            s->tail = NULL;
+    }
+    return next;
+}
+
+static void rr_remove(READYQ * rq, PCB * pcb)
+{
+    RR_STATE * s = rq->state;
+    PCB * prev = PCB_sched(pcb)->prev;
+    if( prev )
+        prev->LINK = pcb->LINK;
+    else
+        s->head = pcb->LINK;
+    if( pcb->LINK )
+        PCB_sched(pcb->LINK)->prev = prev;
+    else
+        s->tail = prev;
+}
+
+static int rr_should_preempt(READYQ * rq, PCB * running, PCB * incoming)
+{
+    return 0;
+}
+
+static int rr_on_tick(READYQ * rq, PCB * running, double elapsed)
+{
+    PCB_SCHED * sch = PCB_sched(running);
+    sch->slice_used += elapsed;
+    return sch->slice_used >= rq->quantum;
+}
+
+static double rr_slice_left(READYQ * rq, PCB * running)
+{
+    return rq->quantum - PCB_sched(running)->slice_used;
+}
+
+static void rr_walk(READYQ * rq, SCHED_VISIT visit, void * arg)
+{
+    RR_STATE * s = rq->state;
+    for(PCB * ptr = s->head; ptr; ptr = ptr->LINK)
+        visit(ptr, arg);
+}
+
+static void rr_free(READYQ * rq)
+{
+    free(rq->state);
+}
+
+const SCHED SCHED_RR = {
+    .name           = "RR",
+    .init           = rr_init,
+    .enqueue        = rr_enqueue,
+    .pick_next      = rr_pick_next,
+    .remove         = rr_remove,
+    .should_preempt = rr_should_preempt,
+    .on_tick        = rr_on_tick,
+    .slice_left     = rr_slice_left,
+    .walk           = rr_walk,
+    .free           = rr_free,
+};
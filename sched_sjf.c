@@ -0,0 +1,200 @@
+/** \file
+ *  sched_sjf.c:    Preemptive history based scheduling (shortest predicted
+ *                  burst first).
+ *
+ *                  The queue is a binary min-heap keyed on TAU_r, the
+ *                  remaining burst prediction. Heap entries carry a copy of
+ *                  the key and an enqueue sequence number, so comparisons
+ *                  only touch the heap array, and processes with equal keys
+ *                  leave in the order they arrived. Each PCB remembers its
+ *                  heap position in PCB_SCHED.heap_idx, which makes removal
+ *                  of an arbitrary process (kill) O(log n).
+ *
+ *                  With aging, a process that has waited w ms ranks as if
+ *                  its prediction were TAU_r - aging * w. That is its key
+ *                  TAU_r + aging * (time it was queued) less the same
+ *                  aging * now for everybody, so the key is fixed at
+ *                  enqueue and the heap never has to be rebuilt. A process
+ *                  that has waited TAU_r / aging ms is ahead of anything
+ *                  that arrives after it. */
+
+#include <stdlib.h>
+#include "ready_queue.h"
+
+#define SJF_INIT_CAP 64
+
+typedef struct SJF_ENTRY {
+    double  key;
+    long    seq;
+    PCB *   pcb;
+} SJF_ENTRY;
+
+typedef struct SJF_STATE {
+    SJF_ENTRY * heap;
+    int         size;
+    int         cap;
+    long        next_seq;
+} SJF_STATE;
+
+static int entry_less(SJF_ENTRY * a, SJF_ENTRY * b)
+{
+    return  (a->key < b->key)
+        ||  (a->key == b->key && a->seq < b->seq);
+}
+
+static void heap_set(SJF_STATE * s, int i, SJF_ENTRY e)
+{
+    s->heap[i] = e;
+    PCB_sched(e.pcb)->heap_idx = i;
+}
+
+static void sift_up(SJF_STATE * s, int i)
+{
+    SJF_ENTRY e = s->heap[i];
+    while( i > 0 ){
+        int parent = (i - 1) / 2;
+        if( !entry_less(&e, &s->heap[parent]) )
+            break;
+        heap_set(s, i, s->heap[parent]);
+        i = parent;
+    }
+    heap_set(s, i, e);
+}
+
+static void sift_down(SJF_STATE * s, int i)
+{
+    SJF_ENTRY e = s->heap[i];
+    for(;;){
+        int child = 2*i + 1;
+        if( child >= s->size )
+            break;
+        if( child + 1 < s->size && entry_less(&s->heap[child+1],
+                                              &s->heap[child]) )
+            child++;
+        if( !entry_less(&s->heap[child], &e) )
+            break;
+        heap_set(s, i, s->heap[child]);
+        i = child;
+    }
+    heap_set(s, i, e);
+}
+
+static void sjf_init(READYQ * rq)
+{
+    SJF_STATE * s = malloc( sizeof(SJF_STATE) );
+    *s = (SJF_STATE){   .heap = malloc( sizeof(SJF_ENTRY) * SJF_INIT_CAP ),
+                        .size = 0,
+                        .cap = SJF_INIT_CAP,
+                        .next_seq = 0};
+    rq->state = s;
+}
+
+static void sjf_enqueue(READYQ * rq, PCB * insert)
+{
+    SJF_STATE * s = rq->state;
+    if( s->size == s->cap ){
+        s->cap *= 2;
+        s->heap = realloc(s->heap, sizeof(SJF_ENTRY) * s->cap);
+    }
+    PCB_sched(insert)->seq = s->next_seq++;
+    s->heap[s->size] = (SJF_ENTRY){ .key = insert->TAU_r
+                                         + rq->aging * *rq->clock,
+                                    .seq = PCB_sched(insert)->seq,
+                                    .pcb = insert};
+    s->size++;
+    sift_up(s, s->size - 1);
+}
+
+static void sjf_remove(READYQ * rq, PCB * pcb)
+{
+    SJF_STATE * s = rq->state;
+    int i = PCB_sched(pcb)->heap_idx;
+    s->size--;
+    if( i != s->size ){
+        /** Fill the hole with the last entry and restore heap order in
+         *  whichever direction it is out of place. */
+        SJF_ENTRY moved = s->heap[s->size];
+        heap_set(s, i, moved);
+        sift_up(s, i);
+        sift_down(s, PCB_sched(moved.pcb)->heap_idx);
+    }
+    PCB_sched(pcb)->heap_idx = -1;
+}
+
+static PCB *sjf_pick_next(READYQ * rq)
+{
+    SJF_STATE * s = rq->state;
+    if( s->size == 0 )
+        return NULL;
+    PCB * next = s->heap[0].pcb;
+    sjf_remove(rq, next);
+    return next;
+}
+
+/** An arriving process preempts when its predicted remaining burst is
+ *  shorter than what the running process has left. With aging it also has
+ *  to be ahead of the queue, or it would jump the processes that have
+ *  aged past it. */
+static int sjf_should_preempt(READYQ * rq, PCB * running, PCB * incoming)
+{
+    SJF_STATE * s = rq->state;
+    if( incoming->TAU_r >= running->TAU_r )
+        return 0;
+    return  rq->aging == 0
+        ||  s->size == 0
+        ||  incoming->TAU_r + rq->aging * *rq->clock < s->heap[0].key;
+}
+
+/** TAU_r is charged by the caller; SJF has no time slice. */
+static int sjf_on_tick(READYQ * rq, PCB * running, double elapsed)
+{
+    return 0;
+}
+
+/** SJF runs a process until it blocks or is preempted by a shorter one. */
+static double sjf_slice_left(READYQ * rq, PCB * running)
+{
+    return 0;
+}
+
+static int entry_cmp(const void * a, const void * b)
+{
+    SJF_ENTRY * x = (SJF_ENTRY *)a;
+    SJF_ENTRY * y = (SJF_ENTRY *)b;
+    if( entry_less(x, y) ) return -1;
+    if( entry_less(y, x) ) return 1;
+    return 0;
+}
+
+/** Heap order is not dispatch order, so walk a sorted copy. */
+static void sjf_walk(READYQ * rq, SCHED_VISIT visit, void * arg)
+{
+    SJF_STATE * s = rq->state;
+    SJF_ENTRY * sorted = malloc( sizeof(SJF_ENTRY) * s->size );
+    for(int i = 0; i < s->size; i++)
+        sorted[i] = s->heap[i];
+    qsort(sorted, s->size, sizeof(SJF_ENTRY), entry_cmp);
+    for(int i = 0; i < s->size; i++)
+        visit(sorted[i].pcb, arg);
+    free(sorted);
+}
+
+static void sjf_free(READYQ * rq)
+{
+    SJF_STATE * s = rq->state;
+    free(s->heap);
+    free(s);
+}
+
+const SCHED SCHED_SJF = {
+    .name           = "SJF",
+    .init           = sjf_init,
+    .enqueue        = sjf_enqueue,
+    .pick_next      = sjf_pick_next,
+    .remove         = sjf_remove,
+    .should_preempt = sjf_should_preempt,
+    .on_tick        = sjf_on_tick,
+    .slice_left     = sjf_slice_left,
+    .walk           = sjf_walk,
+    .free           = sjf_free,
+};
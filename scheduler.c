@@ -0,0 +1,16 @@
+/** \file
+ *  scheduler.c:    Policy lookup for the ready queue. */
+
+#include <stdlib.h>
+#include "scheduler.h"
+
+const SCHED *SCHED_lookup(int policy)
+{
+    switch( policy ){
+        case SCHED_POLICY_RR:   return &SCHED_RR;
+        case SCHED_POLICY_MLFQ: return &SCHED_MLFQ;
+        case SCHED_POLICY_FAIR: return &SCHED_FAIR;
+        case SCHED_POLICY_EDF:  return &SCHED_EDF;
+        default:                return &SCHED_SJF;
+    }
+}
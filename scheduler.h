@@ -0,0 +1,93 @@
+/** \file
+ *  scheduler.h:    Interface for CPU scheduling policies.
+ *
+ *                  A SCHED is a table of operations that the READYQ
+ *                  dispatches to; one is picked at sysgen time and the rest
+ *                  of the system only talks to the ready queue API. Each
+ *                  policy keeps its private queue state behind
+ *                  READYQ.state and its per-process bookkeeping in the
+ *                  PCB_SCHED record of the process table.
+ *
+ *                  Policies shipped:
+ *                  SJF     Preemptive shortest predicted burst first, keyed
+ *                          on TAU_r, kept in a binary heap.
+ *                  RR      Round robin FIFO with a time quantum.
+ *                  MLFQ    Multi-level feedback queue. The quantum doubles
+ *                          with each level; a process that uses up its
+ *                          quantum is demoted and a periodic boost moves
+ *                          everybody back to the top level.
+ *                  FAIR    Virtual runtime fair scheduling: the process
+ *                          with the least CPU time received runs next,
+ *                          kept in a red-black tree ordered by vruntime.
+ *
+ *                  EDF, earliest deadline first, is the policy of the
+ *                  real-time class, which runs above whichever of these
+ *                  was picked; see realtime.h. */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include "pcb.h"
+
+struct READYQ;
+
+/** Policy numbers, as entered at sysgen. */
+#define SCHED_POLICY_SJF    0
+#define SCHED_POLICY_RR     1
+#define SCHED_POLICY_MLFQ   2
+#define SCHED_POLICY_FAIR   3
+#define SCHED_POLICY_COUNT  4
+
+/** Policy of the real-time class, not one to pick at sysgen. */
+#define SCHED_POLICY_EDF    SCHED_POLICY_COUNT
+
+/** Callback for walking the processes of a ready queue. */
+typedef void (*SCHED_VISIT)(PCB * pcb, void * arg);
+
+/** Scheduling policy operations. */
+typedef struct SCHED {
+    const char *    name;
+
+    /** Allocate policy state into rq->state. */
+    void    (*init)(struct READYQ * rq);
+
+    /** Queue up a process that is ready to run. */
+    void    (*enqueue)(struct READYQ * rq, PCB * insert);
+
+    /** Remove and return the next process to run, NULL if empty. */
+    PCB *   (*pick_next)(struct READYQ * rq);
+
+    /** Remove a specific queued process. */
+    void    (*remove)(struct READYQ * rq, PCB * pcb);
+
+    /** \return 1 if incoming should take the CPU away from running. */
+    int     (*should_preempt)(struct READYQ * rq, PCB * running,
+                              PCB * incoming);
+
+    /** Charge elapsed ms of CPU time to the running process.
+     *  \return 1 if running has used up its time slice and should be
+     *          preempted in favour of the queue. */
+    int     (*on_tick)(struct READYQ * rq, PCB * running, double elapsed);
+
+    /** \return ms left in the running process' time slice, or 0 if the
+     *  policy does not slice time. Used to arm the slice timer. */
+    double  (*slice_left)(struct READYQ * rq, PCB * running);
+
+    /** Visit every queued process, in dispatch order where the policy can
+     *  produce it cheaply. */
+    void    (*walk)(struct READYQ * rq, SCHED_VISIT visit, void * arg);
+
+    /** Release policy state. Queued PCB's are not touched. */
+    void    (*free)(struct READYQ * rq);
+} SCHED;
+
+extern const SCHED SCHED_SJF;
+extern const SCHED SCHED_RR;
+extern const SCHED SCHED_MLFQ;
+extern const SCHED SCHED_FAIR;
+extern const SCHED SCHED_EDF;
+
+/** \return the policy table for a sysgen policy number. */
+const SCHED *SCHED_lookup(int policy);
+
+#endif
@@ -0,0 +1,147 @@
+/** \file
+ *  series.c:   Implementation for queue time series. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "series.h"
+#include "sysgen.h"
+#include "dispatcher.h"
+
+/** \return a copy of the name of device num of class kind. */
+static char *device_name(char kind, int num)
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%c%d", kind, num);
+    return strdup(buf);
+}
+
+/** \return a copy of column name what of group num. */
+static char *group_name(int num, char * what)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "g%d_%s", num, what);
+    return strdup(buf);
+}
+
+/** Take a sample of every column and arm the timer for the next one. */
+static void sample(TIMER * timer)
+{
+    TSERIES * ts = timer->arg;
+    SYSGEN * sys = ts->sys;
+    int at = ts->count % ts->cap;
+    int * col = ts->data + at;
+    int c = 0;
+
+    ts->time[at] = sys->clock;
+    col[ts->cap * c++] = sys->READY_QUEUE->count;
+    for(int i = 0; i < sys->PRINTER_COUNT; i++)
+        col[ts->cap * c++] = sys->PRINTERS[i]->count;
+    for(int i = 0; i < sys->DISK_COUNT; i++)
+        col[ts->cap * c++] = sys->DISKS[i]->count;
+    for(int i = 0; i < sys->FLASHDRIVE_COUNT; i++)
+        col[ts->cap * c++] = sys->FLASHDRIVES[i]->count;
+    col[ts->cap * c++] = sys->JOB_QUEUE->count;
+    col[ts->cap * c++] = sys->num_free_frames;
+    col[ts->cap * c++] = sys->CPU->RUNNING_PROCESS != NULL;
+    for(int i = 0; sys->GROUPS && i < sys->GROUPS->count; i++){
+        RGROUP * g = &sys->GROUPS->g[i];
+        col[ts->cap * c++] = g->READY_n;
+        col[ts->cap * c++] = g->THROTTLED;
+        col[ts->cap * c++] = (int)g->CPU_t;
+        col[ts->cap * c++] = g->FRAMES;
+    }
+    ts->count++;
+
+    TWHEEL_arm(sys->TIMERS, &ts->TIMER,
+               ms_to_ticks(sys->clock + ts->interval));
+}
+
+TSERIES *TSERIES_new(SYSGEN * sys, double interval, int cap, char * file)
+{
+    TSERIES * ts = calloc( 1, sizeof(TSERIES) );
+    ts->sys = sys;
+    ts->interval = interval;
+    ts->cap = cap;
+    ts->file = file;
+    int groups = sys->GROUPS ? sys->GROUPS->count : 0;
+    ts->cols = 4 + sys->PRINTER_COUNT + sys->DISK_COUNT
+                 + sys->FLASHDRIVE_COUNT + 4 * groups;
+    ts->names = malloc( sizeof(char*) * ts->cols );
+    int c = 0;
+    ts->names[c++] = strdup("ready");
+    for(int i = 0; i < sys->PRINTER_COUNT; i++)
+        ts->names[c++] = device_name(DEVICE_PRINTER, i+1);
+    for(int i = 0; i < sys->DISK_COUNT; i++)
+        ts->names[c++] = device_name(DEVICE_DISK, i+1);
+    for(int i = 0; i < sys->FLASHDRIVE_COUNT; i++)
+        ts->names[c++] = device_name(DEVICE_FLASH, i+1);
+    ts->names[c++] = strdup("jobs");
+    ts->names[c++] = strdup("free_frames");
+    ts->names[c++] = strdup("cpu_busy");
+    for(int i = 0; i < groups; i++){
+        ts->names[c++] = group_name(i+1, "ready");
+        ts->names[c++] = group_name(i+1, "throttled");
+        ts->names[c++] = group_name(i+1, "cpu_ms");
+        ts->names[c++] = group_name(i+1, "frames");
+    }
+
+    ts->time = malloc( sizeof(double) * cap );
+    ts->data = malloc( sizeof(int) * cap * ts->cols );
+    TIMER_init(&ts->TIMER, sample, ts);
+    TWHEEL_arm(sys->TIMERS, &ts->TIMER, ms_to_ticks(sys->clock + interval));
+    return ts;
+}
+
+int TSERIES_dump(TSERIES * ts)
+{
+    size_t len = strlen(ts->file);
+    int binary = len > 4 && strcmp(ts->file + len - 4, ".bin") == 0;
+    FILE * out = fopen(ts->file, binary ? "wb" : "w");
+    if( out == NULL )
+        return 0;
+
+    /** The ring is full once count reaches cap; the oldest sample is then
+     *  the one about to be overwritten. */
+    int rows = ts->count < ts->cap ? ts->count : ts->cap;
+    int first = ts->count < ts->cap ? 0 : ts->count % ts->cap;
+    if( binary ){
+        int head[2] = { ts->cols, rows };
+        fwrite("TSR1", 1, 4, out);
+        fwrite(head, sizeof(int), 2, out);
+        for(int c = 0; c < ts->cols; c++)
+            fwrite(ts->names[c], 1, strlen(ts->names[c]) + 1, out);
+        for(int r = 0; r < rows; r++)
+            fwrite(&ts->time[(first + r) % ts->cap], sizeof(double), 1, out);
+        for(int c = 0; c < ts->cols; c++)
+            for(int r = 0; r < rows; r++)
+                fwrite(&ts->data[c * ts->cap + (first + r) % ts->cap],
+                       sizeof(int), 1, out);
+    }
+    else{
+        fprintf(out, "time_ms");
+        for(int c = 0; c < ts->cols; c++)
+            fprintf(out, ",%s", ts->names[c]);
+        fprintf(out, "\n");
+        for(int r = 0; r < rows; r++){
+            int at = (first + r) % ts->cap;
+            fprintf(out, "%.3f", ts->time[at]);
+            for(int c = 0; c < ts->cols; c++)
+                fprintf(out, ",%d", ts->data[c * ts->cap + at]);
+            fprintf(out, "\n");
+        }
+    }
+    return fclose(out) == 0;
+}
+
+void TSERIES_free(TSERIES * ts)
+{
+    TWHEEL_cancel(ts->sys->TIMERS, &ts->TIMER);
+    for(int c = 0; c < ts->cols; c++)
+        free(ts->names[c]);
+    free(ts->names);
+    free(ts->time);
+    free(ts->data);
+    free(ts->file);
+    free(ts);
+}
@@ -0,0 +1,57 @@
+/** \file
+ *  series.h:   Interface for queue time series (TSERIES).
+ *
+ *              Every interval of simulated time a timer samples the length
+ *              of the ready queue, each device and disk queue and the job
+ *              pool, the free frames and whether the CPU is busy, and for
+ *              each resource group its processes on the ready queue,
+ *              whether it is throttled, the whole ms of CPU time it has
+ *              had and the frames charged to it. Each of these is a
+ *              column with a ring of a fixed number of samples,
+ *              preallocated at sysgen, so a run of any length keeps just
+ *              the latest ones. Samples read the running counts of the
+ *              queues, not the queues themselves.
+ *
+ *              At the end of the run the samples kept are written oldest
+ *              first, as CSV with a header row, or, if the file name ends
+ *              in ".bin", in a columnar binary format in host byte order:
+ *
+ *              "TSR1", int32 columns, int32 rows,
+ *              the column names, each NUL terminated,
+ *              rows doubles: the clock of each sample in ms,
+ *              then for each column, rows int32's. */
+
+#ifndef SERIES_H_
+#define SERIES_H_
+
+#include "timer_wheel.h"
+
+struct SYSGEN;
+
+/** TSERIES struct. */
+typedef struct TSERIES {
+    struct SYSGEN   *   sys;
+    double              interval;       // Sampling interval in ms.
+    int                 cap;            // Samples kept per column.
+    int                 cols;
+    char            **  names;          // Column names.
+    double          *   time;           // Ring of sample clocks,
+    int             *   data;           //   and a ring per column, one
+                                        //   after the other.
+    long                count;          // Samples taken.
+    char            *   file;           // Written at the end of the run.
+    TIMER               TIMER;          // Next sample.
+} TSERIES;
+
+/** Start sampling sys every interval ms, keeping the last cap samples of
+ *  each column for file. */
+TSERIES *TSERIES_new(struct SYSGEN * sys, double interval, int cap,
+                     char * file);
+
+/** Write the samples kept to the file.
+ *  \return 1, 0 if the file couldn't be written. */
+int TSERIES_dump(TSERIES * ts);
+
+void TSERIES_free(TSERIES * ts);
+
+#endif
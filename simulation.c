@@ -34,7 +34,21 @@ printf("------------------------------------------------------------------\n");
 "    Extra commands:\n"
 "    - input \"Q\" to quit  the  running section and free up all dynamic\n"
 "    memory allocation.\n"
-"    - input \"C\" to erase the screen.\n\n");
+"    - input \"C\" to erase the screen.\n"
+"    - input \"T\" to issue a timer interrupt: the clock advances by the\n"
+"    queried time and expired time slices are preempted.\n"
+"    - input \"b\" for a batched I/O system call: the CPU process posts\n"
+"    several requests, on any devices, with a single kernel entry.\n"
+"    - input \"n\" for a fork system call: the CPU process gets a child\n"
+"    sharing its memory copy-on-write.\n"
+"    - input \"h\" to attach a named shared memory segment to the CPU\n"
+"    process, creating it if needed.\n"
+"    - input \"v1\" for a request on the volume striped across the\n"
+"    disks, if there is one. D# interrupts serve its parts.\n"
+"    - input \"R\" for a new real-time process, if there is a real-time\n"
+"    class: periodic, with a CPU budget and a deadline per period.\n"
+"    - with resource groups, \"A\" and \"R\" also ask for the group of\n"
+"    the new process; forked children join their parent's.\n\n");
 
 printf("------------------------------------------------------------------\n");
 
@@ -82,6 +96,17 @@ printf("------------------------------------------------------------------\n");
                     continue;
                 }
             }
+            // NEW REAL-TIME PROCESS
+            else if( *delim == 'R' ){
+                if( strlen(delim) > 1 ){
+                    printf("Skipping command: %s\n", delim);
+                    continue;
+                }
+                else{
+                    create_rt_process(os);
+                    continue;
+                }
+            }
             // SNAPSHOT
             else if( *delim == 'S'){
                 if(strlen(delim) > 1){
@@ -93,6 +118,50 @@ printf("------------------------------------------------------------------\n");
                     continue;
                 }
             }
+            // TIMER INTERRUPT
+            else if( *delim == 'T' ){
+                if(strlen(delim) > 1){
+                    printf("Skipping command: %s\n", delim);
+                    continue;
+                }
+                else{
+                    timer_interrupt(os);
+                    continue;
+                }
+            }
+            // FORK SYSTEM CALL
+            else if( *delim == 'n' ){
+                if(strlen(delim) > 1){
+                    printf("Skipping command: %s\n", delim);
+                    continue;
+                }
+                else{
+                    fork_process(os);
+                    continue;
+                }
+            }
+            // SHARED MEMORY SYSTEM CALL
+            else if( *delim == 'h' ){
+                if(strlen(delim) > 1){
+                    printf("Skipping command: %s\n", delim);
+                    continue;
+                }
+                else{
+                    shm_attach(os);
+                    continue;
+                }
+            }
+            // BATCHED I/O SYSTEM CALL
+            else if( *delim == 'b' ){
+                if(strlen(delim) > 1){
+                    printf("Skipping command: %s\n", delim);
+                    continue;
+                }
+                else{
+                    batch_syscall(os);
+                    continue;
+                }
+            }
             // SYSTEM CALL TERMINATE
             else if( *delim == 't' ){
                 if(strlen(delim) > 1){
@@ -161,7 +230,7 @@ printf("------------------------------------------------------------------\n");
                     printf("Skipping command: %s\n", delim);
                     continue;
                 }
-                else if( dev_num > os->FLASHDRIVE_COUNT ){
+                else if( dev_num > os->DISK_COUNT ){
                     printf("Skipping command: %s\n", delim);
                     continue;
                 }
@@ -176,6 +245,20 @@ printf("------------------------------------------------------------------\n");
                     }
                 }
             }
+            // VOLUME SYSCALL
+            else if( *delim == 'v' ){
+                delim++;
+                long int vol_num = strtol(delim, NULL, 10);
+                delim--;
+                if( vol_num != 1 || os->VOL == NULL ){
+                    printf("Skipping command: %s\n", delim);
+                    continue;
+                }
+                else{
+                    volume_syscall(os, vol_num);
+                    continue;
+                }
+            }
             else if( *delim == 'K'){
                 delim++;
                 int pid = strtol(delim, NULL, 10);
@@ -196,6 +279,16 @@ printf("------------------------------------------------------------------\n");
 
 
     /* Free all memory dynamically allocated by the SYSGEN object. */
+    TSERIES * ts = os->SERIES;
+    if( ts && TSERIES_dump(ts) )
+        printf("Time series: %ld sample(s) taken, the last %ld of %d"
+               " queue(s) written to %s.\n",
+                ts->count,
+                ts->count < ts->cap ? ts->count : ts->cap,
+                ts->cols,
+                ts->file);
+    else if( ts )
+        printf("Couldn't write the time series to %s.\n", ts->file);
     SYSGEN_free(os);
     printf("System memory recycled.\n");
 }
@@ -0,0 +1,103 @@
+/** \file
+ *  stats.c:    Implementation for online statistics. */
+
+#include <math.h>
+#include "stats.h"
+
+void WELFORD_add(WELFORD * w, double x)
+{
+    w->n++;
+    double d = x - w->mean;
+    w->mean += d / w->n;
+    w->m2 += d * (x - w->mean);
+}
+
+double WELFORD_var(WELFORD * w)
+{
+    return w->n > 1 ? w->m2 / (w->n - 1) : 0;
+}
+
+double WELFORD_sd(WELFORD * w)
+{
+    return sqrt(WELFORD_var(w));
+}
+
+void QSKETCH_init(QSKETCH * s, double p)
+{
+    *s = (QSKETCH){ .p = p };
+    double want[5] = { 1, 1 + 2*p, 1 + 4*p, 3 + 2*p, 5 };
+    double step[5] = { 0, p/2, p, (1 + p)/2, 1 };
+    for(int i = 0; i < 5; i++){
+        s->pos[i] = i + 1;
+        s->want[i] = want[i];
+        s->step[i] = step[i];
+    }
+}
+
+/** \return marker i of s moved d (1 or -1) positions along the parabola
+ *          through it and its neighbours, or in a straight line towards
+ *          the neighbour if the parabola would pass it. */
+static double adjust(QSKETCH * s, int i, int d)
+{
+    double * q = s->q;
+    double * n = s->pos;
+    double h =   q[i] + d / (n[i+1] - n[i-1])
+               * (  (n[i] - n[i-1] + d) * (q[i+1] - q[i]) / (n[i+1] - n[i])
+                  + (n[i+1] - n[i] - d) * (q[i] - q[i-1]) / (n[i] - n[i-1]) );
+    if( q[i-1] < h && h < q[i+1] )
+        return h;
+    return q[i] + d * (q[i+d] - q[i]) / (n[i+d] - n[i]);
+}
+
+void QSKETCH_add(QSKETCH * s, double x)
+{
+    /** The first five values are kept sorted as the markers. */
+    if( s->n < 5 ){
+        int i = s->n++;
+        while( i > 0 && s->q[i-1] > x ){
+            s->q[i] = s->q[i-1];
+            i--;
+        }
+        s->q[i] = x;
+        return;
+    }
+    s->n++;
+
+    int k;
+    if( x < s->q[0] ){
+        s->q[0] = x;
+        k = 0;
+    }
+    else if( x >= s->q[4] ){
+        s->q[4] = x;
+        k = 3;
+    }
+    else
+        for(k = 0; x >= s->q[k+1]; k++);
+    for(int i = k + 1; i < 5; i++)
+        s->pos[i]++;
+    for(int i = 0; i < 5; i++)
+        s->want[i] += s->step[i];
+
+    for(int i = 1; i < 4; i++){
+        double d = s->want[i] - s->pos[i];
+        if(    (d >= 1 && s->pos[i+1] - s->pos[i] > 1)
+            || (d <= -1 && s->pos[i-1] - s->pos[i] < -1) ){
+            int dir = d > 0 ? 1 : -1;
+            s->q[i] = adjust(s, i, dir);
+            s->pos[i] += dir;
+        }
+    }
+}
+
+double QSKETCH_get(QSKETCH * s)
+{
+    if( s->n == 0 )
+        return 0;
+    /** Until the sixth value the markers are just the values, sorted. */
+    if( s->n <= 5 ){
+        int i = (int)ceil(s->p * s->n) - 1;
+        return s->q[i < 0 ? 0 : i];
+    }
+    return s->q[2];
+}
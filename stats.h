@@ -0,0 +1,57 @@
+/** \file
+ *  stats.h:    Interface for online statistics.
+ *
+ *              WELFORD keeps the count, mean and variance of a stream of
+ *              values in one pass, with Welford's update: each value moves
+ *              the mean by its distance from it over the count, and adds
+ *              the product of its distances from the old and the new mean
+ *              to the sum of squares. Unlike recomputing (n-1)*mean + x,
+ *              this doesn't lose precision as n grows.
+ *
+ *              QSKETCH estimates one quantile of a stream in constant space
+ *              with the P-square algorithm (Jain and Chlamtac): five
+ *              markers track the minimum, the quantile, the maximum and the
+ *              points halfway between, and are nudged along a parabola as
+ *              values arrive. Until five values have been seen the exact
+ *              quantile of those is used. */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+/** Running mean and variance. Zeroed is empty. */
+typedef struct WELFORD {
+    long                n;
+    double              mean;
+    double              m2;             // Sum of squared distances from
+                                        //   the mean.
+} WELFORD;
+
+/** Streaming quantile estimate. */
+typedef struct QSKETCH {
+    double              p;              // Quantile, 0 < p < 1.
+    long                n;              // Values seen.
+    double              q[5];           // Marker heights,
+    double              pos[5];         //   positions,
+    double              want[5];        //   desired positions
+    double              step[5];        //   and how those move per value.
+} QSKETCH;
+
+/** Add x to w. */
+void WELFORD_add(WELFORD * w, double x);
+
+/** \return the sample variance of w, 0 below two values. */
+double WELFORD_var(WELFORD * w);
+
+/** \return the sample standard deviation of w. */
+double WELFORD_sd(WELFORD * w);
+
+/** Start an empty sketch of quantile p. */
+void QSKETCH_init(QSKETCH * s, double p);
+
+/** Add x to s. */
+void QSKETCH_add(QSKETCH * s, double x);
+
+/** \return the estimate of s' quantile, 0 if it is empty. */
+double QSKETCH_get(QSKETCH * s);
+
+#endif
@@ -3,9 +3,69 @@
 #include <string.h>
 #include "sysgen.h"
 #include "user_input_utilities.h"
+#include "dispatcher.h"
 
 #define BUF_SIZE 100
 
+/** Prompt for a rate, which has to be positive. */
+static void get_rate(char * prompt, double * loc)
+{
+    get_double(prompt, loc);
+    while( *loc <= 0 ){
+        printf("Rate must be positive.\n");
+        get_double(prompt, loc);
+    }
+}
+
+/** Prompt for an aging rate, which can't be negative. */
+static void get_aging(char * prompt, double * loc)
+{
+    get_double(prompt, loc);
+    while( *loc < 0 ){
+        printf("Rate can't be negative.\n");
+        get_double(prompt, loc);
+    }
+}
+
+/** Prompt for a count, which has to be at least 1. */
+static void get_count(char * prompt, int * loc)
+{
+    get_int(prompt, loc);
+    while( *loc < 1 ){
+        printf("Count must be at least 1.\n");
+        get_int(prompt, loc);
+    }
+}
+
+/** Prompt for the CPU weight, CPU cap and frame quota of group g.
+ *  \param  capped is set to 1 if g has a cap. */
+static void get_group(RGROUP * g, int * capped)
+{
+    char prompt[BUF_SIZE];
+    snprintf(prompt, BUF_SIZE, "Enter group %d CPU weight:", g->NUM);
+    get_double(prompt, &g->weight);
+    while( g->weight <= 0 ){
+        printf("Weight must be positive.\n");
+        get_double(prompt, &g->weight);
+    }
+    snprintf(prompt, BUF_SIZE, "Enter group %d CPU cap (0 to 1, 0 for"
+             " none):", g->NUM);
+    get_double(prompt, &g->cap);
+    while( g->cap < 0 || g->cap > 1 ){
+        printf("Cap must be between 0 and 1.\n");
+        get_double(prompt, &g->cap);
+    }
+    if( g->cap > 0 )
+        *capped = 1;
+    snprintf(prompt, BUF_SIZE, "Enter group %d frame quota (frames, 0 for"
+             " none):", g->NUM);
+    get_int(prompt, &g->quota);
+    while( g->quota < 0 ){
+        printf("Quota can't be negative.\n");
+        get_int(prompt, &g->quota);
+    }
+}
+
 SYSGEN * SYSGEN_new()
 {
     SYSGEN * sys_init = malloc(sizeof(SYSGEN));
@@ -15,15 +75,195 @@ SYSGEN * SYSGEN_new()
     get_int("Enter disk device count:", &sys_init->DISK_COUNT); 
     get_int("Enter flash drive device count:", &sys_init->FLASHDRIVE_COUNT);  
     get_alpha("Enter history parameter, a (alpha), 0 <= a <= 1:", &sys_init->a);
+    get_int("Tune alpha per process (0=no, 1=yes):", &sys_init->ADAPT);
+    while( sys_init->ADAPT != 0 && sys_init->ADAPT != 1 ){
+        printf("Enter 0 or 1.\n");
+        get_int("Tune alpha per process (0=no, 1=yes):", &sys_init->ADAPT);
+    }
+    if( sys_init->ADAPT )
+        PCB_table_tune();
     get_double("Enter initial burst estimate, t (tau), in ms:", &sys_init->t);
     get_int("Enter size of memory (# of words):", &sys_init->mem_size);
     get_int("Enter maximum process size:", &sys_init->max_proc_size);
     get_page_size("Enter page size:", &sys_init->frame_size);
+    get_int("Enter scheduling policy (0=SJF, 1=RR, 2=MLFQ, 3=FAIR):",
+            &sys_init->SCHED_POLICY);
+    while(    sys_init->SCHED_POLICY < 0
+          ||  sys_init->SCHED_POLICY >= SCHED_POLICY_COUNT )
+    {
+        printf("Unknown scheduling policy.\n");
+        get_int("Enter scheduling policy (0=SJF, 1=RR, 2=MLFQ, 3=FAIR):",
+                &sys_init->SCHED_POLICY);
+    }
+    sys_init->quantum = 0;
+    if( sys_init->SCHED_POLICY != SCHED_POLICY_SJF ){
+        get_double("Enter time quantum (ms):", &sys_init->quantum);
+        while( sys_init->quantum <= 0 ){
+            printf("Quantum must be positive.\n");
+            get_double("Enter time quantum (ms):", &sys_init->quantum);
+        }
+    }
+    double rq_aging = 0;
+    if( sys_init->SCHED_POLICY == SCHED_POLICY_SJF )
+        get_aging("Enter ready queue aging (ms of burst per ms waited, 0 for"
+                  " none):", &rq_aging);
+    double jq_aging;
+    get_aging("Enter job pool aging (words per ms waited, 0 for none):",
+              &jq_aging);
+    double rt_cap;
+    get_double("Enter real-time density cap (0 to 1, 0 for no real-time"
+               " class):", &rt_cap);
+    while( rt_cap < 0 || rt_cap > 1 ){
+        printf("Cap must be between 0 and 1.\n");
+        get_double("Enter real-time density cap (0 to 1, 0 for no"
+                   " real-time class):", &rt_cap);
+    }
+    int group_n;
+    get_int("Enter resource group count (0 for none):", &group_n);
+    while( group_n < 0 ){
+        printf("Count can't be negative.\n");
+        get_int("Enter resource group count (0 for none):", &group_n);
+    }
+    sys_init->GROUPS = group_n > 0 ? RG_new(sys_init, group_n) : NULL;
+    int capped = 0;
+    double group_period = 0;
+    for(int i = 0; i < group_n; i++)
+        get_group(&sys_init->GROUPS->g[i], &capped);
+    if( capped ){
+        get_double("Enter CPU cap period (ms):", &group_period);
+        while( group_period <= 0 ){
+            printf("Period must be positive.\n");
+            get_double("Enter CPU cap period (ms):", &group_period);
+        }
+    }
+    get_double("Enter context switch dispatcher latency (ms):",
+               &sys_init->cs_latency);
+    while( sys_init->cs_latency < 0 ){
+        printf("Latency can't be negative.\n");
+        get_double("Enter context switch dispatcher latency (ms):",
+                   &sys_init->cs_latency);
+    }
+    get_double("Enter cold cache/TLB refill penalty (ms, 0 for none):",
+               &sys_init->cs_cold_penalty);
+    while( sys_init->cs_cold_penalty < 0 ){
+        printf("Penalty can't be negative.\n");
+        get_double("Enter cold cache/TLB refill penalty (ms, 0 for none):",
+                   &sys_init->cs_cold_penalty);
+    }
+    sys_init->cs_decay = 0;
+    if( sys_init->cs_cold_penalty > 0 ){
+        get_double("Enter cache warmth decay time (ms):", &sys_init->cs_decay);
+        while( sys_init->cs_decay <= 0 ){
+            printf("Decay time must be positive.\n");
+            get_double("Enter cache warmth decay time (ms):",
+                       &sys_init->cs_decay);
+        }
+    }
+    get_int("Model device service times (0=no, 1=yes):", &sys_init->IO_AUTO);
+    if( sys_init->IO_AUTO ){
+        if( sys_init->PRINTER_COUNT > 0 )
+            get_rate("Enter printer throughput (bytes/s):",
+                     &sys_init->prn_rate);
+        if( sys_init->FLASHDRIVE_COUNT > 0 ){
+            get_double("Enter flash read latency (ms):",
+                       &sys_init->flash_rd_lat);
+            get_double("Enter flash write latency (ms):",
+                       &sys_init->flash_wr_lat);
+            get_rate("Enter flash transfer rate (bytes/ms):",
+                     &sys_init->flash_rate);
+            get_count("Enter flash channel count:", 
+                      &sys_init->flash_channels);
+            get_count("Enter flash queue depth:", &sys_init->flash_qd);
+            get_double("Enter flash GC stall (ms, 0 for none):",
+                       &sys_init->flash_gc_stall);
+            if( sys_init->flash_gc_stall > 0 )
+                get_count("Enter flash writes between GC stalls:",
+                          &sys_init->flash_gc_every);
+        }
+        if( sys_init->DISK_COUNT > 0 ){
+            get_double("Enter disk seek time per cylinder (ms):",
+                       &sys_init->disk_seek);
+            get_double("Enter disk rotational latency (ms):",
+                       &sys_init->disk_rot);
+            get_rate("Enter disk transfer rate (bytes/ms):",
+                     &sys_init->disk_rate);
+        }
+    }
+    else{
+        /** Service times are still modelled for the statistics; the 
+         *  defaults just avoid dividing by zero. */
+        sys_init->prn_rate = sys_init->flash_rate = sys_init->disk_rate = 1;
+        sys_init->flash_rd_lat = sys_init->flash_wr_lat = 0;
+        sys_init->disk_seek = sys_init->disk_rot = 0;
+    }
+    if( !sys_init->IO_AUTO || sys_init->FLASHDRIVE_COUNT == 0 ){
+        sys_init->flash_channels = sys_init->flash_qd = 1;
+        sys_init->flash_gc_stall = 0;
+    }
+    if( sys_init->flash_gc_stall <= 0 )
+        sys_init->flash_gc_every = 0;
+    get_double("Enter I/O kernel entry overhead (ms):",
+               &sys_init->io_entry_cost);
+    get_double("Enter completion interrupt coalescing window (ms):",
+               &sys_init->io_coalesce);
+    sys_init->SYS_t = 0;
+    sys_init->SWITCH_t = 0;
+    sys_init->SWITCH_n = 0;
     sys_init->num_frames = (sys_init->mem_size)/(sys_init->frame_size);    
 
+    /** The buffer cache holds one page sized block per frame, and the 
+     *  frames come out of memory; at least one is left for processes. */
+    int cache_frames = 0;
+    int cache_policy = BCACHE_LRU;
+    double wb_interval = 0;
+    if( sys_init->DISK_COUNT > 0 ){
+        get_int("Enter buffer cache size (frames, 0 for none):", 
+                &cache_frames);
+        while( cache_frames < 0 || cache_frames >= sys_init->num_frames ){
+            printf("Cache must leave at least one of %d frames.\n",
+                    sys_init->num_frames);
+            get_int("Enter buffer cache size (frames, 0 for none):",
+                    &cache_frames);
+        }
+    }
+    if( cache_frames > 0 ){
+        get_int("Enter buffer cache policy (0=LRU, 1=2Q, 2=ARC):",
+                &cache_policy);
+        while( cache_policy < 0 || cache_policy >= BCACHE_COUNT ){
+            printf("Unknown cache policy.\n");
+            get_int("Enter buffer cache policy (0=LRU, 1=2Q, 2=ARC):",
+                    &cache_policy);
+        }
+        get_rate("Enter write-back interval (ms):", &wb_interval);
+    }
+    int ra_min = 0;
+    int ra_max = 0;
+    if( sys_init->DISK_COUNT > 0 || sys_init->FLASHDRIVE_COUNT > 0 ){
+        get_int("Enter initial readahead window (bytes, 0 for none):",
+                &ra_min);
+        while( ra_min < 0 ){
+            printf("Window can't be negative.\n");
+            get_int("Enter initial readahead window (bytes, 0 for none):",
+                    &ra_min);
+        }
+    }
+    if( ra_min > 0 ){
+        get_int("Enter maximum readahead window (bytes):", &ra_max);
+        while( ra_max < ra_min ){
+            printf("Maximum must be at least the initial window.\n");
+            get_int("Enter maximum readahead window (bytes):", &ra_max);
+        }
+    }
+
     // Set initial CPU statistics: 
-    sys_init->CPU_avg = 0.0; 
-    sys_init->CPU_n   = 0.0;
+    sys_init->CPU_TOTAL = (WELFORD){ 0 };
+    sys_init->BURST = (WELFORD){ 0 };
+    sys_init->PRED_ERR = (WELFORD){ 0 };
+    sys_init->FIXED_ERR = (WELFORD){ 0 };
+    sys_init->RECENT_n = 0;
+    QSKETCH_init(&sys_init->BURST_P50, 0.50);
+    QSKETCH_init(&sys_init->BURST_P90, 0.90);
+    QSKETCH_init(&sys_init->BURST_P99, 0.99);
 
     /** Generate frame table and free frame list. */
     sys_init->frame_table = malloc( sizeof(frame) * sys_init->num_frames); 
@@ -31,16 +271,34 @@ SYSGEN * SYSGEN_new()
         sys_init->frame_table[i].NUM = i; 
         sys_init->frame_table[i].PID = -1; 
         sys_init->frame_table[i].PAGE_NUM = -1;
+        sys_init->frame_table[i].REF = 0;
+        sys_init->frame_table[i].owner = NULL;
+        sys_init->frame_table[i].rmap = NULL;
+        sys_init->frame_table[i].SHM = 0;
     }
+    sys_init->FORK_n = 0;
+    sys_init->COW_COPY_n = 0;
+    sys_init->COW_REUSE_n = 0;
+    sys_init->FRAMES_SHARED = 0;
+    sys_init->ZERO_FILL_n = 0;
+    sys_init->SEGMENTS = NULL;
     sys_init->num_free_frames = sys_init->num_frames;
 
-    sys_init->frame_bag.frames = malloc( sizeof(int) * sys_init->num_frames); 
-    for(int i = 0; i < sys_init->num_frames; i++){
-        sys_init->frame_bag.frames[i] = i; 
+    /** All frames start out as one free run, less the top ones, which are
+     *  lent to the buffer cache. */
+    sys_init->frame_bag.cap = 8;
+    sys_init->frame_bag.runs = malloc( sizeof(FRAME_RUN) * 
+                                       sys_init->frame_bag.cap );
+    sys_init->frame_bag.runs[0] = (FRAME_RUN){ 
+            .start = 0, 
+            .len = sys_init->num_frames - cache_frames };
+    sys_init->frame_bag.count = 1;
+    sys_init->frame_bag.largest = sys_init->frame_bag.runs[0].len;
+    for(int i = sys_init->num_frames - cache_frames; 
+            i < sys_init->num_frames; i++){
+        sys_init->frame_table[i].PID = FRAME_CACHE;
+        sys_init->num_free_frames--;
     }
-    /** Counter points to last position in int array which contains number 
-     *  of an available frame. */
-    sys_init->frame_bag.counter = sys_init->num_frames-1;
     
 
     /** Allocate array of disk cylinder counts and get user input for each 
@@ -54,8 +312,138 @@ SYSGEN * SYSGEN_new()
         get_int(prompt, &sys_init->CYLINDER_COUNTS[i]); 
     }
 
+    /** Lay out a file system on each disk, with page sized blocks. */
+    int blocks_per_cyl = 1;
+    int extent_limit = 0;
+    if( sys_init->DISK_COUNT > 0 ){
+        get_count("Enter disk blocks per cylinder:", &blocks_per_cyl);
+        get_int("Enter maximum extent length (blocks, 0 for no limit):",
+                &extent_limit);
+        while( extent_limit < 0 ){
+            printf("Extent length can't be negative.\n");
+            get_int("Enter maximum extent length (blocks, 0 for no limit):",
+                    &extent_limit);
+        }
+    }
+    sys_init->FILESYS = malloc( sizeof(FSYS*) * sys_init->DISK_COUNT );
+    for( int i = 0; i < sys_init->DISK_COUNT; i++)
+        sys_init->FILESYS[i] = FSYS_new(sys_init->CYLINDER_COUNTS[i], 
+                                        blocks_per_cyl, sys_init->frame_size,
+                                        extent_limit);
+
+    /** Stripe a volume over the disks. */
+    int vol_layout = VOL_NONE;
+    int vol_stripe = 1;
+    if( sys_init->DISK_COUNT > 1 ){
+        get_int("Enter volume layout (0=none, 1=RAID-0, 2=RAID-10):",
+                &vol_layout);
+        while(    vol_layout < VOL_NONE || vol_layout > VOL_RAID10
+              || (vol_layout == VOL_RAID10 && sys_init->DISK_COUNT % 2) )
+        {
+            printf("Unknown layout, or RAID-10 over an odd number of "
+                   "disks.\n");
+            get_int("Enter volume layout (0=none, 1=RAID-0, 2=RAID-10):",
+                    &vol_layout);
+        }
+    }
+    if( vol_layout != VOL_NONE )
+        get_count("Enter stripe unit (blocks):", &vol_stripe);
+
+    /** Swap to the end of a disk. */
+    int swap_disk = 0;
+    int swap_slots = 0;
+    if( sys_init->DISK_COUNT > 0 ){
+        get_int("Enter swap disk (0 for none):", &swap_disk);
+        while( swap_disk < 0 || swap_disk > sys_init->DISK_COUNT ){
+            printf("No such disk.\n");
+            get_int("Enter swap disk (0 for none):", &swap_disk);
+        }
+    }
+    if( swap_disk > 0 ){
+        get_count("Enter swap space (pages):", &swap_slots);
+        while( swap_slots > (int)sys_init->FILESYS[swap_disk-1]->total ){
+            printf("Swap space doesn't fit on the disk.\n");
+            get_count("Enter swap space (pages):", &swap_slots);
+        }
+    }
+
+    /** Working set sampling and page fault frequency bounds. */
+    double ws_interval;
+    int ws_window = 0;
+    int pff_low = 0;
+    int pff_high = 0;
+    get_double("Enter working set sample interval (ms, 0 for none):",
+               &ws_interval);
+    while( ws_interval < 0 ){
+        printf("Interval can't be negative.\n");
+        get_double("Enter working set sample interval (ms, 0 for none):",
+                   &ws_interval);
+    }
+    if( ws_interval > 0 ){
+        get_int("Enter working set window (samples, 1-8):", &ws_window);
+        while( ws_window < 1 || ws_window > 8 ){
+            printf("Window must be 1 to 8 samples.\n");
+            get_int("Enter working set window (samples, 1-8):", &ws_window);
+        }
+    }
+    if( ws_interval > 0 && swap_disk > 0 ){
+        get_int("Enter low page fault frequency (faults per sample):",
+                &pff_low);
+        get_int("Enter high page fault frequency (faults per sample):",
+                &pff_high);
+        while( pff_high < pff_low ){
+            printf("High frequency must be at least the low one.\n");
+            get_int("Enter high page fault frequency (faults per sample):",
+                    &pff_high);
+        }
+    }
+
+    /** Page tables have to reach the largest process. */
+    int max_pages =   (sys_init->max_proc_size + sys_init->frame_size - 1)
+                    / sys_init->frame_size;
+    int pt_levels;
+    int pt_large = 0;
+    get_int("Enter page table levels (1-3):", &pt_levels);
+    while(    pt_levels < 1 || pt_levels > 3
+          ||  max_pages > PT_capacity(pt_levels, sys_init->frame_size) )
+    {
+        if( pt_levels < 1 || pt_levels > 3 )
+            printf("Page tables have 1 to 3 levels.\n");
+        else
+            printf("%d levels map at most %lld pages.\n", pt_levels,
+                    PT_capacity(pt_levels, sys_init->frame_size));
+        get_int("Enter page table levels (1-3):", &pt_levels);
+    }
+    if( pt_levels > 1 )
+        get_int("Use large pages (0=no, 1=yes):", &pt_large);
+    sys_init->PT = PT_config_new(pt_levels, sys_init->frame_size, pt_large);
+
+    /** Queue time series. */
+    double ts_interval;
+    int ts_cap = 0;
+    char * ts_file = NULL;
+    get_double("Enter queue sampling interval (ms, 0 for none):",
+               &ts_interval);
+    while( ts_interval < 0 ){
+        printf("Interval can't be negative.\n");
+        get_double("Enter queue sampling interval (ms, 0 for none):",
+                   &ts_interval);
+    }
+    if( ts_interval > 0 ){
+        get_count("Enter samples kept per queue:", &ts_cap);
+        get_string("Enter time series file (.bin for binary, else CSV)",
+                   &ts_file);
+    }
+
     // Allocate the ready queue:
-    sys_init->READY_QUEUE = READYQ_new();
+    sys_init->READY_QUEUE = READYQ_new(sys_init->SCHED_POLICY,
+                                       sys_init->quantum, rq_aging,
+                                       &sys_init->clock);
+    sys_init->RT = NULL;
+    if( rt_cap > 0 ){
+        sys_init->RT = RT_new(rt_cap);
+        READYQ_rt_class(sys_init->READY_QUEUE);
+    }
 
     // Allocate the printer queues:
     sys_init->PRINTERS = malloc(sizeof(DEVICEQ*) * sys_init->PRINTER_COUNT);
@@ -73,11 +461,75 @@ SYSGEN * SYSGEN_new()
     for(int i = 0; i < sys_init->FLASHDRIVE_COUNT; i++)
         sys_init->FLASHDRIVES[i] = DEVICEQ_new();
 
+    // Set up device service state:
+    sys_init->PRINTER_UNITS = malloc(sizeof(DEVICE) * sys_init->PRINTER_COUNT);
+    for(int i = 0; i < sys_init->PRINTER_COUNT; i++)
+        DEVICE_init(&sys_init->PRINTER_UNITS[i], sys_init, DEVICE_PRINTER, 
+                    i+1, 1, 1);
+    sys_init->DISK_UNITS = malloc(sizeof(DEVICE) * sys_init->DISK_COUNT);
+    for(int i = 0; i < sys_init->DISK_COUNT; i++)
+        DEVICE_init(&sys_init->DISK_UNITS[i], sys_init, DEVICE_DISK, 
+                    i+1, 1, 1);
+    sys_init->FLASH_UNITS = malloc(sizeof(DEVICE) * 
+                                   sys_init->FLASHDRIVE_COUNT);
+    for(int i = 0; i < sys_init->FLASHDRIVE_COUNT; i++)
+        DEVICE_init(&sys_init->FLASH_UNITS[i], sys_init, DEVICE_FLASH, 
+                    i+1, sys_init->flash_channels, sys_init->flash_qd);
+
+    // Allocate the I/O rings:
+    sys_init->IO = IO_RING_new(sys_init);
+    sys_init->CACHE = NULL;
+    sys_init->RA = NULL;
+    sys_init->VOL = NULL;
+    sys_init->SWAP = NULL;
+    sys_init->WS = NULL;
+    sys_init->SNAP = NULL;
+    sys_init->SNAP_n = 0;
+    sys_init->SERIES = NULL;
+
+    // Start the clock:
+    sys_init->clock = 0;
+    sys_init->TIMERS = TWHEEL_new();
+
+    // Allocate the buffer cache:
+    if( cache_frames > 0 )
+        sys_init->CACHE = BCACHE_new(sys_init, cache_frames, 
+                                     sys_init->frame_size, cache_policy,
+                                     wb_interval);
+
+    // Allocate readahead:
+    if( ra_min > 0 )
+        sys_init->RA = READAHEAD_new(sys_init, ra_min, ra_max);
+
+    // Allocate the volume:
+    if( vol_layout != VOL_NONE )
+        sys_init->VOL = VOLUME_new(sys_init, vol_layout, vol_stripe,
+                                   blocks_per_cyl, extent_limit);
+
+    // Allocate the swap area:
+    if( swap_disk > 0 )
+        sys_init->SWAP = MEM_swap_new(sys_init, swap_disk, swap_slots);
+
+    // Start working set control:
+    if( ws_interval > 0 )
+        sys_init->WS = MEM_ws_new(sys_init, ws_interval, ws_window, pff_low,
+                                  pff_high);
+
+    // Start the cap periods of the resource groups:
+    if( group_period > 0 )
+        RG_start(sys_init->GROUPS, group_period);
+
     // Allocate the CPU:
     sys_init->CPU = PROCESSOR_new();
+    dispatcher_init(sys_init);
 
     // Allocate job queue:
-    sys_init->JOB_QUEUE = JOBQ_new();
+    sys_init->JOB_QUEUE = JOBQ_new(jq_aging, &sys_init->clock);
+
+    // Start sampling the queues, now that they are all there:
+    if( ts_interval > 0 )
+        sys_init->SERIES = TSERIES_new(sys_init, ts_interval, ts_cap,
+                                       ts_file);
 
     return sys_init;
 
@@ -85,11 +537,26 @@ SYSGEN * SYSGEN_new()
 
 void SYSGEN_free(SYSGEN * recycle)
 {
-    // Free cylinder count array:
+    // Free cylinder count array and file systems:
     free(recycle->CYLINDER_COUNTS);
+    for(int i = 0; i < recycle->DISK_COUNT; i++)
+        FSYS_free(recycle->FILESYS[i]);
+    free(recycle->FILESYS);
     
     // Free the ready queue:
     READYQ_free(recycle->READY_QUEUE);
+    free(recycle->RT);
+
+    // Free the I/O rings, the buffer cache and readahead:
+    IO_RING_free(recycle->IO);
+    if( recycle->CACHE )
+        BCACHE_free(recycle->CACHE);
+    if( recycle->RA )
+        READAHEAD_free(recycle->RA);
+    if( recycle->VOL )
+        VOLUME_free(recycle->VOL);
+    if( recycle->SERIES )
+        TSERIES_free(recycle->SERIES);
 
     // Free device queues:
     for(int i = 0; i < recycle->PRINTER_COUNT; i++)
@@ -106,19 +573,43 @@ void SYSGEN_free(SYSGEN * recycle)
         DEVICEQ_free(recycle->FLASHDRIVES[i]);
     free(recycle->FLASHDRIVES);
 
+    // Free device service state:
+    for(int i = 0; i < recycle->PRINTER_COUNT; i++)
+        DEVICE_free(&recycle->PRINTER_UNITS[i]);
+    free(recycle->PRINTER_UNITS);
+    for(int i = 0; i < recycle->DISK_COUNT; i++)
+        DEVICE_free(&recycle->DISK_UNITS[i]);
+    free(recycle->DISK_UNITS);
+    for(int i = 0; i < recycle->FLASHDRIVE_COUNT; i++)
+        DEVICE_free(&recycle->FLASH_UNITS[i]);
+    free(recycle->FLASH_UNITS);
+
     // Free the CPU:
     if( recycle->CPU->RUNNING_PROCESS != NULL){
       PCB_free(recycle->CPU->RUNNING_PROCESS);
     }
     PROCESSOR_free(recycle->CPU);
 
+    // Free the timer wheel:
+    TWHEEL_free(recycle->TIMERS);
+
     /** Free the frame table and frame list. */ 
+    MEM_free(recycle);
     free(recycle->frame_table); 
-    free(recycle->frame_bag.frames);
 
     /** Free the job queue: */
     JOBQ_free(recycle->JOB_QUEUE);
 
+    /** The page tables went with the processes. */
+    free(recycle->PT);
+    free(recycle->SNAP);
+
+    /** Every PCB has been returned, so release the process table. The
+     *  groups went on being charged until then. */
+    PCB_table_free();
+    if( recycle->GROUPS )
+        RG_free(recycle->GROUPS);
+
     // Free the SYSGEN object:
     free(recycle);
 }
@@ -9,20 +9,61 @@
 #include "ready_queue.h"
 #include "cpu.h"
 #include "job_queue.h"
+#include "timer_wheel.h"
+#include "device.h"
+#include "io_ring.h"
+#include "buffer_cache.h"
+#include "readahead.h"
+#include "filesys.h"
+#include "volume.h"
+#include "memory.h"
+#include "series.h"
+#include "realtime.h"
+#include "rgroup.h"
+
+/** Frame table PID of frames lent to the buffer cache. */
+#define FRAME_CACHE     -2
 
 typedef struct frame {
     int     NUM;
-    int     PID; 
+    int     PID;        /** -1 if free, FRAME_CACHE if the buffer cache 
+                        *   has it. */
     int     PAGE_NUM;   /** If a process is using a frame, then this is the 
                         *   page number offset for the processes page table 
                         *   that gives this frame number. */
+    int     REF;        /** Page table entries mapping the frame. */
+    PCB *   owner;      /** The first of them, whose PID and PAGE_NUM 
+                        *   these are; NULL if free. */
+    RMAP *  rmap;       /** The others. */
+    int     SHM;        /** 1 if it holds a page of a shared memory 
+                        *   segment. */
 }frame;
 
+/** Run of consecutive free frames. */
+typedef struct FRAME_RUN {
+    int     start;
+    int     len;
+} FRAME_RUN;
+
+/** Free frames, as runs sorted by start. Runs never touch; freed frames
+ *  merge with their neighbours. */
 typedef struct frame_list{
-    int * frames;
-    int counter;
+    FRAME_RUN * runs;
+    int count;
+    int cap;
+    int largest;        /** Longest run, -1 if it has to be found again. */
 } frame_list;
 
+/** Recent bursts kept to judge the predictions by. */
+#define BURST_WINDOW    64
+
+/** One completed burst and what was predicted for it. */
+typedef struct BURST_SAMPLE {
+    double          TAU;                // TAU_n_plus1,
+    double          TAU_FIXED;          //   with the system's a,
+    double          BURST;              //   and the burst itself.
+} BURST_SAMPLE;
+
 /** struct SYSGEN */ 
 typedef struct SYSGEN{
     
@@ -30,9 +71,13 @@ typedef struct SYSGEN{
     int             DISK_COUNT;
     int             FLASHDRIVE_COUNT;
     int       *     CYLINDER_COUNTS;    // Array of cylinder counts for disks. 
+    FSYS      **    FILESYS;            // File system on each disk.
     DEVICEQ   **    PRINTERS;           // Pointer to array of printer queues.
     DISKQ     **    DISKS;              // Pointer to array of disk queues.
     DEVICEQ   **    FLASHDRIVES;        // Pointer to array of flash queues.
+    DEVICE    *     PRINTER_UNITS;      // Service state of each printer,
+    DEVICE    *     DISK_UNITS;         //   disk and flash drive, indexed
+    DEVICE    *     FLASH_UNITS;        //   like the queues.
     READYQ    *     READY_QUEUE;        // Pointer to the ready queue.
     PROCESSOR *     CPU;                // Pointer to processor object.
     JOBQ      *     JOB_QUEUE;          // Input queue for processes waiting to
@@ -41,10 +86,68 @@ typedef struct SYSGEN{
     /** System-wide CPU accounting info */ 
     
     double          a;                  // History param, 0 <= a <= 1.
+    int             ADAPT;              // 1 to tune it per process.
     double          t;                  // Burst estimate in ms, t(tau).
-    double          CPU_avg;            // System's average total CPU time 
-                                        //   of completed processes.   
-    double          CPU_n;              // Number of completed processes. 
+    WELFORD         CPU_TOTAL;          // Total CPU time of completed
+                                        //   processes.
+    WELFORD         BURST;              // CPU burst lengths of all
+    WELFORD         PRED_ERR;           //   processes, and the errors of
+                                        //   their predictions.
+    QSKETCH         BURST_P50;          // Burst length quantiles.
+    QSKETCH         BURST_P90;
+    QSKETCH         BURST_P99;
+    WELFORD         FIXED_ERR;          // Prediction errors a fixed a 
+                                        //   would have made.
+    BURST_SAMPLE    RECENT[BURST_WINDOW];   // Ring of the last bursts.
+    long            RECENT_n;           // Bursts put in it.
+
+    /** Time */
+    double          clock;              // Simulation clock in ms.
+    TWHEEL    *     TIMERS;             // Timers armed against the clock.
+
+    /** Context switch cost model */
+    double          cs_latency;         // Fixed dispatcher latency in ms.
+    double          cs_cold_penalty;    // Extra ms to refill the TLB and 
+                                        //   caches for a fully cold process.
+    double          cs_decay;           // Time constant in ms for a 
+                                        //   process' cache footprint to 
+                                        //   decay once it is off the CPU.
+    double          SYS_t;              // Total system (kernel) time.
+    double          SWITCH_t;           // System time spent switching.
+    long            SWITCH_n;           // Number of context switches.
+
+    /** Device service-time model */
+    int             IO_AUTO;            // 1 to complete device requests 
+                                        //   automatically.
+    double          prn_rate;           // Printer throughput, bytes/s.
+    double          flash_rd_lat;       // Flash read latency in ms.
+    double          flash_wr_lat;       // Flash write latency in ms.
+    double          flash_rate;         // Flash transfer rate, bytes/ms.
+    int             flash_channels;     // Parallel flash channels/dies.
+    int             flash_qd;           // Flash queue depth.
+    double          flash_gc_stall;     // Garbage collection stall in ms.
+    int             flash_gc_every;     // Writes per channel between GC
+                                        //   stalls, 0 for no GC.
+    IO_RING   *     IO;                 // I/O submission/completion rings.
+    double          io_entry_cost;      // System time per kernel entry to
+                                        //   submit or reap I/O, in ms.
+    double          io_coalesce;        // Completion interrupt coalescing
+                                        //   window in ms.
+    double          disk_seek;          // Disk seek time per cylinder, ms.
+    double          disk_rot;           // Disk rotational latency, ms.
+    double          disk_rate;          // Disk transfer rate, bytes/ms.
+    BCACHE    *     CACHE;              // Disk buffer cache, NULL if none.
+    READAHEAD *     RA;                 // Disk and flash readahead, NULL
+                                        //   if none.
+    VOLUME    *     VOL;                // Volume striped over the disks,
+                                        //   NULL if none.
+
+    /** Scheduling info */
+    int             SCHED_POLICY;       // One of the SCHED_POLICY_* numbers.
+    double          quantum;            // Time quantum in ms (not used by
+                                        //   SJF).
+    RTCLASS     *   RT;                 // Real-time class, NULL if none.
+    RGSET       *   GROUPS;             // Resource groups, NULL if none.
 
     /** Memory info */
     int             mem_size;           // Total size of memory.
@@ -55,6 +158,24 @@ typedef struct SYSGEN{
 
     frame       *   frame_table;        // Pointer to frame table. 
     frame_list      frame_bag;          // Free frame list. 
+    long            FORK_n;             // Forks.
+    long            COW_COPY_n;         // Shared pages copied on write.
+    long            COW_REUSE_n;        // Written by the last sharer, so
+                                        //   not copied.
+    int             FRAMES_SHARED;      // Mappings beyond the first, over
+                                        //   all frames: frames saved.
+    long            ZERO_FILL_n;        // Pages zero-filled on demand.
+    PT_CONFIG   *   PT;                 // Page table configuration.
+    SHM_SEG     *   SEGMENTS;           // Shared memory segments.
+    SWAP        *   SWAP;               // Swap area, NULL if none.
+    WSET        *   WS;                 // Working set control, NULL if
+                                        //   none.
+
+    /** Snapshot info */
+    double      *   SNAP;               // Aggregates as of the last s or x
+    int             SNAP_n;             //   snapshot, NULL before the
+                                        //   first.
+    TSERIES     *   SERIES;             // Queue time series, NULL if none.
 
 } SYSGEN;
 
@@ -68,7 +189,24 @@ typedef struct SYSGEN{
                 5) Initial burst estimate in milliseconds, t (tau)
                    for all new processes.
                 6) Number of cylinders on each disk. 
-                7) System wide CPU accounting info. */
+                7) System wide CPU accounting info.
+                8) Scheduling policy of the ready queue and its quantum,
+                   the aging of it and the job pool, and the real-time
+                   class above it.
+                9) The simulation clock and its timer wheel.
+               10) Context switch cost model parameters.
+               11) Device service-time model and per-device service 
+                   state.
+               12) I/O rings and their kernel entry costs.
+               13) The disk buffer cache, and the frames it takes out of
+                   memory.
+               14) Readahead windows for disk and flash reads.
+               15) The file system on each disk.
+               16) A volume striped across the disks.
+               17) The swap area and working set control.
+               18) The page table configuration.
+               19) Queue time series.
+               20) Resource groups and their CPU and frame limits. */
 SYSGEN * SYSGEN_new();
 
 /** Recycle all memory in use by the system. */
@@ -7,69 +7,56 @@
 #include <stdlib.h>
 #include "system_calls.h"
 #include "user_input_utilities.h"
-
-
-/** Compute and update a processes' burst average. 
- *  \param  old_avg is the processes' old average.
- *  \param  new_val is the length of the most recently completed burst. 
- *  \param  n is the number of CPU bursts (Should be updated to include 
- *          the most recent CPU burst completed. 
- *  \param  loc is a pointer to where the new burst avg should be stored. */
-static void compute_average(double old_avg, double new_val, 
-                            int n, double * loc)
-{
-    double new_avg = (n-1)*old_avg;
-    new_avg += new_val;
-    new_avg = new_avg / n; 
-    *loc = new_avg;
-}
+#include "dispatcher.h"
 
 
 /** Update a processes' CPU accounting info after is has completed a CPU 
  *  burst. 
- *  \param  sys is a pointer to a SYSGEN object. This function technically 
- *          performs the update while the process is still in the CPU, since
- *          the CPU's PCB pointer of the SYSGEN object is used to update 
- *          the accounting values in the PCB. */
-static void update_accounting(SYSGEN * sys)
+ *  \param  sys is a pointer to a SYSGEN object. The process making the 
+ *          call is the one on the CPU when it is made, before the clock 
+ *          moves; a time slice, a real-time budget or its group's CPU cap 
+ *          may run out on the way and take it off the CPU.
+ *  \return the process making the call, NULL if it was preempted before
+ *          it got to make it. Its burst then carries on once it runs 
+ *          again. */
+static PCB *update_accounting(SYSGEN * sys)
 {
     /** CPU burst complete. Query timer and compute new accounting data. */
+    PCB * pcb = sys->CPU->RUNNING_PROCESS;
     double proc_bt; // process burst time. 
     get_double("CPU process requested syscall. Time query (ms):", &proc_bt);
     
-    /** Add burst time to total CPU time and update value of 
-     *  most recent burst time. */    
-    sys->CPU->RUNNING_PROCESS->CPU_t += proc_bt; 
+    /** Advancing the clock adds the time to the total CPU time and to the
+     *  current burst time of the CPU process. */    
+    advance_clock(sys, proc_bt);
+    if( sys->CPU->RUNNING_PROCESS != pcb ){
+        printf("PID %d was preempted before its system call.\n", pcb->PID);
+printf("------------------------------------------------------------------\n");
+        return NULL;
+    }
+    PCB_ACCT * acct = PCB_acct(pcb);
 
-    /** Update burst time and number of completed burst. */
-    proc_bt += sys->CPU->RUNNING_PROCESS->BURST_t;
-    sys->CPU->RUNNING_PROCESS->BURST_n++; 
-    
-    compute_average(sys->CPU->RUNNING_PROCESS->BURST_avg,
-                    proc_bt,
-                    sys->CPU->RUNNING_PROCESS->BURST_n, 
-                    &sys->CPU->RUNNING_PROCESS->BURST_avg); 
+    /** Record the completed burst. Its prediction error is measured
+     *  against the tau that predicted it, before the update below. */
+    proc_bt = end_burst(sys, pcb);
 
     /** Tau next is computed using an added weight between the system history, 
      *  which is simply the previous value of Tau next, and the most recent 
      *  process burst time. */ 
-    sys->CPU->RUNNING_PROCESS->TAU_n_plus1 
-        =       (sys->a)      * (sys->CPU->RUNNING_PROCESS->TAU_n_plus1) 
-            +   (1 - sys->a)  * (proc_bt); 
+    predict_burst(sys, pcb, proc_bt);
    
     /** Set Tau remaining to new system history value. */ 
-    sys->CPU->RUNNING_PROCESS->TAU_r = sys->CPU->RUNNING_PROCESS->TAU_n_plus1;
-
-    /** Set CPU burst time back to zero. */
-    sys->CPU->RUNNING_PROCESS->BURST_t = 0;
+    pcb->TAU_r = acct->TAU_n_plus1;
+    return pcb;
 }
 
 
 void terminate_process(SYSGEN * sys)
 {
     int deallocated = 0;
+    PCB * pcb = sys->CPU->RUNNING_PROCESS;
     
-    if( sys->CPU->RUNNING_PROCESS != NULL ){
+    if( pcb != NULL ){
       
         /** Process termination is considered as a completion: 
          *  1) Query timer for CPU burst length, update CPU time, 
@@ -83,73 +70,51 @@ void terminate_process(SYSGEN * sys)
         /**   1   */
         double proc_bt; // process burst time. 
         get_double("Terminating CPU process. Time query:", &proc_bt);
-        sys->CPU->RUNNING_PROCESS->CPU_t += proc_bt; 
-        proc_bt += sys->CPU->RUNNING_PROCESS->BURST_t; 
-        sys->CPU->RUNNING_PROCESS->BURST_n++; 
+        advance_clock(sys, proc_bt);
+
+        /** The process may lose the CPU on the way, to an expired time 
+         *  slice, a used up real-time budget or its group's CPU cap; it 
+         *  can't terminate before it runs again. */
+        if( sys->CPU->RUNNING_PROCESS != pcb ){
+            printf("PID %d was preempted before it could terminate.\n",
+                   pcb->PID);
+printf("------------------------------------------------------------------\n");
+            return;
+        }
+        PCB_ACCT * acct = PCB_acct(pcb);
         
         /**   2   */
-        compute_average(sys->CPU->RUNNING_PROCESS->BURST_avg,
-                        proc_bt,
-                        sys->CPU->RUNNING_PROCESS->BURST_n, 
-                        &sys->CPU->RUNNING_PROCESS->BURST_avg); 
+        end_burst(sys, pcb);
 
         /**   4    */
-        sys->CPU_n++;
-        compute_average(sys->CPU_avg,
-                        sys->CPU->RUNNING_PROCESS->CPU_t,
-                        sys->CPU_n, 
-                        &sys->CPU_avg);
+        end_process(sys, pcb);
+        RT_exit(sys, pcb);
+        RG_exit(pcb);
         /**   5   */
         printf("Proc with PID: %d, CPU time: %.3lfms, burst avg: %.3lfms," 
                 " killed.\n",
-                sys->CPU->RUNNING_PROCESS->PID,
-                sys->CPU->RUNNING_PROCESS->CPU_t,
-                sys->CPU->RUNNING_PROCESS->BURST_avg);
+                pcb->PID,
+                acct->CPU_t,
+                acct->BURST.mean);
 
         /**   6   */ 
-        for( int i = 0; i < sys->CPU->RUNNING_PROCESS->num_pages; i++){
-            sys->frame_bag.counter++; 
-            int frame_num = sys->CPU->RUNNING_PROCESS->page_table[i]; 
-            sys->frame_bag.frames[sys->frame_bag.counter] = frame_num; 
-            sys->frame_table[frame_num].PID = -1; 
-            sys->frame_table[frame_num].PAGE_NUM = -1;
-            sys->num_free_frames++;
-        }
+        MEM_unmap(sys, pcb);
 
         /**   Free the process.  */
-        PCB_free(sys->CPU->RUNNING_PROCESS);
-        sys->CPU->RUNNING_PROCESS = NULL;
+        PCB_free(pcb);
+        dispatch(sys, NULL);
         deallocated = 1;
     }
 
     /** The previous process relinquished the frames it was using back to 
-     *  the system, so queue up as many processes from the job pool as 
-     *  possible, largest fit first. */
-    PCB * does_it_blend; 
-    int free_mem = sys->num_free_frames * sys->frame_size; 
-    JOBQ_dequeue(sys->JOB_QUEUE, &does_it_blend, free_mem);
-    while( does_it_blend ){
-        /** Allocate free frames to processes' page table. */
-        for(int i = 0; i < does_it_blend->num_pages; i++){
-            int num = does_it_blend->page_table[i] 
-                    = sys->frame_bag.frames[sys->frame_bag.counter];
-            sys->frame_bag.counter--; 
-            sys->frame_table[num].PID = does_it_blend->PID;
-            sys->num_free_frames--;
-        }
-        /** queue process from job bool onto RQ. */
-        READYQ_enqueue(sys->READY_QUEUE, does_it_blend);
-        
-        /** Update amount of free memory available and search the 
-         *  job pool again. */ 
-        free_mem = sys->num_free_frames * sys->frame_size;
-        JOBQ_dequeue(sys->JOB_QUEUE, &does_it_blend, free_mem); 
-    } 
+     *  the system, so swap in what waits on swap and queue up as many 
+     *  processes from the job pool as possible, largest fit first. */
+    MEM_balance(sys);
 
     /** CPU is NULL, so if the RQ is non-empty dequeue a PCB and place it into
      *  the CPU. */
     if( !READYQ_empty(sys->READY_QUEUE) ){
-        READYQ_dequeue(sys->READY_QUEUE, &sys->CPU->RUNNING_PROCESS);
+        dispatch_next(sys);
     }
 
     /** Error case: If the CPU was not deallocated but the CPU is empty, 
@@ -161,218 +126,323 @@ printf("------------------------------------------------------------------\n");
 }
 
 
-void printer_syscall(SYSGEN * sys, long int num)
+void fork_process(SYSGEN * sys)
 {
-    /** If the CPU is empty, return. */
     if(sys->CPU->RUNNING_PROCESS == NULL){
         printf("CPU is empty.\n");
         return;
     }
 
-    PCB * proc_ptr = sys->CPU->RUNNING_PROCESS;
-    
-    /** Update process accounting info. */
-    update_accounting(sys);
-
-    /** Get file name from user. */
-    char * file_name;
-    get_string("Enter file name", &file_name);
-    
-    /** Get starting location. */
-    int loc; 
-    get_hex("Enter starting location(hex):", &loc);
-    
-    while( loc/sys->frame_size >= proc_ptr->num_pages ){
-        printf("Logical address index exceeds page table bounds. \n");
-        get_hex("Enter starting location(hex):", &loc);
-    }
-    int offset = loc % sys->frame_size; 
-    int base = loc/sys->frame_size; 
-    base = proc_ptr->page_table[base]; 
-    base *= sys->frame_size;
-    loc = base + offset; 
-
-    printf("Physical Address is: %x.\n", loc);
-
-    /** Get read/write char. */
-    char rw; 
-    rw = 'w';
-   
-    /** Get file length. */ 
-    int len; 
-    get_hex("Enter file length(hex):", &len);
-
+    /** The parent ends its burst on the call and carries on running; the
+     *  child shares its frames and waits in the RQ. */
+    PCB * parent = update_accounting(sys);
+    if( parent == NULL )
+        return;
+    PCB * child = MEM_fork(sys, parent);
+    if( child == NULL ){
+        printf("Fork failed: not enough swap space.\n");
 printf("------------------------------------------------------------------\n");
-
-    /** Create PARAMS object. */
-    PARAMS obj = {  .CYLINDER = 0,
-                    .FILE_NAME = file_name, 
-                    .MEM_START = loc,
-                    .READ_WRITE = rw, 
-                    .FILE_LEN= len};
-    
-    /** Create a device node. */
-    D_NODE * ptr = D_NODE_new(sys->CPU->RUNNING_PROCESS, obj);
-
-    /** Move a process from RQ to CPU if available. */
-    if( !READYQ_empty(sys->READY_QUEUE) ){
-        READYQ_dequeue(sys->READY_QUEUE, &sys->CPU->RUNNING_PROCESS);
-    }
-    else{
-        sys->CPU->RUNNING_PROCESS = NULL;
+        return;
     }
-    /** Queue up the D_NODE. */
-    DEVICEQ_enqueue(sys->PRINTERS[num-1], ptr);
+    printf("Proc with PID: %d forked PID: %d, %d page(s) shared.\n",
+            parent->PID,
+            child->PID,
+            PCB_mem(child)->num_pages);
+    READYQ_enqueue(sys->READY_QUEUE, child);
+printf("------------------------------------------------------------------\n");
 }
 
 
-void flashdrive_syscall(SYSGEN * sys, long int num)
+void shm_attach(SYSGEN * sys)
 {
-    /** If the CPU is empty, return. */
     if(sys->CPU->RUNNING_PROCESS == NULL){
         printf("CPU is empty.\n");
         return;
     }
-    PCB * proc_ptr = sys->CPU->RUNNING_PROCESS;
-     
-    /** Update process accounting info. */
-    update_accounting(sys);
 
-    /** Get file name from user. */
-    char * file_name;
-    get_string("Enter file name", &file_name);
-    
-    /** Get starting location. */
+    PCB * proc_ptr = update_accounting(sys);
+    if( proc_ptr == NULL )
+        return;
+    char * name;
+    get_string("Enter segment name", &name);
+
+    /** Only a new segment needs a size. */
+    int size = 0;
+    if( MEM_shm_find(sys, name) == NULL ){
+        get_int("Enter segment size:", &size);
+        while( size < 1 ){
+            printf("Segment size must be positive.\n");
+            get_int("Enter segment size:", &size);
+        }
+    }
+
+    int page = MEM_shm_attach(sys, proc_ptr, name, size);
+    if( page == -2 )
+        printf("Segment %s doesn't fit in the page table.\n", name);
+    else if( page == -3 )
+        printf("Group %d is at its frame quota, no room for segment %s.\n",
+                PCB_acct(proc_ptr)->GROUP->NUM, name);
+    else if( page < 0 )
+        printf("Not enough free frames for segment %s.\n", name);
+    else
+        printf("Proc with PID: %d attached segment %s at %x.\n",
+                proc_ptr->PID, name, page * sys->frame_size);
+    free(name);
+printf("------------------------------------------------------------------\n");
+}
+
+
+/** Ask for a logical starting location in the address space of proc_ptr
+ *  and translate it through its page table.
+ *  \param  logical receives the logical address.
+ *  \return the physical address. */
+static int get_address(SYSGEN * sys, PCB * proc_ptr, int * logical)
+{
     int loc; 
     get_hex("Enter starting location(hex):", &loc);
-    while( loc/sys->frame_size >= proc_ptr->num_pages ){
+    while( loc/sys->frame_size >= PCB_mem(proc_ptr)->num_pages ){
         printf("Logical address index exceeds page table bounds. \n");
         get_hex("Enter starting location(hex):", &loc);
     }
+    *logical = loc;
     int offset = loc % sys->frame_size; 
     int base = loc/sys->frame_size; 
-    base = proc_ptr->page_table[base]; 
+    int pte = PT_get(PCB_mem(proc_ptr)->page_table, base);
+    if( pte == PTE_NONE ){
+        printf("Page %d is not mapped yet.\n", base);
+        return 0;
+    }
+    if( pte & PTE_SWAP ){
+        printf("Page %d is on swap.\n", base);
+        return 0;
+    }
+    base = PTE_FRAME(pte); 
     base *= sys->frame_size;
     loc = base + offset; 
 
     printf("Physical Address is: %x.\n", loc);
+    return loc;
+}
+
+/** Ask for the parameters of one request of proc_ptr on a device of class
+ *  kind. Printers only write, so they don't ask for read/write, and print
+ *  whole files, so they don't ask for an offset. Disk cylinders come from
+ *  the file system, see prep_request().
+ *
+ *  The request references the pages of its buffer, faulting in any that
+ *  are on swap. A read writes the buffer it lands in, so copy-on-write 
+ *  pages under the buffer are broken first.
+ *  \return 1 with the parameters in obj, 0 if the buffer can't be 
+ *          written. */
+static int get_params(SYSGEN * sys, char kind, PCB * proc_ptr, PARAMS * obj)
+{
+    /** Get file name from user. */
+    char * file_name;
+    get_string("Enter file name", &file_name);
     
-    /** Get read/write char. */
+    /** Get starting location. */
+    int logical;
+    int loc = get_address(sys, proc_ptr, &logical);
+
+    /** Get read/write char, file offset and length. */
     int rw;
-    get_rw(&rw); 
-    
-    /** Flush input buffer. */
-    int c;
-    while ( (c = getchar()) != '\n' && c != EOF);
-    
-    /** If write, get file length. */
     int len;
-    if( rw == 'w'){
+    int off = 0;
+    if( kind == DEVICE_PRINTER ){
+        rw = 'w';
+        get_hex("Enter file length(hex):", &len);
+    }
+    else{
+        get_rw(&rw);
+
+        /** Flush input buffer. */
+        int c;
+        while ( (c = getchar()) != '\n' && c != EOF);
+
+        /** Reads and writes both cover a range of the file. */
+        get_hex("Enter file offset(hex):", &off);
         get_hex("Enter file length:", &len); 
     }
-    else
-        len = 0;
-printf("------------------------------------------------------------------\n");
 
-    /** Create PARAMS object. */
-    PARAMS obj = {  .CYLINDER = 0,
-                    .FILE_NAME = strdup(file_name), 
-                    .MEM_START = loc,
-                    .READ_WRITE = rw, 
-                    .FILE_LEN= len};
-    
-    /** Create a D_NODE. */
-    D_NODE * ptr = D_NODE_new(sys->CPU->RUNNING_PROCESS, obj);
+    PCB_MEM * mem = PCB_mem(proc_ptr);
+    int last = (logical + (len > 0 ? len - 1 : 0)) / sys->frame_size;
+    if( last >= mem->num_pages )
+        last = mem->num_pages - 1;
+    if( !MEM_touch(sys, proc_ptr, logical / sys->frame_size, last, 
+                   rw == 'r') ){
+        free(file_name);
+        return 0;
+    }
+    loc =   PTE_FRAME(PT_get(mem->page_table, logical / sys->frame_size))
+          * sys->frame_size + logical % sys->frame_size;
+
+    /** FILE_NAME is handed over to the D_NODE, which frees it. */
+    *obj = (PARAMS){    .CYLINDER = 0,
+                        .FILE_NAME = file_name, 
+                        .MEM_START = loc,
+                        .READ_WRITE = rw, 
+                        .FILE_LEN = len,
+                        .FILE_OFF = off};
+    return 1;
+}
 
-    /** Move a process from RQ to CPU, if available. */
-    if( !READYQ_empty(sys->READY_QUEUE) ){
-        READYQ_dequeue(sys->READY_QUEUE, &sys->CPU->RUNNING_PROCESS);
+/** Ask which device a request in a batch goes to, as p#, d#, f# or v#. */
+static void get_device(SYSGEN * sys, char * kind, long * num)
+{
+    for(;;){
+        char * dev;
+        get_string("Enter device (p#, d#, f# or v#)", &dev);
+        *kind = dev[0];
+        *num = strtol(dev+1, NULL, 10);
+        free(dev);
+
+        int count = *kind == DEVICE_PRINTER ? sys->PRINTER_COUNT
+                  : *kind == DEVICE_DISK    ? sys->DISK_COUNT
+                  : *kind == DEVICE_FLASH   ? sys->FLASHDRIVE_COUNT
+                  : *kind == DEVICE_VOLUME  ? sys->VOL != NULL
+                  :                           0;
+        if( *num >= 1 && *num <= count )
+            return;
+        printf("No such device.\n");
     }
-    else{
-        sys->CPU->RUNNING_PROCESS = NULL;
+}
+
+/** Post a request of proc_ptr on device kind num to the submission ring.
+ *  A disk request is looked up in the disk's file system and split into
+ *  one request per segment, each with its own cylinder. A volume request
+ *  is split over the member disks, see volume.h.
+ *  \param  max is the most submission entries the request may take.
+ *  \return the number of entries posted, 0 if the disk is full. */
+static int prep_request(SYSGEN * sys, char kind, long num, PCB * proc_ptr,
+                        PARAMS obj, int max)
+{
+    if( kind == DEVICE_VOLUME )
+        return VOLUME_prep(sys->VOL, proc_ptr, obj, max);
+    if( kind != DEVICE_DISK ){
+        IO_RING_prep(sys->IO, kind, num, D_NODE_new(proc_ptr, obj));
+        return 1;
     }
 
-    /** Queue up the D_NODE. */
-    DEVICEQ_enqueue(sys->FLASHDRIVES[num-1], ptr);
+    FS_SEG segs[FS_MAX_SEGS];
+    int n = FSYS_map(sys->FILESYS[num-1], obj.FILE_NAME, obj.FILE_OFF,
+                     obj.FILE_LEN, segs, max < FS_MAX_SEGS ? max : FS_MAX_SEGS);
+    if( n < 0 ){
+        printf("Disk d%ld is full.\n", num);
+        free(obj.FILE_NAME);
+        return 0;
+    }
+    for(int i = 0; i < n; i++){
+        PARAMS part = obj;
+        part.CYLINDER = segs[i].CYLINDER;
+        part.FILE_OFF = segs[i].OFF;
+        part.FILE_LEN = segs[i].LEN;
+        if( i > 0 )
+            part.FILE_NAME = strdup(obj.FILE_NAME);
+        IO_RING_prep(sys->IO, kind, num, D_NODE_new(proc_ptr, part));
+    }
+    return n;
 }
 
+/** Submit the requests prepared in the submission ring with a single 
+ *  kernel entry, blocking the CPU process on them and on any page faults,
+ *  and move a process from RQ to CPU if available. The process that just
+ *  blocked may be swapped out for whatever is waiting for memory. 
+ *  The CPU process leaves the CPU before the kernel entry: completions
+ *  reaped during it may hand the CPU to another process, never to the 
+ *  blocked one. */
+static void submit_and_block(SYSGEN * sys)
+{
+    PCB * pcb = sys->CPU->RUNNING_PROCESS;
+    dispatch(sys, NULL);
+    MEM_block(sys, pcb);
+    IO_RING_enter(sys->IO);
+    MEM_balance(sys);
+    if( sys->CPU->RUNNING_PROCESS == NULL )
+        dispatch_next(sys);
+}
 
-void disk_syscall(SYSGEN * sys, long int num)
+/** A single request on device kind num from the CPU process. */
+static void device_syscall(SYSGEN * sys, char kind, long num)
 {
-    /** Return is CPU empty. */
+    /** If the CPU is empty, return. */
     if(sys->CPU->RUNNING_PROCESS == NULL){
         printf("CPU is empty.\n");
         return;
     }
-    PCB * proc_ptr = sys->CPU->RUNNING_PROCESS;
-    
+
     /** Update process accounting info. */
-    update_accounting(sys);
-
-    /** Get cylinder # for syscall. */
-    int cyl;
-    get_int("Enter disk cylinder number ( x >= 1 ):", &cyl);
-    while(    cyl < 1 
-          ||  cyl > sys->CYLINDER_COUNTS[num-1] )
-    {
-        printf("Cylinder out of range.\n");
-        get_int("Enter disk cylinder number ( x >= 1 ):", &cyl);
-    }
-    
-    /** Get file name. */
-    char * file_name;
-    get_string("Enter file name", &file_name);
-    
-    /** Get starting location. */
-    int loc;
-    get_hex("Enter starting location(hex):", &loc);
-    while( loc/sys->frame_size >= proc_ptr->num_pages ){
-        printf("Logical address index exceeds page table bounds. \n");
-        get_hex("Enter starting location(hex):", &loc);
-    }
-    int offset = loc % sys->frame_size; 
-    int base = loc/sys->frame_size; 
-    base = proc_ptr->page_table[base]; 
-    base *= sys->frame_size;
-    loc = base + offset; 
+    PCB * proc_ptr = update_accounting(sys);
+    if( proc_ptr == NULL )
+        return;
 
-    printf("Physical Address is: %x.\n", loc);
-    
-    /** Get read/write char. */
-    int rw;
-    get_rw(&rw);
-    
-    /** Flush input buffer. */
-    int c;
-    while ( (c = getchar()) != '\n' && c != EOF);
-    
-    /** Get file length if write. */
-    int len;
-    if( rw == 'w'){
-        get_hex("Enter file length:", &len);
-    }
-    else
-        len = 0;
+    PARAMS obj;
+    int ok = get_params(sys, kind, proc_ptr, &obj);
 printf("------------------------------------------------------------------\n");
 
-    /** Initialize PARAMS object. */
-    PARAMS obj = {  .CYLINDER = cyl,
-                    .FILE_NAME = strdup(file_name), 
-                    .MEM_START = loc,
-                    .READ_WRITE = rw, 
-                    .FILE_LEN= len};
+    /** Create device nodes and post them to the submission ring. If the 
+     *  request couldn't be placed the process carries on, unless it has
+     *  page faults to wait for. */
+    int posted = ok && prep_request(sys, kind, num, proc_ptr, obj, 
+                                    IO_RING_sq_space(sys->IO));
+    if( posted || PCB_acct(proc_ptr)->IO_PENDING > 0 )
+        submit_and_block(sys);
+}
 
-    /** Create a new D_NODE. */
-    D_NODE * ptr = D_NODE_new(sys->CPU->RUNNING_PROCESS, obj);
+void printer_syscall(SYSGEN * sys, long int num)
+{
+    device_syscall(sys, DEVICE_PRINTER, num);
+}
 
-    /** Move a process from RQ to CPU, if available. */
-    if( !READYQ_empty(sys->READY_QUEUE) ){
-        READYQ_dequeue(sys->READY_QUEUE, &sys->CPU->RUNNING_PROCESS);
+void flashdrive_syscall(SYSGEN * sys, long int num)
+{
+    device_syscall(sys, DEVICE_FLASH, num);
+}
+
+void disk_syscall(SYSGEN * sys, long int num)
+{
+    device_syscall(sys, DEVICE_DISK, num);
+}
+
+void volume_syscall(SYSGEN * sys, long int num)
+{
+    device_syscall(sys, DEVICE_VOLUME, num);
+}
+
+void batch_syscall(SYSGEN * sys)
+{
+    if(sys->CPU->RUNNING_PROCESS == NULL){
+        printf("CPU is empty.\n");
+        return;
     }
-    else{
-        sys->CPU->RUNNING_PROCESS = NULL;
+
+    PCB * proc_ptr = update_accounting(sys);
+    if( proc_ptr == NULL )
+        return;
+
+    /** Get the batch size; it has to fit in the submission ring. */
+    int n;
+    int space = IO_RING_sq_space(sys->IO);
+    get_int("Enter number of I/O requests:", &n);
+    while( n < 1 || n > space ){
+        printf("Batch must hold 1 to %d requests.\n", space);
+        get_int("Enter number of I/O requests:", &n);
     }
-    
-    /** Queue up the D_NODE. */
-    DISKQ_enqueue(sys->DISKS[num-1], ptr);
+
+    /** Each request may take more than one entry, as long as the rest of
+     *  the batch still gets one each. */
+    int posted = 0;
+    for(int i = 0; i < n; i++){
+        char kind;
+        long num;
+        get_device(sys, &kind, &num);
+        PARAMS obj;
+        if( !get_params(sys, kind, proc_ptr, &obj) )
+            continue;
+        posted += prep_request(sys, kind, num, proc_ptr, obj,
+                               IO_RING_sq_space(sys->IO) - (n - i - 1));
+    }
+printf("------------------------------------------------------------------\n");
+
+    if( posted || PCB_acct(proc_ptr)->IO_PENDING > 0 )
+        submit_and_block(sys);
 }
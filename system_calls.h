@@ -12,6 +12,18 @@
  *  \param  sys is a pointer to a SYSGEN object. */
 void terminate_process(SYSGEN * sys);
 
+/** Fork system call. Query the process and update CPU accounting info, 
+ *  then create a child that shares all of its frames copy-on-write. The
+ *  child is queued in the RQ; the parent keeps the CPU.
+ *  \param  sys is a pointer to a SYSGEN object. */
+void fork_process(SYSGEN * sys);
+
+/** Shared memory system call. Query the process and update CPU accounting
+ *  info, then attach a named shared memory segment to the end of its 
+ *  address space, creating the segment if it doesn't exist yet.
+ *  \param  sys is a pointer to a SYSGEN object. */
+void shm_attach(SYSGEN * sys);
+
 /** Printer system call. Query the process and update CPU accounting info, 
  *  request info about the syscall, then queue the process onto the 
  *  appropriate printer device queue. 
@@ -33,4 +45,18 @@ void flashdrive_syscall(SYSGEN * sys, long int num);
  *  \param  num is the disk device queue being requested. */
 void disk_syscall(SYSGEN * sys, long int num);
 
+/** Volume system call. Query the process and update CPU accounting info, 
+ *  request info about the syscall, then split the request over the disks
+ *  of the volume. The process is blocked until every part has completed.
+ *  \param  sys is a pointer to a SYSGEN object. 
+ *  \param  num is the volume being requested; there is only v1. */
+void volume_syscall(SYSGEN * sys, long int num);
+
+/** Batched I/O system call. Query the process and update CPU accounting 
+ *  info, then ask for several requests, each on any device, and submit 
+ *  them all with one kernel entry. The process is blocked until every one
+ *  of them has completed.
+ *  \param  sys is a pointer to a SYSGEN object. */
+void batch_syscall(SYSGEN * sys);
+
 #endif
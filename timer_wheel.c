@@ -0,0 +1,209 @@
+/** \file
+ *  timer_wheel.c:  Implementation of the hierarchical timer wheel. */
+
+#include <stdlib.h>
+#include "timer_wheel.h"
+
+/** Largest delta representable by the top level. */
+#define TW_SPAN ( (uint64_t)1 << (TW_BITS * TW_LEVELS) )
+
+TWHEEL *TWHEEL_new()
+{
+    TWHEEL * tw = malloc( sizeof(TWHEEL) );
+    for(int l = 0; l < TW_LEVELS; l++){
+        for(int s = 0; s < TW_SLOTS; s++)
+            tw->slots[l][s] = NULL;
+        tw->occupied[l] = 0;
+    }
+    tw->now = 0;
+    tw->armed = 0;
+    return tw;
+}
+
+void TIMER_init(TIMER * timer, TIMER_FN fn, void * arg)
+{
+    *timer = (TIMER){   .next = NULL,
+                        .pprev = NULL,
+                        .expires = 0,
+                        .level = 0,
+                        .slot = 0,
+                        .fn = fn,
+                        .arg = arg};
+}
+
+int TIMER_armed(TIMER * timer)
+{
+    return timer->pprev != NULL;
+}
+
+/** Hash a timer into its slot relative to the current tick. */
+static void link_timer(TWHEEL * tw, TIMER * timer)
+{
+    uint64_t expires = timer->expires;
+    if( expires < tw->now )
+        expires = tw->now;
+    /** Timers further out than the wheel spans park in the top level and
+     *  get re-hashed each time that slot cascades. */
+    if( expires - tw->now >= TW_SPAN )
+        expires = tw->now + TW_SPAN - 1;
+
+    uint64_t delta = expires - tw->now;
+    int level = 0;
+    while( level < TW_LEVELS - 1
+        && delta >= ((uint64_t)1 << (TW_BITS * (level + 1))) )
+        level++;
+    int slot = (expires >> (TW_BITS * level)) & TW_MASK;
+
+    TIMER ** head = &tw->slots[level][slot];
+    timer->next = *head;
+    if( *head )
+        (*head)->pprev = &timer->next;
+    *head = timer;
+    timer->pprev = head;
+    timer->level = level;
+    timer->slot = slot;
+    tw->occupied[level] |= (uint64_t)1 << slot;
+}
+
+static void unlink_timer(TWHEEL * tw, TIMER * timer)
+{
+    *timer->pprev = timer->next;
+    if( timer->next )
+        timer->next->pprev = timer->pprev;
+    if( tw->slots[timer->level][timer->slot] == NULL )
+        tw->occupied[timer->level] &= ~((uint64_t)1 << timer->slot);
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+void TWHEEL_arm(TWHEEL * tw, TIMER * timer, uint64_t expires)
+{
+    if( TIMER_armed(timer) )
+        unlink_timer(tw, timer);
+    else
+        tw->armed++;
+    timer->expires = expires;
+    link_timer(tw, timer);
+}
+
+void TWHEEL_cancel(TWHEEL * tw, TIMER * timer)
+{
+    if( !TIMER_armed(timer) )
+        return;
+    unlink_timer(tw, timer);
+    tw->armed--;
+}
+
+/** Detach the list of a slot, clearing its occupancy bit. */
+static TIMER *take_slot(TWHEEL * tw, int level, int slot)
+{
+    TIMER * list = tw->slots[level][slot];
+    tw->slots[level][slot] = NULL;
+    tw->occupied[level] &= ~((uint64_t)1 << slot);
+    return list;
+}
+
+/** Re-hash the timers of one upper level slot; they all land lower. */
+static void cascade(TWHEEL * tw, int level, int slot)
+{
+    TIMER * list = take_slot(tw, level, slot);
+    while( list ){
+        TIMER * timer = list;
+        list = list->next;
+        link_timer(tw, timer);
+    }
+}
+
+/** Called whenever the level 0 index is 0: pull the next block of each
+ *  level down, going up as long as the lower level wrapped around too. */
+static void cascade_all(TWHEEL * tw)
+{
+    for(int l = 1; l < TW_LEVELS; l++){
+        int idx = (tw->now >> (TW_BITS * l)) & TW_MASK;
+        cascade(tw, l, idx);
+        if( idx != 0 )
+            break;
+    }
+}
+
+/** Given that level 0 is entirely empty and next is a level 0 block
+ *  boundary, skip ahead to the first boundary at which cascade_all() has
+ *  something to pull down. A level l slot is pulled down at the level l
+ *  boundary its index comes up at, so for each level the first occupied
+ *  slot from there on, counting around the wheel, gives the earliest
+ *  boundary it needs; the soonest of those wins. Empty slots at every
+ *  level are skipped with one bit scan each.
+ *  \return that boundary, or UINT64_MAX if no timer is armed. */
+static uint64_t skip_empty_blocks(TWHEEL * tw, uint64_t next)
+{
+    uint64_t best = UINT64_MAX;
+    for(int l = 1; l < TW_LEVELS; l++){
+        if( tw->occupied[l] == 0 )
+            continue;
+        int shift = TW_BITS * l;
+        uint64_t span = (uint64_t)1 << shift;
+        uint64_t first = (next + span - 1) & ~(span - 1);
+        int idx = (first >> shift) & TW_MASK;
+        uint64_t bits = tw->occupied[l];
+        uint64_t ahead = idx ? (bits >> idx) | (bits << (TW_SLOTS - idx))
+                             : bits;
+        uint64_t at = first + ((uint64_t)__builtin_ctzll(ahead) << shift);
+        if( at < best )
+            best = at;
+    }
+    return best;
+}
+
+void TWHEEL_advance(TWHEEL * tw, uint64_t target,
+                    void (*before)(uint64_t tick, void * arg), void * arg)
+{
+    while( tw->now <= target ){
+        int idx = tw->now & TW_MASK;
+        if( idx == 0 )
+            cascade_all(tw);
+
+        uint64_t pending = tw->occupied[0] >> idx;
+        if( pending == 0 ){
+            /** Nothing left in this rotation, go to the next boundary. */
+            uint64_t next = (tw->now | TW_MASK) + 1;
+            if( tw->occupied[0] == 0 )
+                next = skip_empty_blocks(tw, next);
+            if( next > target ){
+                tw->now = target + 1;
+                return;
+            }
+            tw->now = next;
+            continue;
+        }
+
+        uint64_t tick = tw->now + __builtin_ctzll(pending);
+        if( tick > target ){
+            tw->now = target + 1;
+            return;
+        }
+
+        /** The batch stays linked, now off a local head, so a callback can
+         *  still cancel or re-arm a timer due later in it. */
+        TIMER * list = take_slot(tw, 0, tick & TW_MASK);
+        if( list )
+            list->pprev = &list;
+        tw->now = tick + 1;
+        if( before )
+            before(tick, arg);
+        while( list ){
+            TIMER * timer = list;
+            list = list->next;
+            if( list )
+                list->pprev = &list;
+            timer->next = NULL;
+            timer->pprev = NULL;
+            tw->armed--;
+            timer->fn(timer);
+        }
+    }
+}
+
+void TWHEEL_free(TWHEEL * tw)
+{
+    free(tw);
+}
@@ -0,0 +1,91 @@
+/** \file
+ *  timer_wheel.h:  Interface for a hierarchical timer wheel (TWHEEL).
+ *
+ *                  Time is counted in integer ticks. The wheel has
+ *                  TW_LEVELS levels of TW_SLOTS slots each; level l covers
+ *                  timers expiring within TW_SLOTS^(l+1) ticks of the
+ *                  current tick. A timer is hashed straight into its slot
+ *                  when armed, and each slot is a doubly linked list, so
+ *                  both arming and cancelling are O(1) no matter how many
+ *                  timers are outstanding. When the level 0 index wraps
+ *                  around, the matching slot of the level above is cascaded
+ *                  down, and so on up the levels.
+ *
+ *                  Advancing skips over empty stretches using a per-level
+ *                  occupancy bitmap: once level 0 is empty, one bit scan
+ *                  per level finds the next slot, at any level, that has
+ *                  to be cascaded. Jumping the clock forward by a large
+ *                  amount only costs time proportional to the number of
+ *                  slots that actually hold timers.
+ *
+ *                  TIMER objects are owned by the caller (typically
+ *                  embedded in some other struct); the wheel only links
+ *                  them. */
+
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+#include <stdint.h>
+
+#define TW_BITS     6
+#define TW_SLOTS    (1 << TW_BITS)
+#define TW_MASK     (TW_SLOTS - 1)
+#define TW_LEVELS   6
+
+/** Ticks per millisecond of simulated time. */
+#define TW_TICKS_PER_MS 1000
+
+struct TIMER;
+
+/** Expiry callback. The timer is already disarmed when this is called, so
+ *  it may be re-armed from inside the callback. */
+typedef void (*TIMER_FN)(struct TIMER * timer);
+
+/** TIMER struct. */
+typedef struct TIMER {
+    struct TIMER    *   next;       // Next timer in the slot.
+    struct TIMER    **  pprev;      // Link pointing at this timer, NULL
+                                    // when the timer is not armed.
+    uint64_t            expires;    // Expiry tick.
+    int                 level;      // Wheel position while armed.
+    int                 slot;
+    TIMER_FN            fn;         // Expiry callback.
+    void            *   arg;        // Callback argument.
+} TIMER;
+
+/** TWHEEL struct. */
+typedef struct TWHEEL {
+    TIMER   *   slots[TW_LEVELS][TW_SLOTS];
+    uint64_t    occupied[TW_LEVELS];    // Bit s set if slot s is non-empty.
+    uint64_t    now;                    // Next tick to be processed.
+    long        armed;                  // Number of armed timers.
+} TWHEEL;
+
+/** Generate and return an empty TWHEEL at tick 0. */
+TWHEEL *TWHEEL_new();
+
+/** Initialize a caller owned TIMER. */
+void TIMER_init(TIMER * timer, TIMER_FN fn, void * arg);
+
+/** \return 1 if the timer is armed. */
+int TIMER_armed(TIMER * timer);
+
+/** Arm a timer for the given expiry tick, re-arming it if it was already
+ *  armed. Ticks in the past expire on the next tick processed. */
+void TWHEEL_arm(TWHEEL * tw, TIMER * timer, uint64_t expires);
+
+/** Disarm a timer. No-op if it is not armed. */
+void TWHEEL_cancel(TWHEEL * tw, TIMER * timer);
+
+/** Run every timer expiring at or before tick target, in expiry order.
+ *  \param  before is called with the expiry tick ahead of each batch of
+ *          callbacks, so the caller can bring its own clock forward;
+ *          may be NULL.
+ *  \param  arg is passed to before. */
+void TWHEEL_advance(TWHEEL * tw, uint64_t target,
+                    void (*before)(uint64_t tick, void * arg), void * arg);
+
+/** Free the TWHEEL. Armed timers are simply dropped. */
+void TWHEEL_free(TWHEEL * tw);
+
+#endif
@@ -0,0 +1,172 @@
+/** \file
+ *  volume.c:   Implementation for the striped logical volume. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "volume.h"
+#include "sysgen.h"
+
+VOLUME *VOLUME_new(SYSGEN * sys, int layout, int stripe, int blocks_per_cyl,
+                   unsigned int extent_limit)
+{
+    VOLUME * vol = calloc( 1, sizeof(VOLUME) );
+    vol->sys = sys;
+    vol->layout = layout;
+    vol->members = sys->DISK_COUNT;
+    vol->width = layout == VOL_RAID10 ? vol->members / 2 : vol->members;
+    vol->stripe = stripe;
+    vol->block_size = sys->frame_size;
+    vol->blocks_per_cyl = blocks_per_cyl;
+
+    int cylinders = sys->CYLINDER_COUNTS[0];
+    for(int i = 1; i < sys->DISK_COUNT; i++)
+        if( sys->CYLINDER_COUNTS[i] < cylinders )
+            cylinders = sys->CYLINDER_COUNTS[i];
+    vol->fs = FSYS_new(cylinders, blocks_per_cyl * vol->width,
+                       vol->block_size, extent_limit);
+    return vol;
+}
+
+const char *VOLUME_layout_name(int layout)
+{
+    return layout == VOL_RAID10 ? "RAID-10" : "RAID-0";
+}
+
+/** One disk request of a volume request. */
+typedef struct VOL_PIECE {
+    int                 DISK;           // Member, counting from 0.
+    int                 CYLINDER;
+    unsigned int        OFF;            // File range.
+    unsigned int        LEN;
+} VOL_PIECE;
+
+/** \return the RAID-10 copy, disk a or b, a read on cylinder cyl goes to.
+ *  \param  sent counts the pieces already sent to each disk. */
+static int pick_copy(VOLUME * vol, int a, int b, int cyl, int * sent)
+{
+    SYSGEN * sys = vol->sys;
+    DEVICE * da = DEVICE_lookup(sys, DEVICE_DISK, a+1);
+    DEVICE * db = DEVICE_lookup(sys, DEVICE_DISK, b+1);
+    int load_a = da->DEPTH + sent[a];
+    int load_b = db->DEPTH + sent[b];
+    if( load_a != load_b )
+        return load_a < load_b ? a : b;
+    return abs(db->HEAD_CYL - cyl) < abs(da->HEAD_CYL - cyl) ? b : a;
+}
+
+int VOLUME_prep(VOLUME * vol, PCB * pcb, PARAMS obj, int max)
+{
+    SYSGEN * sys = vol->sys;
+    FS_SEG segs[FS_MAX_SEGS];
+    int n = FSYS_map(vol->fs, obj.FILE_NAME, obj.FILE_OFF, obj.FILE_LEN,
+                     segs, FS_MAX_SEGS);
+    if( n < 0 ){
+        printf("Volume v1 is full.\n");
+        free(obj.FILE_NAME);
+        return 0;
+    }
+
+    unsigned int unit = vol->stripe * vol->block_size;
+    unsigned int cyl_bytes = vol->blocks_per_cyl * vol->block_size;
+    VOL_PIECE * pieces = malloc( sizeof(VOL_PIECE) * (max > 0 ? max : 1) );
+    int * sent = calloc( vol->members, sizeof(int) );
+    int count = 0;
+
+    /** Walk each segment's volume addresses unit by unit. */
+    for(int i = 0; i < n; i++){
+        unsigned int va =   segs[i].PBLK * vol->block_size
+                          + segs[i].OFF % vol->block_size;
+        unsigned int foff = segs[i].OFF;
+        unsigned int rem = segs[i].LEN;
+        do{
+            unsigned int u = va / unit;
+            unsigned int within = va % unit;
+            unsigned int addr = (u / vol->width) * unit + within;
+            unsigned int len = unit - within;
+            if( len > cyl_bytes - addr % cyl_bytes )
+                len = cyl_bytes - addr % cyl_bytes;
+            if( len > rem )
+                len = rem;
+            int col = u % vol->width;
+            int cyl = addr / cyl_bytes + 1;
+
+            int disks[2];
+            int copies = 1;
+            if( vol->layout == VOL_RAID0 )
+                disks[0] = col;
+            else if( obj.READ_WRITE == 'w' ){
+                disks[0] = 2 * col;
+                disks[1] = 2 * col + 1;
+                copies = 2;
+            }
+            else{
+                disks[0] = pick_copy(vol, 2 * col, 2 * col + 1, cyl, sent);
+                vol->READ_n++;
+                if( disks[0] == 2 * col + 1 )
+                    vol->SECOND_n++;
+            }
+
+            for(int c = 0; c < copies; c++){
+                if( count == max ){
+                    printf("Request needs more than %d ring entries.\n", max);
+                    free(pieces);
+                    free(sent);
+                    free(obj.FILE_NAME);
+                    return 0;
+                }
+                pieces[count++] = (VOL_PIECE){ .DISK = disks[c],
+                                               .CYLINDER = cyl,
+                                               .OFF = foff,
+                                               .LEN = len };
+                sent[disks[c]]++;
+            }
+            va += len;
+            foff += len;
+            rem -= len;
+        } while( rem > 0 );
+    }
+
+    /** The first disk request takes over the file name. */
+    for(int i = 0; i < count; i++){
+        PARAMS part = obj;
+        part.CYLINDER = pieces[i].CYLINDER;
+        part.FILE_OFF = pieces[i].OFF;
+        part.FILE_LEN = pieces[i].LEN;
+        if( i > 0 )
+            part.FILE_NAME = strdup(obj.FILE_NAME);
+        D_NODE * req = D_NODE_new(pcb, part);
+        req->VOL = 1;
+        IO_RING_prep(sys->IO, DEVICE_DISK, pieces[i].DISK + 1, req);
+    }
+    vol->REQ_n++;
+    vol->SUB_n += count;
+    vol->BYTES += obj.FILE_LEN;
+    free(pieces);
+    free(sent);
+    return count;
+}
+
+void VOLUME_reserve(VOLUME * vol, int disk, unsigned int first,
+                    unsigned int count)
+{
+    /** Member block b is block b % stripe of unit b / stripe of its
+     *  column; that unit is unit (b / stripe) * width + column of the
+     *  volume. On RAID-10 both disks of a pair hold the column. */
+    FSYS * fs = vol->fs;
+    int col = vol->layout == VOL_RAID10 ? (disk-1) / 2 : disk-1;
+    for(unsigned int b = first; b < first + count; b++){
+        unsigned int u = (b / vol->stripe) * vol->width + col;
+        unsigned int vb = u * vol->stripe + b % vol->stripe;
+        if( vb < fs->total && !fs->used[vb] ){
+            fs->used[vb] = 1;
+            fs->USED_n++;
+        }
+    }
+}
+
+void VOLUME_free(VOLUME * vol)
+{
+    FSYS_free(vol->fs);
+    free(vol);
+}
@@ -0,0 +1,90 @@
+/** \file
+ *  volume.h:   Interface for the logical volume (VOLUME) striped across
+ *              the disks.
+ *
+ *              The volume has its own file system. Its blocks are dealt out
+ *              to the member disks in stripe units: unit u of the volume is
+ *              unit u / width on member u % width, where width is the
+ *              number of data columns. RAID-0 has one column per disk.
+ *              RAID-10 pairs the disks up, (d1, d2), (d3, d4) and so on,
+ *              and keeps a copy of each column on both disks of its pair.
+ *
+ *              A volume request is split into one disk request per stripe
+ *              unit it touches, cut short where a unit crosses a cylinder
+ *              of its member. Writes to a RAID-10 volume go to both copies.
+ *              Reads go to whichever copy has fewer requests outstanding,
+ *              counting the ones the same request has already sent there;
+ *              on a tie, to the one whose arm is closer. Disk requests keep
+ *              the file range they cover, but that range is in the
+ *              volume's file system, so they bypass the buffer cache and
+ *              readahead of the member disk. The process stays blocked
+ *              until all of them have completed.
+ *
+ *              The members belong to the volume: requests made straight to
+ *              a member disk use that disk's own file system and don't know
+ *              about the volume's blocks. */
+
+#ifndef VOLUME_H_
+#define VOLUME_H_
+
+#include "device_node.h"
+#include "filesys.h"
+
+/** Command letter of the volume. The volume is not a DEVICE; its requests
+ *  are served by the member disks. */
+#define DEVICE_VOLUME   'v'
+
+/** Layouts */
+#define VOL_NONE        0
+#define VOL_RAID0       1
+#define VOL_RAID10      2
+
+struct SYSGEN;
+
+/** VOLUME struct. */
+typedef struct VOLUME {
+    struct SYSGEN   *   sys;
+    int                 layout;         // VOL_RAID0 or VOL_RAID10.
+    int                 members;        // Member disks: all of them.
+    int                 width;          // Data columns.
+    int                 stripe;         // Stripe unit in blocks.
+    int                 block_size;     // Bytes per block.
+    int                 blocks_per_cyl; // Blocks per member cylinder.
+    FSYS            *   fs;             // Volume's own file system.
+
+    /** Statistics */
+    long                REQ_n;          // Volume requests.
+    long                SUB_n;          // Disk requests they became.
+    long                READ_n;         // Disk reads on a RAID-10 volume.
+    long                SECOND_n;       //   Sent to the second copy.
+    double              BYTES;          // Bytes requested.
+} VOLUME;
+
+/** Generate and return a VOLUME over all disks of sys.
+ *  \param  layout is VOL_RAID0 or VOL_RAID10, which needs an even number of
+ *          disks.
+ *  \param  stripe is the stripe unit in blocks.
+ *  \param  blocks_per_cyl and extent_limit are as for the disks' own file
+ *          systems. The volume is as deep as the shallowest member. */
+VOLUME *VOLUME_new(struct SYSGEN * sys, int layout, int stripe,
+                   int blocks_per_cyl, unsigned int extent_limit);
+
+/** Split a volume request of pcb into disk requests and post them to the
+ *  submission ring. Takes over obj.FILE_NAME.
+ *  \param  max is the most submission entries the request may take.
+ *  \return the number of entries posted, 0 if the request didn't fit the
+ *          volume or the ring. */
+int VOLUME_prep(VOLUME * vol, PCB * pcb, PARAMS obj, int max);
+
+/** Keep the volume's file system off count blocks of member disk, from
+ *  block first of the disk on, like the swap area. */
+void VOLUME_reserve(VOLUME * vol, int disk, unsigned int first,
+                    unsigned int count);
+
+/** \return the name of a layout. */
+const char *VOLUME_layout_name(int layout);
+
+/** Free the VOLUME and its file system. */
+void VOLUME_free(VOLUME * vol);
+
+#endif